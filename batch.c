@@ -0,0 +1,396 @@
+/*!
+ * @file
+ * @brief batch mode - dumps many files by worker threads.
+ * @author yukio
+ *
+ * Jobs are dealt to the deque of each worker, and a worker that runs out
+ * of its jobs steals from the other deques, so that a few huge files
+ * don't stall the other workers.
+ * Each worker has its own memory_t, file_t and stats_t of --stats, which
+ * are added up after the workers end. The options including
+ * verbose_level are set before workers start, and only read by them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "verbose.h"
+#include "bldump.h"
+
+/*** TEST ***/
+#ifdef TEST
+#define STDOUT	t_stdout
+#else
+#define STDOUT	stdout
+#endif
+
+#define BATCH_SUFFIX ".dump" /*!< outfile suffix of infiles in a directory. */
+
+/*** batch_job_t ***/
+typedef struct {
+	char*  infile_name;  /*!< infile name. */
+	char*  outfile_name; /*!< outfile name. */
+	bool   is_ok;        /*!< result. */
+	size_t length;       /*!< infile length. */
+} batch_job_t;
+
+/*** batch_deque_t ***/
+typedef struct {
+	pthread_mutex_t lock; /*!< lock of top and bottom. */
+	int* jobs;            /*!< index of jobs. */
+	int  top;             /*!< thieves take jobs[top]. */
+	int  bottom;          /*!< owner takes jobs[bottom-1]. */
+} batch_deque_t;
+
+/*** batch_t ***/
+typedef struct {
+	batch_job_t*     jobs;     /*!< all jobs. */
+	int              njobs;    /*!< number of jobs. */
+	batch_deque_t*   deques;   /*!< deque of each worker. */
+	int              nworkers; /*!< number of workers. */
+	const options_t* opt;      /*!< shared options, read only. */
+} batch_t;
+
+/*** batch_worker_t ***/
+typedef struct {
+	batch_t* batch; /*!< batch. */
+	int      id;    /*!< worker id. */
+	stats_t  stats; /*!< --stats : counters of the worker. */
+} batch_worker_t;
+
+/*!
+ * @brief add a job.
+ */
+static bool batch_add( batch_t* batch, int* capacity, const char* infile_name, const char* outfile_name )
+{
+	batch_job_t* job;
+
+	if ( batch->njobs >= *capacity ) {
+		int n = (*capacity == 0) ? 64 : *capacity * 2;
+		batch_job_t* jobs = (batch_job_t*)realloc( batch->jobs, sizeof(batch_job_t) * (size_t)n );
+		if ( jobs == NULL ) {
+			return false;
+		}
+		batch->jobs = jobs;
+		*capacity   = n;
+	}
+
+	job = &batch->jobs[batch->njobs];
+	memset( job, 0, sizeof(batch_job_t) );
+	job->infile_name = strclone( infile_name );
+	if ( outfile_name != NULL ) {
+		job->outfile_name = strclone( outfile_name );
+	} else {
+		job->outfile_name = (char*)malloc( strlen( infile_name ) + sizeof(BATCH_SUFFIX) );
+		if ( job->outfile_name != NULL ) {
+			(void)sprintf( job->outfile_name, "%s%s", infile_name, BATCH_SUFFIX );
+		}
+	}
+	if ( job->infile_name == NULL || job->outfile_name == NULL ) {
+		free( job->infile_name );
+		free( job->outfile_name );
+		return false;
+	}
+	batch->njobs++;
+	return true;
+}
+
+static int batch_compare( const void* a, const void* b )
+{
+	return strcmp( ((const batch_job_t*)a)->infile_name, ((const batch_job_t*)b)->infile_name );
+}
+
+/*!
+ * @brief load jobs from a list file or a directory.
+ * @param[out] batch
+ * @param[in] name list file name or directory name.
+ * @retval true success.
+ * @retval false failure.
+ */
+static bool batch_load( batch_t* batch, const char* name )
+{
+	struct stat st;
+	int capacity = 0;
+	bool is = true;
+
+	if ( stat( name, &st ) != 0 ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't open batch list - %s\n", name );
+		return false;
+	}
+
+	if ( S_ISDIR( st.st_mode ) ) {
+		DIR* dir = opendir( name );
+		struct dirent* ent;
+		char* path;
+		size_t suffix = strlen( BATCH_SUFFIX );
+
+		if ( dir == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't open batch directory - %s\n", name );
+			return false;
+		}
+		while ( (ent = readdir( dir )) != NULL ) {
+			size_t len = strlen( ent->d_name );
+			if ( len >= suffix && strcmp( &ent->d_name[len - suffix], BATCH_SUFFIX ) == 0 ) {
+				continue; /* outfile of previous batch */
+			}
+			path = (char*)malloc( strlen( name ) + len + 2 );
+			if ( path == NULL ) {
+				is = false;
+				break;
+			}
+			(void)sprintf( path, "%s/%s", name, ent->d_name );
+			if ( stat( path, &st ) == 0 && S_ISREG( st.st_mode ) ) {
+				is = batch_add( batch, &capacity, path, NULL );
+			}
+			free( path );
+			if ( is == false ) {
+				break;
+			}
+		}
+		(void)closedir( dir );
+		qsort( batch->jobs, (size_t)batch->njobs, sizeof(batch_job_t), batch_compare );
+	} else {
+		FILE* fp = fopen( name, "rt" );
+		char line[4096];
+
+		if ( fp == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't open batch list - %s\n", name );
+			return false;
+		}
+		while ( fgets( line, (int)sizeof(line), fp ) != NULL ) {
+			char* infile_name  = strtok( line, " \t\r\n" );
+			char* outfile_name = strtok( NULL, " \t\r\n" );
+			if ( infile_name == NULL || infile_name[0] == '#' ) {
+				continue;
+			}
+			is = batch_add( batch, &capacity, infile_name, outfile_name );
+			if ( is == false ) {
+				break;
+			}
+		}
+		(void)fclose( fp );
+	}
+
+	if ( is == false ) {
+		int i;
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		for ( i = 0; i < batch->njobs; i++ ) {
+			free( batch->jobs[i].infile_name );
+			free( batch->jobs[i].outfile_name );
+		}
+		free( batch->jobs );
+		batch->jobs  = NULL;
+		batch->njobs = 0;
+		return false;
+	}
+	(void)verbose_printf( VERB_DEBUG, "bldump: batch jobs=%d\n", batch->njobs );
+	return true;
+}
+
+/*!
+ * @brief dump a file of the job.
+ * @param[in,out] stats counters of the worker, used only with --stats.
+ */
+static void batch_run( batch_job_t* job, const options_t* base, stats_t* stats )
+{
+	options_t opt = *base; /* shares the parsed options */
+	memory_t  memory;
+	file_t    infile;
+	file_t    outfile;
+
+	opt.infile_name  = job->infile_name;
+	opt.outfile_name = job->outfile_name;
+	opt.stats        = (base->stats != NULL) ? stats : NULL; /* not shared by workers */
+
+	memory_init( &memory );
+	file_reset( &infile );
+	file_reset( &outfile );
+
+	job->is_ok = bldump_setup( &memory, &infile, &outfile, &opt );
+	if ( job->is_ok == true && opt.stats != NULL ) {
+		job->is_ok = stats_attach( opt.stats, &outfile, bldump_record_size( &opt ) );
+	}
+	if ( job->is_ok == true ) {
+		job->is_ok  = bldump_dump( &memory, &infile, &outfile, &opt );
+		job->length = infile.length;
+	}
+	if ( opt.stats != NULL ) {
+		stats_detach( opt.stats, &outfile );
+	}
+
+	(void)file_close( &infile );
+	(void)file_close( &outfile );
+	if ( memory.data != NULL ) {
+		(void)memory_free( &memory );
+	}
+}
+
+/*!
+ * @brief take a job from the bottom of own deque.
+ * @return index of the job, or -1 if empty.
+ */
+static int batch_pop( batch_deque_t* deque )
+{
+	int index = -1;
+	(void)pthread_mutex_lock( &deque->lock );
+	if ( deque->bottom > deque->top ) {
+		index = deque->jobs[--deque->bottom];
+	}
+	(void)pthread_mutex_unlock( &deque->lock );
+	return index;
+}
+
+/*!
+ * @brief steal a job from the top of other deques.
+ * @return index of the job, or -1 if all deques are empty.
+ */
+static int batch_steal( batch_t* batch, int id )
+{
+	int i;
+	for ( i = 1; i < batch->nworkers; i++ ) {
+		batch_deque_t* deque = &batch->deques[(id + i) % batch->nworkers];
+		int index = -1;
+		(void)pthread_mutex_lock( &deque->lock );
+		if ( deque->bottom > deque->top ) {
+			index = deque->jobs[deque->top++];
+		}
+		(void)pthread_mutex_unlock( &deque->lock );
+		if ( index >= 0 ) {
+			return index;
+		}
+	}
+	return -1;
+}
+
+static void* batch_worker( void* arg )
+{
+	batch_worker_t* worker = (batch_worker_t*)arg;
+	batch_t* batch = worker->batch;
+	int index;
+
+	/* no job is added while running, so all deques are empty at the end */
+	while ( (index = batch_pop( &batch->deques[worker->id] )) >= 0
+		|| (index = batch_steal( batch, worker->id )) >= 0 ) {
+		batch_run( &batch->jobs[index], batch->opt, &worker->stats );
+	}
+	return NULL;
+}
+
+/*!
+ * @brief dump files of --batch by worker threads.
+ * @param[in] opt options, opt->batch_name is list file or directory.
+ * @retval true all files are dumped.
+ * @retval false failure.
+ */
+bool bldump_batch( options_t* opt )
+{
+	batch_t batch;
+	batch_worker_t* workers = NULL;
+	pthread_t* threads = NULL;
+	bool is_ok = true;
+	int i, failed = 0, ndeques = 0;
+
+	memset( &batch, 0, sizeof(batch) );
+	batch.opt = opt;
+
+	if ( batch_load( &batch, opt->batch_name ) == false ) {
+		return false;
+	}
+
+	/*** workers ***/
+	batch.nworkers = opt->jobs;
+	if ( batch.nworkers <= 0 ) {
+		long n = sysconf( _SC_NPROCESSORS_ONLN );
+		batch.nworkers = (n > 0) ? (int)n : 1;
+	}
+	if ( batch.nworkers > batch.njobs ) {
+		batch.nworkers = (batch.njobs > 0) ? batch.njobs : 1;
+	}
+	batch.deques = (batch_deque_t*)calloc( (size_t)batch.nworkers, sizeof(batch_deque_t) );
+	workers      = (batch_worker_t*)calloc( (size_t)batch.nworkers, sizeof(batch_worker_t) );
+	threads      = (pthread_t*)calloc( (size_t)batch.nworkers, sizeof(pthread_t) );
+	if ( batch.deques == NULL || workers == NULL || threads == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		is_ok = false;
+	}
+
+	/*** deal jobs ***/
+	for ( i = 0; is_ok == true && i < batch.nworkers; i++ ) {
+		batch_deque_t* deque = &batch.deques[i];
+		int j;
+		deque->jobs = (int*)malloc( sizeof(int) * (size_t)(batch.njobs / batch.nworkers + 1) );
+		if ( deque->jobs == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+			is_ok = false;
+			break;
+		}
+		if ( pthread_mutex_init( &deque->lock, NULL ) != 0 ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't init lock of batch\n" );
+			free( deque->jobs );
+			deque->jobs = NULL;
+			is_ok = false;
+			break;
+		}
+		ndeques++;
+		for ( j = i; j < batch.njobs; j += batch.nworkers ) {
+			deque->jobs[deque->bottom++] = j;
+		}
+		workers[i].batch = &batch;
+		workers[i].id    = i;
+	}
+
+	/*** run ***/
+	if ( is_ok == true ) {
+		for ( i = 1; i < batch.nworkers; i++ ) {
+			if ( pthread_create( &threads[i], NULL, batch_worker, &workers[i] ) != 0 ) {
+				threads[i] = threads[0]; /* not created, the others steal its jobs */
+				workers[i].batch = NULL;
+			}
+		}
+		(void)batch_worker( &workers[0] );
+		for ( i = 1; i < batch.nworkers; i++ ) {
+			if ( workers[i].batch != NULL ) {
+				(void)pthread_join( threads[i], NULL );
+			}
+		}
+
+		/*** report ***/
+		for ( i = 0; i < batch.njobs; i++ ) {
+			batch_job_t* job = &batch.jobs[i];
+			fprintf( STDOUT, "%s\t%s\t%s\t%lu\n", job->is_ok ? "ok" : "failed",
+				job->infile_name, job->outfile_name, (unsigned long)job->length );
+			if ( job->is_ok == false ) failed++;
+		}
+		(void)verbose_printf( VERB_DEBUG, "bldump: batch files=%d failed=%d workers=%d\n",
+			batch.njobs, failed, batch.nworkers );
+		is_ok = (failed == 0);
+
+		/* --stats of all workers */
+		for ( i = 0; opt->stats != NULL && i < batch.nworkers; i++ ) {
+			stats_merge( opt->stats, &workers[i].stats );
+		}
+	}
+
+	/*** dispose ***/
+	for ( i = 0; i < ndeques; i++ ) { /* initialized ones only */
+		(void)pthread_mutex_destroy( &batch.deques[i].lock );
+		free( batch.deques[i].jobs );
+	}
+	for ( i = 0; i < batch.njobs; i++ ) {
+		free( batch.jobs[i].infile_name );
+		free( batch.jobs[i].outfile_name );
+	}
+	free( batch.jobs );
+	free( batch.deques );
+	free( workers );
+	free( threads );
+
+	return is_ok;
+}
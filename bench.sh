@@ -0,0 +1,64 @@
+#!/bin/sh
+# bench.sh - throughput of bldump over inputs and modes, run by 'make bench'.
+#
+# usage: bench.sh <bldump> <bldump-gen> [<size>] [<repeat>]
+#
+# Prints a JSON line per input and mode:
+#   {"version":..,"input":..,"size":..,"mode":..,"repeat":..,
+#    "min_s":..,"median_s":..,"mbps":..,"rows_per_s":..}
+# mbps and rows_per_s are of the median time.
+
+BLDUMP=${1:?bldump}
+GEN=${2:?bldump-gen}
+SIZE=${3:-16M}
+REPEAT=${4:-5}
+DIR=${BENCH_DIR:-/tmp}
+
+VERSION=$($BLDUMP --version | sed 's/^bldump version //; s/ .*//')
+
+# name|options|bytes of a record
+MODES='hex||16
+address|-a|16
+dec16|-i -l 2|32
+udec64|-u -l 8|128
+ascii|-A|16
+binary|-b|16
+reorder|-r 3210|64
+search|-S a55a -f 32|32'
+
+for input in random zero text sync; do
+	file="$DIR/bldump-bench-$input.bin"
+	$GEN $input $SIZE > "$file" || exit 1
+	bytes=$(wc -c < "$file")
+
+	echo "$MODES" | while IFS='|' read -r name args record; do
+		times=""
+		i=0
+		while [ $i -lt $REPEAT ]; do
+			t0=$(date +%s%N)
+			# shellcheck disable=SC2086
+			if ! $BLDUMP $args "$file" > /dev/null; then
+				echo "bench.sh: failed - bldump $args $input" >&2
+				times=""
+				break
+			fi
+			t1=$(date +%s%N)
+			times="$times $((t1 - t0))"
+			i=$((i + 1))
+		done
+		[ -n "$times" ] || continue
+		echo $times | tr ' ' '\n' | sort -n | awk \
+			-v version="$VERSION" -v input="$input" -v bytes="$bytes" \
+			-v mode="$name" -v args="$args" -v record="$record" -v repeat="$REPEAT" '
+			{ t[NR] = $1 / 1e9 }
+			END {
+				med = (NR % 2) ? t[(NR + 1) / 2] : (t[NR / 2] + t[NR / 2 + 1]) / 2
+				if ( med <= 0 ) med = 1e-9
+				printf "{\"version\":\"%s\",\"input\":\"%s\",\"size\":%d,\"mode\":\"%s\",\"options\":\"%s\",\"repeat\":%d,", \
+					version, input, bytes, mode, args, repeat
+				printf "\"min_s\":%.6f,\"median_s\":%.6f,\"mbps\":%.1f,\"rows_per_s\":%.0f}\n", \
+					t[1], med, bytes / med / 1e6, bytes / record / med
+			}'
+	done
+	rm -f "$file"
+done
@@ -13,24 +13,18 @@
 #include <assert.h>
 #include <limits.h>
 #include <ctype.h>
+#include <unistd.h>
 
 #include "verbose.h"
 #include "bldump.h"
-#ifdef TEST
-#include "munit.h"
-#endif
-
-/*** interface ***/
-#ifndef VERSION
-#define VERSION "0.x"
-#endif
-#define BUILD   __DATE__
+#include "fpconv.h"
 
 static const char *usage[] = {
 	"Usage: bldump [<options>] [<infile> [<outfile>]]",
 	"",
 	"  <infile>",
-	"    dump file.",
+	"    dump file, or memory of a process by '<pid>:<start>-<end>' in hex",
+	"    or '<pid>:<mapping>' of /proc/<pid>/maps.",
 	"",
 	"  <outfile>",
 	"    output file name. if not specified, output stdout.",
@@ -56,6 +50,55 @@ static const char *usage[] = {
 	"  -S<hex>, --search=<hex>",
 	"    Skip data to searching for <hex> pattern.",
 	"",
+	"  -z, --decompress [--index=<file>]",
+	"    Dumps the decompressed data of gzip or zstd <infile>. <file> keeps",
+	"    seek points of gzip, and -s jumps to the nearest one.",
+	"",
+	"  --ranges=<list>, --ranges=@<file>",
+	"    Dumps ranges of <start>-<end> or <start>+<size> separated by ','",
+	"    or lines of <file>, in requested order with labels.",
+	"",
+	"  --batch=<list>, --batch=<dir> [--jobs=<num>]",
+	"    Dumps many files by worker threads instead of <infile>.",
+	"    <list> has lines of '<infile> [<outfile>]', and files of <dir>",
+	"    are dumped to <file>.dump. status of each file is displayed.",
+	"",
+	"  --diff <infile> <file> [<outfile>]",
+	"    Compares <infile> with <file> by blocks(--jobs=<num> threads),",
+	"    and displays the differing rows of both with the address.",
+	"",
+	"  --watch, --watch=<ms>[,<passes>]",
+	"    Dumps <infile> by every <ms>(default:1000), all the rows at first",
+	"    and the rows of changed blocks after, with the address.",
+	"",
+	"  --follow",
+	"    Dumps <infile>, and then the appends to it as they are written",
+	"    until it is deleted or Ctrl-C, like 'tail -f'.",
+	"",
+	"  --serve=<socket>",
+	"    Runs as a daemon dumping requests from the unix domain <socket>.",
+	"    bldump forwards to the daemon at $BLDUMP_SERVER if it's running.",
+	"",
+	"  --stride=<num> [--offset=<num>] [--count=<num>]",
+	"    Reads <count> bytes at <offset> of every <stride> bytes record.",
+	"    A line displays a record(default count: fields x length).",
+	"",
+	"  --bits=<num>",
+	"    The number of bits of packed data(1-56), instead of -l.",
+	"    -i extends the sign bit.",
+	"",
+	"  --lsb-first",
+	"    Packed data is filled from LSB of each byte(default:MSB).",
+	"",
+	"  --layout=<spec>",
+	"    Decode records of mixed fields, e.g. 'u8,s16le,u32be,f32le,skip4'.",
+	"    <spec> consists of u8,s8,{u,s}{16,32,64}{le,be},f{16,32,64}{le,be},skip<num>.",
+	"",
+	"  --where=<expr>",
+	"    Writes only the rows where <expr> of C is not 0, e.g.",
+	"    'field[3] & 0x80' or 'field[0] >= 100 && field[0] < 200'.",
+	"    field[<n>] is a value as displayed, byte[<n>] and addr.",
+	"",
 	/* output */
 	"  -i, --decimal",
 	"    Displays decimal.",
@@ -66,9 +109,34 @@ static const char *usage[] = {
 	"  -A, --ascii",
 	"    Displays character.",
 	"",
+	"  --float=<type>",
+	"    Displays IEEE floating point.",
+	"    <type> is f16, f32 or f64, followed by le or be(default).",
+	"",
 	"  -b, --binary",
 	"    Outputs binary.",
 	"",
+	"  --npy",
+	"    Outputs NumPy .npy array of rows x fields to <outfile>.",
+	"    The element type is signed with -i, float with --float,",
+	"    a record with --layout, otherwise unsigned.",
+	"",
+	"  --columns",
+	"    Outputs each field to <outfile>.col0, <outfile>.col1, ..",
+	"    one value per line, or raw bytes with -b.",
+	"",
+	"  --reverse",
+	"    Parses the dump text of <infile> back to binary. give the same",
+	"    -a, -d, -l, -r, -s and hexadecimal, -i or -u as dumped.",
+	"",
+	"  --compress=gzip[,<level>], --compress=zstd[,<level>]",
+	"    Compresses the output by --jobs=<num> threads(default: online CPUs)",
+	"    into independent gzip members or zstd frames of 1M.",
+	"",
+	"  --out=<format-options>:<file>",
+	"    Writes the dump also to <file> by its own -a, -d, -i, -u, -b, -A,",
+	"    --npy or --compress, from the same read. can be set repeatedly.",
+	"",
 	"  -a, --show-address",
 	"    Displays data address preceded each line.",
 	"    if not specified, doesn't display.",
@@ -80,6 +148,9 @@ static const char *usage[] = {
 	"  -v <num>, --verbose=<num>",
 	"    verbose mode(default:3).",
 	"",
+	"  --stats, --stats=json",
+	"    Displays time of each stage and counts to stderr at exit.",
+	"",
 	/* others */
 	"  -h -? --help",
 	"    displays command line help message, and exit application.",
@@ -103,15 +174,27 @@ static const char *usage[] = {
 #define die verbose_die
 #define min(a,b) ((a)>(b)?(b):(a))
 
+/* --stats : a branch on opt->stats when it's off. */
+#define STATS_BEGIN(opt)   uint64_t stats_t0 = ((opt)->stats != NULL) ? stats_now() : 0
+#define STATS_RESTART(opt) do{ if ( (opt)->stats != NULL ) stats_t0 = stats_now(); }while(0)
+#define STATS_END(opt,s)   do{ if ( (opt)->stats != NULL ) stats_add( (opt)->stats, (s), stats_t0 ); }while(0)
+
+/*** constant ***/
+#define COLUMN_BLOCK_SIZE (256*1024) /*!< --columns : reading block size to fit in cache. */
+#define COLUMN_TILE_SIZE  4096       /*!< --columns : gathering buffer size of a column. */
+#define STRIDE_PREAD_GAP  4096       /*!< --stride : skipping size to read each record by pread. */
+#define STRIDE_BATCH      (256*1024) /*!< --stride : bytes of the records read by a pread. */
+#define FILE_BUFFER       65536      /*!< input buffer of infile. */
+
+/*** prototype ***/
+static bool write_output( memory_t* memory, file_t* outfile, options_t* opt );
+
 /*** TEST ***/
 #ifdef TEST
 #define STDIN	t_stdin
 #define STDOUT	t_stdout
 #define STDERR	t_stderr
 #define EXIT	t_exit
-int mu_nfail=0;
-int mu_ntest=0;
-int mu_nassert=0;
 #else
 #define STDIN	stdin
 #define STDOUT	stdout
@@ -119,87 +202,6 @@ int mu_nassert=0;
 #define EXIT	exit
 #endif
 
-/*!
- * @brief bldump main function.
- * @retval 0 normal termination.
- */
-int main( int argc, char* argv[] )
-{
-	bool is_ok;
-
-	options_t opt; 
-	file_t    infile;
-	file_t    outfile;
-	memory_t  memory;
-
-	if ( argc == 2 && strcmp("--version", argv[1]) == 0  ) {
-		fprintf( (STDOUT)?STDOUT:stdout, "bldump version %s (%s)\n", VERSION, BUILD );
-		return 0;
-	}
-#ifdef TEST
-	/* run test */
-	if ( argc == 2 && strcmp("--test", argv[1]) == 0  ) {
-		extern void ts_verbose(void);
-		extern void ts_opt(void);
-		extern void ts_memory(void);
-		extern void ts_file(void);
-		extern void ts_bldump(void);
-		extern void ts_main(void);
-		ts_verbose();
-		ts_opt();
-		ts_memory();
-		ts_file();
-		ts_bldump();
-		ts_main();
-		mu_show_failures();
-		return mu_nfail;
-	}
-	assert( t_stdin != NULL && t_stdout != NULL && t_stderr != NULL );
-#endif
-
-
-	/*** prepare ***/
-	verbose_level = VERB_DEFAULT;
-	if ( verbose_out == NULL ) verbose_out = stdout;
-
-	options_reset( &opt );  
-	memory_init( &memory );
-	file_reset( &infile );
-	file_reset( &outfile );
-
-	/*** arguments ***/
-	is_ok = options_load( &opt, argc, argv  );
-
-	/*** set parameter. ***/
-	if ( is_ok == true ) {
-		is_ok = bldump_setup( &memory, &infile, &outfile, &opt );
-	}
-
-	/*** bldump ***/
-	if ( is_ok == true ) {
-		while( feof(infile.ptr)==0 ) {
-			is_ok = bldump_read( &memory, &infile, &opt );
-			if ( is_ok == false || memory.size == 0 ) {
-				break;
-			}
-
-			is_ok = bldump_write( &memory, &outfile, &opt );
-			if ( is_ok == false ) {
-				break;
-			}
-		}
-	}
-
-	/*** dispose ***/
-	(void)file_close( &infile );
-	if ( memory.data != NULL ) {
-		(void)memory_free( &memory );
-	}
-	(void)options_clear( &opt );
-
-	return (is_ok == true) ? 0 : 1;
-}
-
 /**********
  * bldump *
  **********/
@@ -223,12 +225,25 @@ bool bldump_setup( memory_t* memory, file_t* infile, file_t* outfile, options_t*
 		(void)verbose_printf( VERB_ERR, "Error: can't open infile - %s\n", opt->infile_name );
 		return false;
 	}
+	if ( opt->decompress == true && decompress_open( infile, opt->index_name ) == false ) {
+		return false;
+	}
 	if ( opt->start_address > 0 ) {
 		(void)file_seek( infile, opt->start_address ) ;
 	}
 
 	/* outfile */
-	if ( opt->outfile_name == NULL ) {
+	if ( opt->outfile_name == NULL && opt->npy_output == true ) {
+		(void)verbose_printf( VERB_ERR, "Error: --npy needs seekable outfile.\n" );
+		return false;
+	}
+	if ( opt->outfile_name == NULL && opt->column_output == true ) {
+		(void)verbose_printf( VERB_ERR, "Error: --columns needs outfile.\n" );
+		return false;
+	}
+	if ( opt->column_output == true ) {
+		/* opened after checking data_fields */
+	} else if ( opt->outfile_name == NULL ) {
 		(void)verbose_printf( VERB_LOG, "bldump: output to `stdout\' insted of outfile.\n" );
 		outfile->ptr    = STDOUT;
 		outfile->length = 0;
@@ -240,19 +255,136 @@ bool bldump_setup( memory_t* memory, file_t* infile, file_t* outfile, options_t*
 	}
 
 	/* memory */
+	size = bldump_record_size( opt );
+	if ( size == 0 ) {
+		return false;
+	}
+
+	/* columns */
+	if ( opt->column_output == true ) {
+		int i;
+		char* name = (char*)malloc( strlen( opt->outfile_name ) + 16 );
+		outfile->columns = (file_t*)malloc( sizeof(file_t) * (size_t)opt->data_fields );
+		if ( name == NULL || outfile->columns == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+			free( name );
+			return false;
+		}
+		for ( i = 0; i < opt->data_fields; i++ ) {
+			file_reset( &outfile->columns[i] );
+		}
+		outfile->ncolumns = opt->data_fields;
+		for ( i = 0; i < opt->data_fields; i++ ) {
+			(void)sprintf( name, "%s.col%d", opt->outfile_name, i );
+			if ( file_open( &outfile->columns[i], name, "wb" ) == false ) {
+				(void)verbose_printf( VERB_ERR, "Error: can't open outfile - %s\n", name );
+				free( name );
+				return false;
+			}
+		}
+		free( name );
+
+		/* read rows as many as fit in cache, except -S that syncs each row */
+		if ( opt->search_length == 0 && size < COLUMN_BLOCK_SIZE ) {
+			size = size * (COLUMN_BLOCK_SIZE / size);
+		}
+	}
+	
+	is = memory_allocate( memory, size );
+
+	/* sinks of --out */
+	if ( is == true && opt->tee != NULL ) {
+		is = tee_start( opt->tee, opt, memory->length );
+	}
+
+	return is;
+}
+
+/*!
+ * @brief size of a record read at once.
+ * @param[in] opt
+ * @return bytes of a record, or 0 if the options are wrong.
+ */
+size_t bldump_record_size( options_t* opt )
+{
+	size_t size;
+
 	if ( opt->data_length == 0 ) {
 		(void)verbose_printf( VERB_ERR, "Error: wrong data_length=%d\n", opt->data_length );
-		return false;
+		return 0;
 	}
 	if ( opt->data_fields<= 0 ) {
 		(void)verbose_printf( VERB_ERR, "Error: wrong data_fields=%d\n", opt->data_fields);
-		return false;
+		return 0;
 	}
 	size = (size_t) (opt->data_length * opt->data_fields);
-	
-	is = memory_allocate( memory, size );
+	if ( opt->stride > 0 ) {
+		if ( opt->stride_count == 0 || opt->stride_offset + opt->stride_count > opt->stride ) {
+			(void)verbose_printf( VERB_ERR, "Error: offset + count is out of stride - stride=%d offset=%d count=%d\n",
+				opt->stride, opt->stride_offset, opt->stride_count );
+			return 0;
+		}
+		size = opt->stride_count;
+	}
+	if ( opt->data_bits > 0 ) {
+		if ( (opt->data_bits * (size_t)opt->data_fields) % 8 != 0 ) {
+			(void)verbose_printf( VERB_ERR, "Error: bits x fields should be byte align - bits=%d fields=%d\n", opt->data_bits, opt->data_fields );
+			return 0;
+		}
+		size = (opt->data_bits * (size_t)opt->data_fields) / 8;
+	}
+	return size;
+}
 
-	return is;
+/*!
+ * @brief dump infile to outfile.
+ * @param[in,out] memory
+ * @param[in] infile
+ * @param[out] outfile
+ * @param[in] opt
+ * @retval true success.
+ * @retval false failure.
+ */
+bool bldump_dump( memory_t* memory, file_t* infile, file_t* outfile, options_t* opt )
+{
+	bool is_ok = true;
+
+	if ( opt->range_count > 0 ) {
+		is_ok = bldump_ranges( memory, infile, outfile, opt );
+	} else {
+		while( infile->eof == false ) {
+			is_ok = bldump_read( memory, infile, opt );
+			if ( is_ok == false || memory->size == 0 ) {
+				break;
+			}
+
+			if ( opt->where != NULL && where_match( opt->where, memory ) == false ) {
+				if ( opt->stats != NULL ) {
+					opt->stats->rejected++;
+				}
+				continue; /* not formatted */
+			}
+			if ( opt->tee != NULL ) { /* before -A rewrites the row */
+				tee_push( opt->tee, memory );
+			}
+			is_ok = bldump_write( memory, outfile, opt );
+			if ( is_ok == false ) {
+				break;
+			}
+		}
+	}
+	if ( is_ok == true ) {
+		STATS_BEGIN( opt );
+		is_ok = bldump_finish( memory, outfile, opt );
+		if ( outfile->ptr != NULL && fflush( outfile->ptr ) != 0 ) {
+			is_ok = false;
+		}
+		STATS_END( opt, STATS_FLUSH );
+	}
+	if ( opt->tee != NULL && tee_finish( opt->tee ) == false ) {
+		is_ok = false;
+	}
+	return is_ok;
 }
 
 /*!
@@ -268,60 +400,63 @@ bool bldump_read( memory_t* memory, file_t* infile, /*@unused@*/ options_t* opt
 	bool is;
 	size_t nmemb;
 	size_t limit;
+	STATS_BEGIN( opt );
 
 	DEBUG_ASSERT( memory->length > 0 );
 
 	memory_clear( memory );
 
-	if ( opt->search_length > 0 ) {
-		is = file_search( infile, memory, opt );
+	if ( opt->stride > 0 ) {
+		is = file_read_stride( infile, memory, opt );
+		STATS_END( opt, STATS_READ );
 		if ( is == false ) {
-			return true;
-		}
-	}
-
-	nmemb = memory->length - memory->size;
-	if ( opt->end_address != 0 ) {
-		if ( infile->position >= opt->end_address ) {
 			return false;
 		}
-		limit = opt->end_address - infile->position;
-		if ( nmemb > limit ) {
-			nmemb = limit;
-			(void)verbose_printf( VERB_WARNING, "Warning: cut off the reading size less than end-address.\n" );
-		}
-	}
-
-	is = file_read( infile, memory, nmemb );
-
-	if ( is == false || memory->size == 0 ) {
-		(void)verbose_printf( VERB_DEBUG, "bldump: file read failure.\n" );
 	} else {
-		/* reordering */
-		if ( opt->data_order[0] != -1 ) {
-			size_t i, j, k, idx = 0;
-			for ( i=0; i<memory->size; i+=opt->data_length ) {
-				uint64_t data = 0;
-				for ( j=0, k=(opt->data_length-1)*8;
-					j<opt->data_length; j++, k-=8 ) {
-					size_t loc=i+opt->data_order[j];
-					if ( loc < memory->size ) {
-						data = data | (((uint64_t)memory->data[loc]) << k);
-					}
+		if ( opt->search_length > 0 ) {
+			size_t pos = infile->position;
+			is = file_search( infile, memory, opt );
+			STATS_END( opt, STATS_SEARCH );
+			if ( opt->stats != NULL ) {
+				opt->stats->searches++;
+				if ( is == true && memory->address > pos ) {
+					opt->stats->resyncs++;
+					opt->stats->skipped += memory->address - pos;
 				}
+			}
+			if ( is == false ) {
+				return true;
+			}
+			STATS_RESTART( opt );
+		}
 
-				for ( j=0, k=(opt->data_length-1)*8;
-					(j<opt->data_length) && (i+j) < memory->length;
-					j++, k-=8 ) {
-					idx = i+j;
-					memory->data[i+j] = (data_t) (data >> k);
-				}
+		nmemb = memory->length - memory->size;
+		if ( opt->end_address != 0 ) {
+			if ( infile->position >= opt->end_address && memory->size == 0 ) {
+				return false;
 			}
-			if ( idx >= memory->size ) {
-				assert( idx <= memory->length );
-				memory->size = idx;
+			limit = (infile->position < opt->end_address) ? opt->end_address - infile->position : 0;
+			if ( nmemb > limit ) {
+				nmemb = limit;
+				(void)verbose_printf( VERB_WARNING, "Warning: cut off the reading size less than end-address.\n" );
 			}
 		}
+
+		/* -S may fill the record with the pattern */
+		is = (nmemb > 0) ? file_read( infile, memory, nmemb ) : true;
+		STATS_END( opt, STATS_READ );
+	}
+	if ( opt->stats != NULL ) {
+		opt->stats->reads++;
+		opt->stats->bytes_in += memory->size;
+	}
+
+	if ( is == false || memory->size == 0 ) {
+		(void)verbose_printf( VERB_DEBUG, "bldump: file read failure.\n" );
+	} else {
+		STATS_RESTART( opt );
+		memory_reorder( memory, opt );
+		STATS_END( opt, STATS_REORDER );
 	}
 	return is;
 }
@@ -336,6 +471,44 @@ bool bldump_read( memory_t* memory, file_t* infile, /*@unused@*/ options_t* opt
  */
 bool bldump_write( memory_t* memory, file_t* outfile, options_t* opt )
 {
+	bool is;
+	STATS_BEGIN( opt );
+
+	is = write_output( memory, outfile, opt );
+	STATS_END( opt, STATS_WRITE );
+	if ( opt->stats != NULL && opt->stats->row_size > 0 ) {
+		opt->stats->rows += (memory->size + opt->stats->row_size - 1) / opt->stats->row_size;
+	}
+	return is;
+}
+
+/*!
+ * @brief write data in the format of the options.
+ */
+static bool write_output( memory_t* memory, file_t* outfile, options_t* opt )
+{
+	/*** NumPy array ***/
+	if ( opt->npy_output == true ) {
+		return write_npy( memory, outfile, opt );
+	}
+
+	/*** columns ***/
+	if ( opt->column_output == true ) {
+		return write_columns( memory, outfile, opt );
+	}
+
+	/*** record layout ***/
+	if ( opt->layout != NULL && opt->output_type != BINARY ) {
+		write_layout( memory, outfile, opt );
+		return true;
+	}
+
+	/*** packed data ***/
+	if ( opt->data_bits > 0 && opt->output_type != BINARY ) {
+		write_bits( memory, outfile, opt );
+		return true;
+	}
+
 	/*** output ***/
 	switch( opt->output_type )
 	{
@@ -354,10 +527,300 @@ bool bldump_write( memory_t* memory, file_t* outfile, options_t* opt )
 			to_printable( memory );
 			write_hex( memory, outfile, opt );
 			break;
+		case FLOAT16:
+		case FLOAT32:
+		case FLOAT64:
+			write_float( memory, outfile, opt );
+			break;
 	}
 	return true ;
 }
 
+/*** range_state_t ***/
+typedef struct {
+	size_t start;  /*!< start address, in infile. */
+	size_t end;    /*!< end address, not included. */
+	size_t pos;    /*!< next row. */
+	int    index;  /*!< index of opt->ranges. */
+	bool   direct; /*!< written to outfile, otherwise to spool. */
+	bool   done;
+	file_t spool;  /*!< output while it isn't the turn of the range. */
+	long   stored; /*!< offset of the finished spool in the store, -1 if not. */
+	size_t size;   /*!< bytes of the finished spool. */
+} range_state_t;
+
+static int range_compare( const void* a, const void* b )
+{
+	const range_state_t* l = *(const range_state_t* const*)a;
+	const range_state_t* r = *(const range_state_t* const*)b;
+	if ( l->start != r->start ) {
+		return (l->start < r->start) ? -1 : 1;
+	}
+	return l->index - r->index;
+}
+
+/*!
+ * @brief copy bytes of a spool to outfile.
+ */
+static bool range_copy( FILE* from, long offset, size_t size, FILE* to, size_t* length )
+{
+	char buf[4096];
+
+	if ( fseek( from, offset, SEEK_SET ) != 0 ) {
+		return false;
+	}
+	while ( size > 0 ) {
+		size_t n = fread( buf, 1, min( size, sizeof(buf) ), from );
+		if ( n == 0 || fwrite( buf, 1, n, to ) != n ) {
+			return false;
+		}
+		*length += n;
+		size    -= n;
+	}
+	return true;
+}
+
+/*!
+ * @brief finish the range, and write the finished ranges in requested order.
+ * @param[in,out] emit index of the range to be written next.
+ */
+static bool range_finish( range_state_t* states, range_state_t* r, int n, int* emit, FILE** store, file_t* outfile )
+{
+	size_t stored = 0;
+	bool is = true;
+
+	r->done = true;
+	if ( r->spool.ptr != NULL ) {
+		r->size = (size_t)ftell( r->spool.ptr ); /* the writers don't count the length */
+	}
+	if ( r->spool.ptr != NULL && r->index != *emit ) {
+		/* keep it in the store, not to hold a file of each waiting range */
+		if ( *store == NULL && (*store = tmpfile()) == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't create temporary file\n" );
+			return false;
+		}
+		(void)fseek( *store, 0, SEEK_END );
+		r->stored = ftell( *store );
+		is = range_copy( r->spool.ptr, 0, r->size, *store, &stored );
+		(void)fclose( r->spool.ptr );
+		r->spool.ptr = NULL;
+	}
+	while ( is == true && *emit < n && states[*emit].done == true ) {
+		range_state_t* e = &states[*emit];
+		if ( e->spool.ptr != NULL ) {
+			is = range_copy( e->spool.ptr, 0, e->size, outfile->ptr, &outfile->length );
+			(void)fclose( e->spool.ptr );
+			e->spool.ptr = NULL;
+		} else if ( e->stored >= 0 ) {
+			is = range_copy( *store, e->stored, e->size, outfile->ptr, &outfile->length );
+		}
+		(*emit)++;
+	}
+	if ( is == false ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't write the output of --ranges\n" );
+	}
+	return is;
+}
+
+/*!
+ * @brief dump the ranges of --ranges.
+ *
+ * The ranges are sorted by address, and overlapping or adjacent ones
+ * are merged into spans. Each span is read once in ascending order,
+ * the rows of all its ranges by the order of address through a window
+ * of a row, so that infile only goes forward, even a pipe, and the
+ * memory doesn't grow with the size of ranges.
+ *
+ * Each range is written in requested order following the label line.
+ * A range whose turn hasn't come yet, as a range before it in request
+ * is at a higher address, is written to a temporary file, and copied
+ * to outfile on its turn.
+ *
+ * @param[in,out] memory memory of a row.
+ * @param[in] infile
+ * @param[out] outfile
+ * @param[in] opt
+ * @retval true success.
+ * @retval false failure.
+ */
+bool bldump_ranges( memory_t* memory, file_t* infile, file_t* outfile, options_t* opt )
+{
+	const int n = opt->range_count;
+	range_state_t*  states = (range_state_t*)calloc( (size_t)n, sizeof(range_state_t) );
+	range_state_t** order  = (range_state_t**)malloc( sizeof(range_state_t*) * (size_t)n );
+	data_t* window = (data_t*)malloc( memory->length ); /* [wstart, wend) of infile */
+	size_t wstart = 0, wend = 0;
+	FILE* store = NULL;
+	int emit = 0;
+	int lo, hi, i, nspan = 0;
+	bool is = true;
+
+	if ( states == NULL || order == NULL || window == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		is = false;
+	}
+	for ( i = 0; is == true && i < n; i++ ) {
+		range_state_t* r = &states[i];
+		r->start  = opt->ranges[i].start;
+		r->end    = opt->ranges[i].end;
+		if ( infile->length > 0 ) {
+			r->end   = min( r->end, infile->length );
+			r->start = min( r->start, r->end );
+		}
+		r->pos    = r->start;
+		r->index  = i;
+		r->stored = -1;
+		file_reset( &r->spool );
+		order[i] = r;
+	}
+	if ( is == true ) {
+		qsort( order, (size_t)n, sizeof(range_state_t*), range_compare );
+	}
+
+	/*** spans in ascending order ***/
+	for ( lo = 0; is == true && lo < n; lo = hi ) {
+		size_t end = order[lo]->end;
+		for ( hi = lo + 1; hi < n && order[hi]->start <= end; hi++ ) {
+			end = (order[hi]->end > end) ? order[hi]->end : end;
+		}
+		nspan++;
+
+		/* rows of the ranges of the span, by the order of address */
+		while ( is == true ) {
+			range_state_t* r = NULL;
+			file_t* sink;
+			size_t s, want, avail;
+
+			for ( i = lo; i < hi; i++ ) {
+				if ( order[i]->done == false && (r == NULL || order[i]->pos < r->pos) ) {
+					r = order[i];
+				}
+			}
+			if ( r == NULL ) {
+				break;
+			}
+			if ( r->pos == r->start && r->direct == false && r->spool.ptr == NULL ) {
+				/* start of the range, on its turn or to a spool */
+				r->direct = (r->index == emit);
+				if ( r->direct == false && (r->spool.ptr = tmpfile()) == NULL ) {
+					(void)verbose_printf( VERB_ERR, "Error: can't create temporary file\n" );
+					is = false;
+					break;
+				}
+				sink = (r->direct == true) ? outfile : &r->spool;
+				if ( opt->output_type != BINARY ) {
+					fprintf( sink->ptr, "# %08lx-%08lx%s", (unsigned long)opt->ranges[r->index].start,
+						(unsigned long)opt->ranges[r->index].end, opt->row_delimitter );
+				}
+			}
+			sink = (r->direct == true) ? outfile : &r->spool;
+
+			/* the row in the window, infile goes forward only */
+			s    = r->pos;
+			want = min( memory->length, r->end - s );
+			if ( want > 0 && s > wend ) {
+				if ( infile->position != s && file_seek( infile, s ) != 0 ) {
+					is = false;
+					break;
+				}
+				wstart = wend = s;
+			} else if ( want > 0 && s > wstart ) {
+				(void)memmove( window, &window[s - wstart], wend - s );
+				wstart = s;
+			}
+			if ( want > 0 && s + want > wend ) {
+				wend += file_fetch( infile, &window[wend - wstart], s + want - wend );
+				if ( infile->failed == true ) {
+					is = false;
+					break;
+				}
+			}
+			avail = (want > 0) ? min( want, wend - s ) : 0;
+			if ( avail == 0 ) {
+				is = range_finish( states, r, n, &emit, &store, outfile );
+				continue;
+			}
+			r->pos += avail;
+
+			memory_clear( memory );
+			memcpy( memory->data, window, avail );
+			memory->address = s;
+			memory->size    = avail;
+			memory_reorder( memory, opt );
+			if ( opt->where != NULL && where_match( opt->where, memory ) == false ) {
+				if ( opt->stats != NULL ) {
+					opt->stats->rejected++;
+				}
+			} else {
+				is = bldump_write( memory, sink, opt );
+			}
+			if ( is == true && avail < want ) { /* end of infile */
+				is = range_finish( states, r, n, &emit, &store, outfile );
+			}
+		}
+	}
+	(void)verbose_printf( VERB_DEBUG, "bldump: ranges=%d merged=%d\n", n, nspan );
+
+	for ( i = 0; states != NULL && i < n; i++ ) {
+		if ( states[i].spool.ptr != NULL ) {
+			(void)fclose( states[i].spool.ptr );
+		}
+	}
+	if ( store != NULL ) {
+		(void)fclose( store );
+	}
+	free( window );
+	free( order );
+	free( states );
+	return is;
+}
+
+/*!
+ * @brief finish output after the last bldump_write().
+ *
+ * --npy rewrites the header with the number of written rows.
+ *
+ * @param[in] memory
+ * @param[out] outfile
+ * @param[in] opt
+ * @retval true success.
+ * @retval false failure.
+ */
+bool bldump_finish( /*@unused@*/ memory_t* memory, file_t* outfile, options_t* opt )
+{
+	(void)memory;
+
+	if ( opt->npy_output == true ) {
+		char* header;
+		size_t size, rows;
+		size_t row_size = opt->data_length * (size_t)opt->data_fields;
+
+		size   = npy_header( NULL, 0, opt, 0 );
+		header = (char*)malloc( size + 1 );
+		if ( header == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+			return false;
+		}
+		if ( outfile->length == 0 ) {
+			/* no rows */
+			(void)npy_header( header, size + 1, opt, 0 );
+			outfile->length += fwrite( header, 1, size, outfile->ptr );
+		}
+		rows = (outfile->length - size) / row_size;
+		(void)npy_header( header, size + 1, opt, rows );
+		if ( fseek( outfile->ptr, 0, SEEK_SET ) != 0
+			|| fwrite( header, 1, size, outfile->ptr ) != size
+			|| fseek( outfile->ptr, 0, SEEK_END ) != 0 ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't update npy header - %s\n", outfile->name );
+			free( header );
+			return false;
+		}
+		(void)verbose_printf( VERB_DEBUG, "bldump: npy shape=(%d, %d)\n", rows, opt->data_fields );
+		free( header );
+	}
+	return true;
+}
+
 /*!
  * @brief print hex data.
  * @param[in] memory read dump data.
@@ -437,6 +900,396 @@ void write_dec( memory_t* memory, file_t* outfile, options_t* opt )
 	(void)fputs( opt->row_delimitter, outfile->ptr ); /* line separater */
 }
 
+/*!
+ * @brief print IEEE floating point.
+ *
+ * A partial value at the end of data is not displayed.
+ *
+ * @param[in] memory read dump data.
+ * @param[out] file file pointer.
+ * @param[in] opt
+ */
+void write_float( memory_t* memory, file_t* outfile, options_t* opt )
+{
+	size_t i, j;
+	size_t data_len = opt->data_length;
+	uint64_t data;
+	char buf[FPCONV_BUFSIZE];
+
+	/*** output address ***/
+	if ( opt->show_address == true ) {
+		fprintf( outfile->ptr, "%08lx: ", (unsigned long)memory->address );
+	}
+
+	for ( i = 0; i + data_len <= memory->size; i += data_len ) {
+		/*** column delimitter ***/
+		if ( opt->col_delimitter != NULL && i != 0 ) {
+			(void)fputs( opt->col_delimitter, outfile->ptr );
+		}
+
+		/*** output data ***/
+		data = 0;
+		for ( j = 0; j < data_len; j++ ) {
+			data = (data << 8) | memory->data[i + j];
+		}
+		(void)fpconv_format( buf, data, data_len );
+		(void)fputs( buf, outfile->ptr );
+	}
+	(void)fputs( opt->row_delimitter, outfile->ptr ); /* line separater */
+}
+
+/*!
+ * @brief print records decoded with the field table of --layout.
+ * @param[in] memory read dump data.
+ * @param[out] file file pointer.
+ * @param[in] opt
+ */
+void write_layout( memory_t* memory, file_t* outfile, options_t* opt )
+{
+	size_t i;
+	int f;
+	bool is_first = true;
+
+	DEBUG_ASSERT( opt->layout != NULL );
+	DEBUG_ASSERT( opt->data_length > 0 );
+
+	/*** output address ***/
+	if ( opt->show_address == true ) {
+		fprintf( outfile->ptr, "%08lx: ", (unsigned long)memory->address );
+	}
+
+	for ( i = 0; i < memory->size; i += opt->data_length ) {
+		for ( f = 0; f < opt->layout_fields; f++ ) {
+			const field_t* field = &opt->layout[f];
+			uint64_t data;
+
+			if ( field->type == FIELD_SKIP ) {
+				continue;
+			}
+			if ( i + field->offset + field->size > memory->size ) {
+				break; /* partial record */
+			}
+
+			/*** column delimitter ***/
+			if ( is_first == false ) {
+				(void)fputs( opt->col_delimitter, outfile->ptr );
+			}
+			is_first = false;
+
+			/*** output data ***/
+			data = field->decode( &memory->data[i + field->offset] );
+			switch ( field->type ) {
+				case FIELD_SIGNED: {
+					int s = (int)(sizeof(data) - field->size) * 8;
+					(void)fprintf( outfile->ptr, "%lld", (long long int)(((int64_t)(data << s)) >> s) );
+					break;
+				}
+				case FIELD_FLOAT: {
+					char buf[FPCONV_BUFSIZE];
+					(void)fpconv_format( buf, data, field->size );
+					(void)fputs( buf, outfile->ptr );
+					break;
+				}
+				case FIELD_UNSIGNED:
+				default:
+					(void)fprintf( outfile->ptr, "%llu", (unsigned long long int)data );
+					break;
+			}
+		}
+	}
+	(void)fputs( opt->row_delimitter, outfile->ptr ); /* line separater */
+}
+
+/*!
+ * @brief unpack bit packed data.
+ *
+ * Each value is taken by one 64 bit load instead of assembling bit by bit,
+ * so 'width' must be 56 or less.
+ *
+ * @param[in] data packed data.
+ * @param[in] size byte size of 'data'.
+ * @param[in] width bit width of a value.
+ * @param[in] lsb_first true if the first value is placed at LSB of data[0].
+ * @param[in] first index of the first value to unpack.
+ * @param[in] count number of values to unpack.
+ * @param[out] values unpacked values.
+ * @return number of unpacked values, less than 'count' at the end of data.
+ */
+size_t bits_unpack( const data_t* data, size_t size, unsigned int width, bool lsb_first, size_t first, size_t count, uint64_t* values )
+{
+	const uint64_t mask = (1uLL << width) - 1;
+	size_t i, n;
+	size_t bit = first * width;
+
+	DEBUG_ASSERT( width > 0 && width <= 56 );
+
+	n = (size * 8 > bit) ? (size * 8 - bit) / width : 0;
+	if ( n > count ) {
+		n = count;
+	}
+
+	for ( i = 0; i < n; i++, bit += width ) {
+		const data_t* p = &data[bit >> 3];
+		unsigned int shift = (unsigned int)(bit & 7);
+		uint64_t word = 0;
+		size_t j, avail = size - (bit >> 3);
+
+		if ( avail >= 8 ) {
+			if ( lsb_first ) {
+				word = (uint64_t)p[0]       | (uint64_t)p[1] <<  8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24
+				     | (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+			} else {
+				word = (uint64_t)p[0] << 56 | (uint64_t)p[1] << 48 | (uint64_t)p[2] << 40 | (uint64_t)p[3] << 32
+				     | (uint64_t)p[4] << 24 | (uint64_t)p[5] << 16 | (uint64_t)p[6] <<  8 | (uint64_t)p[7];
+			}
+		} else {
+			/* tail of data */
+			for ( j = 0; j < avail; j++ ) {
+				word |= lsb_first ? ((uint64_t)p[j] << (j * 8)) : ((uint64_t)p[j] << (56 - j * 8));
+			}
+		}
+
+		if ( lsb_first ) {
+			values[i] = (word >> shift) & mask;
+		} else {
+			values[i] = (word << shift) >> (64 - width);
+		}
+	}
+	return n;
+}
+
+/*!
+ * @brief print bit packed data.
+ * @param[in] memory read dump data.
+ * @param[out] file file pointer.
+ * @param[in] opt
+ */
+void write_bits( memory_t* memory, file_t* outfile, options_t* opt )
+{
+	uint64_t values[64];
+	size_t i, n, first = 0;
+	const int s = 64 - (int)opt->data_bits;
+	const int digits = (int)(opt->data_bits + 3) / 4;
+
+	/*** output address ***/
+	if ( opt->show_address == true ) {
+		fprintf( outfile->ptr, "%08lx: ", (unsigned long)memory->address );
+	}
+
+	do {
+		n = bits_unpack( memory->data, memory->size, opt->data_bits, opt->lsb_first,
+			first, sizeof(values)/sizeof(values[0]), values );
+		for ( i = 0; i < n; i++ ) {
+			/*** column delimitter ***/
+			if ( opt->col_delimitter != NULL && (first + i) != 0 ) {
+				(void)fputs( opt->col_delimitter, outfile->ptr );
+			}
+
+			/*** output data ***/
+			switch ( opt->output_type ) {
+				case DECIMAL:
+					(void)fprintf( outfile->ptr, "%lld", (long long int)(((int64_t)(values[i] << s)) >> s) );
+					break;
+				case UDECIMAL:
+					(void)fprintf( outfile->ptr, "%llu", (unsigned long long int)values[i] );
+					break;
+				default:
+					(void)fprintf( outfile->ptr, "%0*llx", digits, (unsigned long long int)values[i] );
+					break;
+			}
+		}
+		first += n;
+	} while ( n == sizeof(values)/sizeof(values[0]) );
+
+	(void)fputs( opt->row_delimitter, outfile->ptr ); /* line separater */
+}
+
+/*!
+ * @brief make the header of NumPy .npy format version 1.0.
+ *
+ * The header length doesn't depend on 'rows', so the header can be
+ * overwritten when the number of rows is fixed.
+ *
+ * @param[out] buf header buffer, or NULL to get the length.
+ * @param[in] size size of 'buf' includes the terminating null.
+ * @param[in] opt
+ * @param[in] rows number of rows.
+ * @return length of the header, or 0 if the element type is not supported.
+ */
+size_t npy_header( char* buf, size_t size, options_t* opt, size_t rows )
+{
+	static const char magic[] = "\x93NUMPY\x01\x00";
+	char* descr;
+	char* dict;
+	size_t len, total, dict_len;
+	int i;
+
+	/*** descr ***/
+	descr = (char*)malloc( 32 + (size_t)opt->layout_fields * 32 );
+	if ( descr == NULL ) {
+		return 0;
+	}
+	if ( opt->layout != NULL ) {
+		len = (size_t)sprintf( descr, "[" );
+		for ( i = 0; i < opt->layout_fields; i++ ) {
+			const field_t* field = &opt->layout[i];
+			char kind = (field->type == FIELD_SIGNED) ? 'i' : (field->type == FIELD_FLOAT) ? 'f' : 'u';
+			char order = (field->size == 1) ? '|' : (field->little ? '<' : '>');
+			if ( field->type == FIELD_SKIP ) {
+				kind  = 'V';
+				order = '|';
+			}
+			len += (size_t)sprintf( &descr[len], "('f%d', '%c%c%d'), ", i, order, kind, (int)field->size );
+		}
+		(void)sprintf( &descr[len], "]" );
+	} else {
+		char kind;
+		switch ( opt->output_type ) {
+			case DECIMAL: kind = 'i'; break;
+			case FLOAT16:
+			case FLOAT32:
+			case FLOAT64: kind = 'f'; break;
+			default:      kind = 'u'; break;
+		}
+		if ( opt->data_length != 1 && opt->data_length != 2 && opt->data_length != 4 && opt->data_length != 8 ) {
+			kind = 'V';
+		}
+		(void)sprintf( descr, "'%c%c%d'", (opt->data_length == 1 || kind == 'V') ? '|' : '>',
+			kind, (int)opt->data_length );
+	}
+
+	/*** dictionary, padded for the 64 byte alignment of data ***/
+	dict = (char*)malloc( strlen( descr ) + 128 );
+	if ( dict == NULL ) {
+		free( descr );
+		return 0;
+	}
+	dict_len = (size_t)sprintf( dict, "{'descr': %s, 'fortran_order': False, 'shape': (%20lu, %d), }",
+		descr, (unsigned long)rows, opt->data_fields );
+	free( descr );
+	total = (sizeof(magic) - 1 + 2 + dict_len + 1 + 63) & ~(size_t)63;
+
+	if ( buf != NULL ) {
+		size_t header_len = total - (sizeof(magic) - 1 + 2);
+		assert( size > total );
+		memcpy( buf, magic, sizeof(magic) - 1 );
+		buf[8] = (char)(header_len & 0xff);
+		buf[9] = (char)(header_len >> 8);
+		memcpy( &buf[10], dict, dict_len );
+		memset( &buf[10 + dict_len], ' ', total - 10 - dict_len - 1 );
+		buf[total - 1] = '\n';
+		buf[total] = '\0';
+	}
+	free( dict );
+
+	return total;
+}
+
+/*!
+ * @brief write a row of NumPy array.
+ *
+ * The header is written before the first row, and a partial row at the
+ * end of data is filled with zero.
+ *
+ * @param[in] memory read dump data.
+ * @param[out] file file pointer.
+ * @param[in] opt
+ * @retval true success.
+ * @retval false failure.
+ */
+bool write_npy( memory_t* memory, file_t* outfile, options_t* opt )
+{
+	size_t row_size = opt->data_length * (size_t)opt->data_fields;
+
+	if ( outfile->length == 0 ) {
+		char* header;
+		size_t size = npy_header( NULL, 0, opt, 0 );
+		header = (size > 0) ? (char*)malloc( size + 1 ) : NULL;
+		if ( header == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+			return false;
+		}
+		(void)npy_header( header, size + 1, opt, 0 );
+		outfile->length += fwrite( header, 1, size, outfile->ptr );
+		free( header );
+	}
+
+	file_write( outfile, memory );
+	if ( memory->size < row_size ) {
+		size_t i;
+		(void)verbose_printf( VERB_WARNING, "Warning: filled the last row with zero.\n" );
+		for ( i = memory->size; i < row_size; i++ ) {
+			(void)fputc( 0, outfile->ptr );
+		}
+		outfile->length += row_size - memory->size;
+	}
+	return true;
+}
+
+/*!
+ * @brief de-interleave rows and write each field to its own column file.
+ *
+ * 'memory' holds a block of rows which fits in cache, and each column is
+ * gathered into a small tile and then written by one call, so the block
+ * is read from cache for every column.
+ *
+ * @param[in] memory read dump data, one or more rows.
+ * @param[out] outfile file that has column files.
+ * @param[in] opt
+ * @retval true success.
+ * @retval false failure.
+ */
+bool write_columns( memory_t* memory, file_t* outfile, options_t* opt )
+{
+	data_t tile[COLUMN_TILE_SIZE];
+	const size_t len      = opt->data_length;
+	const size_t row_size = len * (size_t)opt->data_fields;
+	const size_t per_tile = (len < COLUMN_TILE_SIZE) ? (COLUMN_TILE_SIZE / len) : 1;
+	options_t column_opt = *opt;
+	memory_t view;
+	int c;
+
+	DEBUG_ASSERT( outfile->ncolumns == opt->data_fields );
+
+	/* a value per line */
+	column_opt.col_delimitter = opt->row_delimitter;
+	column_opt.show_address   = false;
+	column_opt.column_output  = false;
+	column_opt.stats          = NULL; /* counted as a row of opt */
+
+	for ( c = 0; c < outfile->ncolumns; c++ ) {
+		size_t offset = (size_t)c * len;
+		file_t* column = &outfile->columns[c];
+
+		while ( offset + len <= memory->size ) {
+			size_t n;
+
+			memory_init( &view );
+			if ( len > COLUMN_TILE_SIZE ) {
+				/* a value is larger than tile */
+				view.data = &memory->data[offset];
+				view.size = len;
+				offset += row_size;
+			} else {
+				view.data = tile;
+				for ( n = 0; n < per_tile && offset + len <= memory->size; n++ ) {
+					memcpy( &tile[n * len], &memory->data[offset], len );
+					offset += row_size;
+				}
+				view.size = n * len;
+			}
+			view.length = view.size;
+
+			if ( opt->output_type == BINARY ) {
+				file_write( column, &view );
+			} else {
+				(void)bldump_write( &view, column, &column_opt );
+			}
+		}
+	}
+	return true;
+}
+
 void to_printable( memory_t* memory )
 {
 	size_t i;
@@ -467,16 +1320,44 @@ void options_reset( options_t* opt )
 	/*** input ***/
 	opt->start_address  = 0;
 	opt->end_address    = 0;
+	opt->ranges         = NULL;
+	opt->range_count    = 0;
+	opt->batch_name     = NULL;
+	opt->jobs           = 0;
+	opt->diff           = false;
+	opt->diff_name      = NULL;
+	opt->watch_interval = 0;
+	opt->watch_passes   = 0;
+	opt->follow         = false;
+	opt->serve_name     = NULL;
+	opt->stats          = NULL;
+	opt->verbose        = -1;
+	opt->stride         = 0;
+	opt->stride_offset  = 0;
+	opt->stride_count   = 0;
+	opt->decompress     = false;
+	opt->index_name     = NULL;
+	opt->where          = NULL;
 
 	/*** container ***/
 	opt->data_length    = 0;
 	opt->data_fields    = 0;
 	opt->data_order[0]  = -1;
+	opt->layout         = NULL;
+	opt->layout_fields  = 0;
+	opt->data_bits      = 0;
+	opt->lsb_first      = false;
 
 	/*** outfile ***/
 	opt->output_type    = HEXADECIMAL;
+	opt->npy_output     = false;
+	opt->column_output  = false;
 	opt->output_format  = NULL;
 	opt->show_address   = false;
+	opt->reverse        = false;
+	opt->compress       = COMPRESS_NONE;
+	opt->compress_level = 0;
+	opt->tee            = NULL;
 	opt->col_delimitter  = NULL;
 	opt->row_delimitter  = NULL;
 }
@@ -508,6 +1389,44 @@ bool options_clear( options_t* opt )
 	} else {
 		retval = false;
 	}
+	if ( opt->layout != NULL ) {
+		free( opt->layout );
+		opt->layout = NULL;
+		opt->layout_fields = 0;
+	}
+	if ( opt->ranges != NULL ) {
+		free( opt->ranges );
+		opt->ranges = NULL;
+		opt->range_count = 0;
+	}
+	if ( opt->stats != NULL ) {
+		free( opt->stats );
+		opt->stats = NULL;
+	}
+	if ( opt->serve_name != NULL ) {
+		free( opt->serve_name );
+		opt->serve_name = NULL;
+	}
+	if ( opt->batch_name != NULL ) {
+		free( opt->batch_name );
+		opt->batch_name = NULL;
+	}
+	if ( opt->diff_name != NULL ) {
+		free( opt->diff_name );
+		opt->diff_name = NULL;
+	}
+	if ( opt->index_name != NULL ) {
+		free( opt->index_name );
+		opt->index_name = NULL;
+	}
+	if ( opt->tee != NULL ) {
+		tee_free( opt->tee );
+		opt->tee = NULL;
+	}
+	if ( opt->where != NULL ) {
+		where_free( opt->where );
+		opt->where = NULL;
+	}
 
 	return retval;
 }
@@ -525,6 +1444,7 @@ bool options_load( options_t* opt, int argc, char* argv[] )
 	int i;
 	size_t a; /* for macro */
 	char *sub;
+	const char* where = NULL; /* compiled after the fields are set */
 
 #define strlcmp(l,r) (strncmp(l,r,strlen(l)))
 #define ARG_FLAG(s) (strcmp(s,argv[i])==0)
@@ -586,6 +1506,68 @@ bool options_load( options_t* opt, int argc, char* argv[] )
 			(void)verbose_printf( VERB_DEBUG, "bldump: set order len=%d pat=", opt->data_length );
 			for ( j=0; j<opt->data_length; j++ ) (void)verbose_printf( VERB_DEBUG, "%2d ", opt->data_order[j] );
 			(void)verbose_printf( VERB_DEBUG, "\n" );
+		} else if ( ARG_FLAG("-z") || ARG_FLAG("--decompress") ) {
+			opt->decompress = true;
+		} else if ( ARG_LPARAM("--index=") ) {
+			opt->decompress = true;
+			opt->index_name = strclone( sub );
+		} else if ( ARG_LPARAM("--where=") ) {
+			where = sub;
+		} else if ( ARG_LPARAM("--ranges=") ) {
+			if ( ranges_parse( opt, sub ) == false ) {
+				return false;
+			}
+		} else if ( ARG_LPARAM("--batch=") ) {
+			opt->batch_name = strclone( sub );
+		} else if ( ARG_FLAG("--watch") ) {
+			opt->watch_interval = 1000;
+		} else if ( ARG_LPARAM("--watch=") ) {
+			char* tail;
+			opt->watch_interval = strtoul( sub, &tail, 0 );
+			opt->watch_passes   = (*tail == ',') ? strtoul( &tail[1], NULL, 0 ) : 0;
+			if ( opt->watch_interval == 0 ) {
+				(void)verbose_printf( VERB_ERR, "Error: wrong interval of --watch - %s\n", sub );
+				return false;
+			}
+		} else if ( ARG_FLAG("--follow") ) {
+			opt->follow = true;
+		} else if ( ARG_FLAG("--diff") ) {
+			opt->diff = true;
+		} else if ( ARG_LPARAM("--jobs=") ) {
+			opt->jobs = (int)strtoul( sub, NULL, 0 );
+		} else if ( ARG_LPARAM("--serve=") ) {
+			opt->serve_name = strclone( sub );
+		} else if ( ARG_LPARAM("--stride=") ) {
+			opt->stride = (size_t)strtoul( sub, NULL, 0 );
+		} else if ( ARG_LPARAM("--offset=") ) {
+			opt->stride_offset = (size_t)strtoul( sub, NULL, 0 );
+		} else if ( ARG_LPARAM("--count=") ) {
+			opt->stride_count = (size_t)strtoul( sub, NULL, 0 );
+		} else if ( ARG_LPARAM("--bits=") ) {
+			opt->data_bits = (unsigned int)strtoul( sub, NULL, 0 );
+			if ( opt->data_bits == 0 || opt->data_bits > 56 ) {
+				(void)verbose_printf( VERB_ERR, "Error: bits is out of range(1-56) - %s\n", sub );
+				return false;
+			}
+		} else if ( ARG_FLAG("--lsb-first") ) {
+			opt->lsb_first = true;
+		} else if ( ARG_FLAG("--stats") || ARG_FLAG("--stats=json") ) {
+			if ( opt->stats == NULL ) {
+				opt->stats = (stats_t*)calloc( 1, sizeof(stats_t) );
+				if ( opt->stats == NULL ) {
+					(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+					return false;
+				}
+			}
+			opt->stats->json = ARG_FLAG("--stats=json");
+		} else if ( ARG_LPARAM("--layout=") ) {
+			if ( opt->data_length != 0 ) {
+				(void)verbose_printf( VERB_ERR, "Error: can't set opt --layout with -r or -l.\n" );
+				return false;
+			}
+			if ( layout_parse( opt, sub ) == false ) {
+				return false;
+			}
 
 		/* output */
 		} else if ( ARG_FLAG("-a") || ARG_FLAG("--show-address") ) {
@@ -600,13 +1582,55 @@ bool options_load( options_t* opt, int argc, char* argv[] )
 			opt->output_format = "%llu";
 		} else if ( ARG_FLAG("-b") || ARG_FLAG("--binary") ) {
 			opt->output_type = BINARY;
+		} else if ( ARG_FLAG("--npy") ) {
+			opt->npy_output = true;
+		} else if ( ARG_FLAG("--columns") ) {
+			opt->column_output = true;
+		} else if ( ARG_LPARAM("--compress=") ) {
+			if ( compress_parse( sub, &opt->compress, &opt->compress_level ) == false ) {
+				return false;
+			}
+		} else if ( ARG_LPARAM("--out=") ) {
+			if ( tee_parse( opt, sub ) == false ) {
+				return false;
+			}
+		} else if ( ARG_FLAG("--reverse") ) {
+			opt->reverse = true;
 		} else if ( ARG_FLAG("-A") || ARG_FLAG("--ascii") ) {
 			opt->output_type = ASCII;
 			opt->output_format = "%c";
+		} else if ( ARG_LPARAM("--float=") ) {
+			unsigned long bits;
+			char* tail;
+			size_t j;
+			if ( opt->data_length != 0 ) {
+				(void)verbose_printf( VERB_ERR, "Error: can't set opt --float with -r or -l.\n" );
+				return false;
+			}
+			bits = (sub[0] == 'f') ? strtoul( &sub[1], &tail, 10 ) : 0;
+			switch ( bits ) {
+				case 16: opt->output_type = FLOAT16; break;
+				case 32: opt->output_type = FLOAT32; break;
+				case 64: opt->output_type = FLOAT64; break;
+				default:
+					(void)verbose_printf( VERB_ERR, "Error: unsupported float type - %s\n", sub );
+					return false;
+			}
+			opt->data_length = (size_t)bits / 8;
+			if ( strcmp( tail, "le" ) == 0 ) {
+				/* reverse byte-order like as -r 3210 */
+				for ( j = 0; j < opt->data_length; j++ ) {
+					opt->data_order[j] = (int)(opt->data_length - 1 - j);
+				}
+			} else if ( tail[0] != '\0' && strcmp( tail, "be" ) != 0 ) {
+				(void)verbose_printf( VERB_ERR, "Error: unsupported float type - %s\n", sub );
+				return false;
+			}
 
 		/* debug */
 		} else if ( ARG_SPARAM("-v") || ARG_LPARAM("--verbose=") ) {
 			verbose_level = (unsigned int)strtoul( sub, NULL, 0 ); 
+			opt->verbose  = (int)verbose_level;
 
 		/* error */
 		} else if ( argv[i][0] == '-' ) {
@@ -618,7 +1642,11 @@ bool options_load( options_t* opt, int argc, char* argv[] )
 	}
 
 	/* file name */
-	if ( argc - i > 0 ) {
+	if ( opt->batch_name != NULL ) {
+		/* file names are in the batch list */
+	} else if ( opt->serve_name != NULL ) {
+		/* file names are in the requests */
+	} else if ( argc - i > 0 ) {
 		assert( strlen(argv[i]) != 0 );
 		opt->infile_name = strclone( argv[i] );
 		i++;
@@ -626,6 +1654,13 @@ bool options_load( options_t* opt, int argc, char* argv[] )
 		(void)verbose_printf( VERB_ERR, "Error: not found argument - infile\n" );
 		return false;
 	}
+	if ( opt->diff == true && argc - i > 0 ) {
+		opt->diff_name = strclone( argv[i] );
+		i++;
+	} else if ( opt->diff == true ) {
+		(void)verbose_printf( VERB_ERR, "Error: not found argument - file of --diff\n" );
+		return false;
+	}
 
 	if ( argc - i > 0 ) {
 		assert( strlen(argv[i]) != 0 );
@@ -643,15 +1678,311 @@ bool options_load( options_t* opt, int argc, char* argv[] )
 		opt->row_delimitter  = strclone( "\n" );
 	}
 
+	if ( opt->column_output == true && (opt->npy_output == true || opt->data_bits > 0 || opt->layout != NULL) ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --columns with --npy, --bits or --layout.\n" );
+		return false;
+	}
+	if ( opt->data_bits > 0 && opt->npy_output == true ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --npy with --bits.\n" );
+		return false;
+	}
+	if ( opt->data_bits > 0 && (opt->data_length != 0 || opt->layout != NULL) ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --bits with -r, -l, --float or --layout.\n" );
+		return false;
+	}
+	if ( opt->range_count > 0 && (opt->search_length > 0 || opt->stride > 0
+		|| opt->npy_output == true || opt->column_output == true) ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --ranges with -S, --stride, --npy or --columns.\n" );
+		return false;
+	}
+	if ( opt->reverse == true && (opt->npy_output == true || opt->column_output == true || opt->layout != NULL
+		|| opt->data_bits > 0 || opt->range_count > 0 || opt->stride > 0 || opt->batch_name != NULL || opt->stats != NULL) ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --reverse with --npy, --columns, --layout, --bits, --ranges, --stride, --batch or --stats.\n" );
+		return false;
+	}
+	if ( opt->diff_name != NULL && (opt->npy_output == true || opt->column_output == true || opt->range_count > 0
+		|| opt->stride > 0 || opt->search_length > 0 || opt->reverse == true || opt->stats != NULL) ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --diff with --npy, --columns, --ranges, --stride, -S, --reverse or --stats.\n" );
+		return false;
+	}
+	if ( opt->watch_interval > 0 && (opt->npy_output == true || opt->column_output == true || opt->range_count > 0
+		|| opt->stride > 0 || opt->search_length > 0 || opt->batch_name != NULL || opt->reverse == true
+		|| opt->diff_name != NULL || opt->stats != NULL) ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --watch with --npy, --columns, --ranges, --stride, -S, --batch, --reverse, --diff or --stats.\n" );
+		return false;
+	}
+	if ( opt->follow == true && (opt->npy_output == true || opt->column_output == true || opt->range_count > 0
+		|| opt->stride > 0 || opt->batch_name != NULL || opt->reverse == true || opt->diff_name != NULL
+		|| opt->watch_interval > 0 || opt->stats != NULL) ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --follow with --npy, --columns, --ranges, --stride, --batch, --reverse, --diff, --watch or --stats.\n" );
+		return false;
+	}
+	if ( opt->decompress == true && (opt->reverse == true
+		|| opt->watch_interval > 0 || opt->follow == true) ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt -z with --reverse, --watch or --follow.\n" );
+		return false;
+	}
+	if ( opt->compress != COMPRESS_NONE && (opt->npy_output == true || opt->column_output == true
+		|| opt->batch_name != NULL || opt->reverse == true || opt->diff_name != NULL
+		|| opt->watch_interval > 0 || opt->follow == true) ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --compress with --npy, --columns, --batch, --reverse, --diff, --watch or --follow.\n" );
+		return false;
+	}
+	if ( opt->tee != NULL && (opt->column_output == true || opt->range_count > 0 || opt->batch_name != NULL
+		|| opt->serve_name != NULL || opt->reverse == true || opt->diff_name != NULL
+		|| opt->watch_interval > 0 || opt->follow == true) ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --out with --columns, --ranges, --batch, --serve, --reverse, --diff, --watch or --follow.\n" );
+		return false;
+	}
+	if ( where != NULL && (opt->column_output == true || opt->reverse == true || opt->diff_name != NULL) ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --where with --columns, --reverse or --diff.\n" );
+		return false;
+	}
+	if ( opt->index_name != NULL && opt->batch_name != NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --index with --batch.\n" );
+		return false;
+	}
+	if ( opt->stride > 0 && (opt->search_length > 0 || opt->data_bits > 0) ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --stride with -S or --bits.\n" );
+		return false;
+	}
 	if ( opt->data_length == 0 ) {
 		opt->data_length = 1;
 	}
+	if ( opt->stride > 0 && opt->stride_count > 0 && opt->data_fields == 0 ) {
+		opt->data_fields = (int)((opt->stride_count + opt->data_length - 1) / opt->data_length);
+	}
 	if ( opt->data_fields == 0 ) {
-		opt->data_fields = 16;
+		opt->data_fields = (opt->layout != NULL) ? 1 : 16;
+	}
+	if ( opt->stride > 0 && opt->stride_count == 0 ) {
+		opt->stride_count = opt->data_length * (size_t)opt->data_fields;
 	}
 	if ( opt->output_format == NULL ) {
 		opt->output_format = "%02x";
 	}
+	if ( where != NULL ) {
+		opt->where = where_compile( opt, where );
+		if ( opt->where == NULL ) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*** field decoders ***/
+static uint64_t decode_u8( const data_t* d )
+{
+	return (uint64_t)d[0];
+}
+static uint64_t decode_u16be( const data_t* d )
+{
+	return ((uint64_t)d[0] << 8) | (uint64_t)d[1];
+}
+static uint64_t decode_u16le( const data_t* d )
+{
+	return ((uint64_t)d[1] << 8) | (uint64_t)d[0];
+}
+static uint64_t decode_u32be( const data_t* d )
+{
+	return (decode_u16be( &d[0] ) << 16) | decode_u16be( &d[2] );
+}
+static uint64_t decode_u32le( const data_t* d )
+{
+	return (decode_u16le( &d[2] ) << 16) | decode_u16le( &d[0] );
+}
+static uint64_t decode_u64be( const data_t* d )
+{
+	return (decode_u32be( &d[0] ) << 32) | decode_u32be( &d[4] );
+}
+static uint64_t decode_u64le( const data_t* d )
+{
+	return (decode_u32le( &d[4] ) << 32) | decode_u32le( &d[0] );
+}
+
+/*!
+ * @brief parse --layout spec into the field table.
+ *
+ * The spec is a comma separated list of fields, and each field is
+ * one of u8, s8, {u,s}{16,32,64}{le,be}, f{16,32,64}{le,be} and skip<num>.
+ * Omitting the endian means big endian like as -l.
+ * data_length is set to the record size.
+ *
+ * @param[out] opt option parameter.
+ * @param[in] spec layout spec.
+ * @retval true success.
+ * @retval false failure.
+ */
+bool layout_parse( options_t* opt, const char* spec )
+{
+	const char* p;
+	int n = 1;
+	size_t offset = 0;
+	field_t* table;
+
+	for ( p = spec; *p != '\0'; p++ ) {
+		if ( *p == ',' ) n++;
+	}
+	table = (field_t*)malloc( sizeof(field_t) * (size_t)n );
+	if ( table == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		return false;
+	}
+
+	n = 0;
+	p = spec;
+	while ( true ) {
+		field_t* field = &table[n];
+		const char* end = strchr( p, ',' );
+		size_t len = (end != NULL) ? (size_t)(end - p) : strlen( p );
+		char* tail;
+
+		memset( field, 0, sizeof(field_t) );
+		field->offset = offset;
+
+		if ( len > 4 && strncmp( p, "skip", 4 ) == 0 ) {
+			field->type = FIELD_SKIP;
+			field->size = (size_t)strtoul( &p[4], &tail, 0 );
+		} else if ( len > 1 && (p[0] == 'u' || p[0] == 's' || p[0] == 'f') ) {
+			unsigned long bits = strtoul( &p[1], &tail, 10 );
+			field->type = (p[0] == 'u') ? FIELD_UNSIGNED : (p[0] == 's') ? FIELD_SIGNED : FIELD_FLOAT;
+			field->size = (size_t)bits / 8;
+			if ( bits % 8 != 0 ) field->size = 0;
+			if ( strncmp( tail, "le", 2 ) == 0 ) {
+				field->little = true;
+				tail += 2;
+			} else if ( strncmp( tail, "be", 2 ) == 0 ) {
+				tail += 2;
+			}
+		} else {
+			tail = (char*)p;
+		}
+
+		switch ( field->size ) {
+			case 1: field->decode = decode_u8; break;
+			case 2: field->decode = field->little ? decode_u16le : decode_u16be; break;
+			case 4: field->decode = field->little ? decode_u32le : decode_u32be; break;
+			case 8: field->decode = field->little ? decode_u64le : decode_u64be; break;
+			default: break;
+		}
+		if ( tail != p + len || field->size == 0
+			|| (field->type != FIELD_SKIP && field->decode == NULL)
+			|| (field->type == FIELD_FLOAT && field->size < 2) ) {
+			(void)verbose_printf( VERB_ERR, "Error: wrong layout field - %.*s\n", (int)len, p );
+			free( table );
+			return false;
+		}
+
+		offset += field->size;
+		n++;
+		if ( end == NULL ) {
+			break;
+		}
+		p = end + 1;
+	}
+
+	if ( opt->layout != NULL ) {
+		free( opt->layout );
+	}
+	opt->layout        = table;
+	opt->layout_fields = n;
+	opt->data_length   = offset;
+	(void)verbose_printf( VERB_DEBUG, "bldump: set layout fields=%d record=%d\n", n, offset );
+
+	return true;
+}
+
+/*!
+ * @brief parse --ranges list.
+ *
+ * The list is ranges of <start>-<end> or <start>+<size> separated by ','
+ * or white spaces. '@<file>' reads the list from <file>.
+ *
+ * @param[out] opt option parameter.
+ * @param[in] spec range list.
+ * @retval true success.
+ * @retval false failure.
+ */
+bool ranges_parse( options_t* opt, const char* spec )
+{
+	char* list;
+	char* p;
+	int n = 1;
+	range_t* ranges;
+
+	/*** load list ***/
+	if ( spec[0] == '@' ) {
+		FILE* fp = fopen( &spec[1], "rb" );
+		long size;
+		if ( fp == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't open range list - %s\n", &spec[1] );
+			return false;
+		}
+		(void)fseek( fp, 0, SEEK_END );
+		size = ftell( fp );
+		(void)fseek( fp, 0, SEEK_SET );
+		list = (char*)malloc( (size_t)size + 1 );
+		if ( list != NULL ) {
+			list[fread( list, 1, (size_t)size, fp )] = '\0';
+		}
+		(void)fclose( fp );
+	} else {
+		list = strclone( spec );
+	}
+	if ( list == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		return false;
+	}
+
+	for ( p = list; *p != '\0'; p++ ) {
+		if ( *p == ',' || isspace( (unsigned char)*p ) ) n++;
+	}
+	ranges = (range_t*)malloc( sizeof(range_t) * (size_t)n );
+	if ( ranges == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		free( list );
+		return false;
+	}
+
+	/*** parse ***/
+	n = 0;
+	p = list;
+	while ( *p != '\0' ) {
+		char* tail;
+		if ( *p == ',' || isspace( (unsigned char)*p ) ) {
+			p++;
+			continue;
+		}
+		ranges[n].start = (size_t)strtoul( p, &tail, 0 );
+		if ( *tail == '-' ) {
+			ranges[n].end = (size_t)strtoul( tail + 1, &p, 0 );
+		} else if ( *tail == '+' ) {
+			ranges[n].end = ranges[n].start + (size_t)strtoul( tail + 1, &p, 0 );
+		} else {
+			p = tail;
+		}
+		if ( p == tail + 1 || p == tail || ranges[n].end < ranges[n].start
+			|| (*p != '\0' && *p != ',' && isspace( (unsigned char)*p ) == 0) ) {
+			(void)verbose_printf( VERB_ERR, "Error: wrong range - %s\n", tail );
+			free( ranges );
+			free( list );
+			return false;
+		}
+		n++;
+	}
+	free( list );
+
+	if ( n == 0 ) {
+		(void)verbose_printf( VERB_ERR, "Error: empty range list.\n" );
+		free( ranges );
+		return false;
+	}
+	if ( opt->ranges != NULL ) {
+		free( opt->ranges );
+	}
+	opt->ranges      = ranges;
+	opt->range_count = n;
 
 	return true;
 }
@@ -717,6 +2048,42 @@ void memory_clear( memory_t* memory )
 	memory->address = 0;
 }
 
+/*!
+ * @brief change byte-order of data by -r.
+ * @param[in,out] memory memory data.
+ * @param[in] opt
+ */
+void memory_reorder( memory_t* memory, options_t* opt )
+{
+	size_t i, j, k, idx = 0;
+
+	if ( opt->data_order[0] == -1 ) {
+		return;
+	}
+
+	for ( i=0; i<memory->size; i+=opt->data_length ) {
+		uint64_t data = 0;
+		for ( j=0, k=(opt->data_length-1)*8;
+			j<opt->data_length; j++, k-=8 ) {
+			size_t loc=i+opt->data_order[j];
+			if ( loc < memory->size ) {
+				data = data | (((uint64_t)memory->data[loc]) << k);
+			}
+		}
+
+		for ( j=0, k=(opt->data_length-1)*8;
+			(j<opt->data_length) && (i+j) < memory->length;
+			j++, k-=8 ) {
+			idx = i+j;
+			memory->data[i+j] = (data_t) (data >> k);
+		}
+	}
+	if ( idx >= memory->size ) {
+		assert( idx <= memory->length );
+		memory->size = idx;
+	}
+}
+
 /*!
  * @brief free memory.
  * @param[in] memory memory data.
@@ -762,6 +2129,8 @@ void file_reset( file_t* file )
 	file->name     = NULL;
 	file->position = 0L;
 	file->length   = 0L;
+	file->columns  = NULL;
+	file->ncolumns = 0;
 }
 
 /*!
@@ -781,30 +2150,32 @@ bool file_open( file_t* file, const char* name, const char* mode )
 
 	/*** file open ***/
 	file->name = strclone( name );
-	file->ptr  = fopen( name, mode );
-	if ( file->ptr == NULL ) {
-		return false;
-	}
-
-	/*** get file length ***/
-	if ( mode[0] == 'r' ) { /* read mode */
-		(void)fseek( file->ptr, 0, SEEK_END );
-		file->length = (size_t) ftell( file->ptr );
-		(void)fseek( file->ptr, 0, SEEK_SET);
+	if ( mode[0] == 'r' ) { /* read mode, by a backend with the length */
+		if ( input_open( file, name ) == false ) {
+			return false;
+		}
+	} else {
+		file->ptr = fopen( name, mode );
+		if ( file->ptr == NULL ) {
+			return false;
+		}
 	}
 
 	(void)verbose_printf( VERB_LOG,
-		"bldump: open file - name=%s, ptr=0x%x, length=%d, pos=0x%x\n",
+		"bldump: open file - name=%s, backend=%s, length=%lu, pos=0x%lx\n",
 		(file->name == NULL) ? "(NULL)" : file->name,
-		file->ptr,
-		file->length,
-		file->position );
+		(file->ops == NULL) ? "stdio" : file->ops->name,
+		(unsigned long)file->length,
+		(unsigned long)file->position );
 
 	return true;
 }
 
 /*!
  * @brief file seek position.
+ *
+ * An infile can be seeked in the buffer of file_t, even if the backend
+ * can't seek back.
  * @param[in] file file pointer.
  * @param[in] offset offset address.
  * @retval 0 success.
@@ -813,9 +2184,15 @@ bool file_open( file_t* file, const char* name, const char* mode )
 int file_seek( file_t* file, size_t offset )
 {
 	int retval;
-	retval = fseek( file->ptr, (long)offset, SEEK_SET );
+	if ( file->ops == NULL ) {
+		retval = fseek( file->ptr, (long)offset, SEEK_SET );
+	} else {
+		bool buffered = offset >= file->buf_offset && offset <= file->buf_offset + file->buf_size;
+		retval = ((off_t)offset >= 0 && (buffered == true || file->ops->seek( file->handle, offset ) == true)) ? 0 : -1;
+	}
 	if ( retval == 0 ) {
 		file->position = offset;
+		file->eof      = false;
 	} else {
 		(void)verbose_printf( VERB_ERR, "Error: fseek error - 0x%x\n", offset );
 	}
@@ -833,7 +2210,11 @@ bool file_close( file_t* file )
 {
 	bool retval = true;
 
-	if ( (file->ptr == STDOUT) || (file->ptr == STDERR) || (file->ptr == STDIN) ) {
+	if ( file->ops != NULL ) {
+		file->ops->close( file->handle );
+		free( file->buf );
+		free( file->batch );
+	} else if ( (file->ptr == STDOUT) || (file->ptr == STDERR) || (file->ptr == STDIN) ) {
 	} else if ( file->ptr != NULL ) {
 		(void)fclose( file->ptr );
 	} else {
@@ -844,6 +2225,13 @@ bool file_close( file_t* file )
 	} else {
 		retval = false;
 	}
+	if ( file->columns != NULL ) {
+		int i;
+		for ( i = 0; i < file->ncolumns; i++ ) {
+			(void)file_close( &file->columns[i] );
+		}
+		free( file->columns );
+	}
 
 	file_reset( file );
 
@@ -866,25 +2254,24 @@ bool file_read( file_t* file, memory_t* memory, size_t nmemb )
 
 	assert( nmemb <= memory->length - memory->size ); /* nmemb must be set to 'memory' memory area. */
 
-	if ( feof(file->ptr) == 1 ) {
+	if ( file->eof == true ) {
 		is = true;
 	} else if ( nmemb == 0 ) {
 		is = false;
 	} else {
 		pos   = file->position;
-		reads = fread( &memory->data[memory->size], size, nmemb, file->ptr );
+		reads = file_fetch( file, &memory->data[memory->size], size * nmemb );
 	
-		(void)verbose_printf( VERB_LOG, "bldump: fread - ret=%d, size=%d nmemb=%d fp=%x mem=%x\n", reads, size, nmemb, file->ptr, memory->data );
+		(void)verbose_printf( VERB_TRACE, "bldump: fetch - ret=%d, size=%d nmemb=%d mem=%x\n", reads, size, nmemb, memory->data );
 
 		if ( reads == 0 ) {
-			if ( feof(file->ptr) == 1 ) {
+			if ( file->eof == true ) {
 				is = true;
 			}
 		} else {
 			if ( memory->size == 0 ) {
 				memory->address = pos;
 			}
-			file->position += reads;
 			memory->size   += reads;
 			is = true;
 		}
@@ -893,6 +2280,217 @@ bool file_read( file_t* file, memory_t* memory, size_t nmemb )
 	return is;
 }
 
+/*!
+ * @brief borrow a window of infile at the position, without copy.
+ *
+ * The window is of the buffer of file_t filled by the backend, and
+ * valid until the next access to file. The position isn't moved.
+ * @param[in,out] file infile.
+ * @param[in] size wanted bytes.
+ * @param[out] avail bytes of the window, up to size and the buffer,
+ *                   0 at the end or on failure.
+ * @return window, NULL if avail is 0.
+ */
+const data_t* file_borrow( file_t* file, size_t size, size_t* avail )
+{
+	const file_ops_t* ops = file->ops;
+	size_t pos = file->position;
+	size_t off;
+
+	*avail = 0;
+	if ( file->buf == NULL ) {
+		file->buf = (data_t*)malloc( FILE_BUFFER );
+		if ( file->buf == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+			file->failed = true;
+			return NULL;
+		}
+	}
+	if ( pos < file->buf_offset || pos > file->buf_offset + file->buf_size ) {
+		file->buf_offset = pos;
+		file->buf_size   = 0;
+	}
+	off = pos - file->buf_offset;
+
+	/* move the rest to the front, and fill */
+	if ( file->buf_size - off < size && file->buf_size - off < FILE_BUFFER ) {
+		(void)memmove( file->buf, &file->buf[off], file->buf_size - off );
+		file->buf_offset = pos;
+		file->buf_size  -= off;
+		off = 0;
+		while ( file->buf_size < size && file->buf_size < FILE_BUFFER ) {
+			ssize_t n = ops->read( file->handle, &file->buf[file->buf_size], FILE_BUFFER - file->buf_size, file->buf_offset + file->buf_size );
+			if ( n < 0 ) {
+				(void)verbose_printf( VERB_ERR, "Error: can't read infile - %s\n", file->name );
+				file->failed = true;
+			}
+			if ( n <= 0 ) {
+				break;
+			}
+			file->buf_size += (size_t)n;
+		}
+	}
+	*avail = min( size, file->buf_size - off );
+	return (*avail > 0) ? &file->buf[off] : NULL;
+}
+
+/*!
+ * @brief read bytes of infile at the position, and move the position.
+ *
+ * A large read is straight into buf by the backend.
+ * @param[in,out] file infile, eof is set if it's less than size.
+ * @param[out] buf
+ * @param[in] size
+ * @return read bytes.
+ */
+size_t file_fetch( file_t* file, void* buf, size_t size )
+{
+	data_t* p = (data_t*)buf;
+	size_t done = 0;
+
+	while ( done < size && file->failed == false ) {
+		size_t pos = file->position;
+		size_t avail;
+
+		if ( size - done >= FILE_BUFFER
+			&& (pos < file->buf_offset || pos >= file->buf_offset + file->buf_size) ) {
+			ssize_t n = file->ops->read( file->handle, &p[done], size - done, pos );
+			if ( n < 0 ) {
+				(void)verbose_printf( VERB_ERR, "Error: can't read infile - %s\n", file->name );
+				file->failed = true;
+			}
+			avail = (n > 0) ? (size_t)n : 0;
+		} else {
+			const data_t* window = file_borrow( file, size - done, &avail );
+			if ( avail > 0 ) {
+				memcpy( &p[done], window, avail );
+			}
+		}
+		if ( avail == 0 ) {
+			break;
+		}
+		done += avail;
+		file->position += avail;
+	}
+	if ( done < size && file->failed == false ) {
+		file->eof = true;
+	}
+	return done;
+}
+
+/*!
+ * @brief read the records from pos into the batch of file by a pread.
+ *
+ * The batch is of the records within STRIDE_BATCH bytes, and the gaps
+ * between them are read too, instead of a syscall for each record.
+ * @retval true success, batch_size is short at the end of file.
+ * @retval false read error.
+ */
+static bool stride_batch( file_t* file, size_t pos, options_t* opt )
+{
+	size_t span = (STRIDE_BATCH / opt->stride - 1) * opt->stride + opt->stride_count;
+	size_t got  = 0;
+
+	if ( opt->end_address != 0 ) {
+		span = min( span, opt->end_address - pos );
+	}
+	if ( file->length > 0 ) {
+		span = min( span, file->length - pos );
+	}
+	if ( file->batch == NULL ) {
+		file->batch = (data_t*)malloc( STRIDE_BATCH );
+		if ( file->batch == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+			return false;
+		}
+	}
+	while ( got < span ) {
+		ssize_t n = file->ops->read( file->handle, &file->batch[got], span - got, pos + got );
+		if ( n < 0 ) {
+			(void)verbose_printf( VERB_ERR, "Error: read error - 0x%lx\n", (unsigned long)(pos + got) );
+			return false;
+		}
+		if ( n == 0 ) {
+			break;
+		}
+		got += (size_t)n;
+	}
+	file->batch_offset = pos;
+	file->batch_size   = got;
+	return true;
+}
+
+/*!
+ * @brief read a part of the record.
+ *
+ * Reads 'stride_count' bytes at 'stride_offset' of the record which starts
+ * at file->position, and moves file->position to the next record.
+ * If the gap to the next record is large, the records of STRIDE_BATCH
+ * bytes are read at once by the backend, or each record if the stride
+ * is larger than a half of it, so that only the wanted pages are read.
+ * Otherwise through file_fetch().
+ *
+ * @param[in] file file pointer.
+ * @param[out] memory write dump data.
+ * @param[in] opt
+ * @retval true success, memory->size is 0 at the end of file.
+ * @retval false failure, or reached to the end address.
+ */
+bool file_read_stride( file_t* file, memory_t* memory, options_t* opt )
+{
+	size_t record = file->position;
+	size_t pos    = file->position + opt->stride_offset;
+	size_t nmemb  = opt->stride_count;
+	size_t reads  = 0;
+
+	assert( nmemb <= memory->length );
+
+	if ( opt->end_address != 0 ) {
+		if ( pos >= opt->end_address ) {
+			return false;
+		}
+		nmemb = min( nmemb, opt->end_address - pos );
+	}
+	if ( file->length > 0 && pos >= file->length ) {
+		return true; /* EOF */
+	}
+
+	if ( opt->stride - opt->stride_count >= STRIDE_PREAD_GAP && opt->stride > STRIDE_BATCH / 2 ) {
+		ssize_t ret = file->ops->read( file->handle, memory->data, nmemb, pos );
+		if ( ret < 0 ) {
+			(void)verbose_printf( VERB_ERR, "Error: read error - 0x%lx\n", (unsigned long)pos );
+			return false;
+		}
+		reads = (size_t)ret;
+	} else if ( opt->stride - opt->stride_count >= STRIDE_PREAD_GAP ) {
+		if ( pos < file->batch_offset || pos + nmemb > file->batch_offset + file->batch_size ) {
+			if ( stride_batch( file, pos, opt ) == false ) {
+				return false;
+			}
+		}
+		if ( pos < file->batch_offset + file->batch_size ) {
+			reads = min( nmemb, file->batch_offset + file->batch_size - pos );
+			memcpy( memory->data, &file->batch[pos - file->batch_offset], reads );
+		}
+	} else {
+		if ( file_seek( file, pos ) != 0 ) {
+			return false;
+		}
+		reads = file_fetch( file, memory->data, nmemb );
+		if ( file->failed == true ) {
+			return false;
+		}
+		file->position = record;
+	}
+	(void)verbose_printf( VERB_TRACE, "bldump: read stride - ret=%d, pos=%d nmemb=%d\n", reads, pos, nmemb );
+
+	memory->address = pos;
+	memory->size    = reads;
+	file->position += opt->stride;
+
+	return true;
+}
+
 /*!
  * @brief write data.
  * @param[out] file file pointer.
@@ -918,6 +2516,8 @@ bool file_search( file_t* file, memory_t* memory, options_t* opt )
 	uint64_t mask = (uint64_t)((0x1uLL << opt->search_length) - 0x1uLL);
 	uint64_t read = 0;
 	int search_bytes = opt->search_length/8;
+	int charged = 0;
+	bool found = false;
 
 	DEBUG_ASSERT( memory->size == 0 );
 	DEBUG_ASSERT( opt->search_length > 0 );
@@ -925,53 +2525,47 @@ bool file_search( file_t* file, memory_t* memory, options_t* opt )
 	(void)verbose_printf( VERB_TRACE, "bldump: file_search - mask=0x%llx pat=0x%llx\n",
 		mask, opt->search_pattern );
 
-	if ( feof(file->ptr) != 0 ) {
+	if ( file->eof == true ) {
 		(void)verbose_printf( VERB_TRACE, "bldump: detected EOF on file searching.\n" );
 		return false;
 	}
 
-	/*** charge buffer ***/
-	for ( i = 0; i < search_bytes; i++ ) {
-		if ( (opt->end_address > 0) && (opt->end_address <= (size_t)ftell(file->ptr)) ) {
-			(void)verbose_printf( VERB_TRACE, "bldump: detected end address on file searching.\n" );
-			return false;
-		}
-
-		read = (read << 8) | ((uint8_t)fgetc(file->ptr));
-
-		if ( feof(file->ptr) != 0 ) {
-			(void)verbose_printf( VERB_TRACE, "bldump: detected EOF on file searching.\n" );
-			return false;
-		}
-	}
+	/*** search for pattern in the windows, after charging search_bytes ***/
+	while ( found == false ) {
+		const data_t* window;
+		size_t want = FILE_BUFFER;
+		size_t avail, k;
 
-	/*** search for pattern ***/
-	while ( (read & mask) != opt->search_pattern ) {
-		if ( opt->end_address > 0 && opt->end_address <= (size_t)ftell(file->ptr) ) {
-			(void)verbose_printf( VERB_TRACE, "bldump: detected end address on file searching.\n" );
-			return false;
+		if ( opt->end_address > 0 ) {
+			if ( opt->end_address <= file->position ) {
+				(void)verbose_printf( VERB_TRACE, "bldump: detected end address on file searching.\n" );
+				return false;
+			}
+			want = min( want, opt->end_address - file->position );
 		}
-
-		read = (read << 8) | ((uint8_t)fgetc(file->ptr));
-
-		if ( feof(file->ptr) != 0 ) {
+		window = file_borrow( file, want, &avail );
+		if ( avail == 0 ) {
 			(void)verbose_printf( VERB_TRACE, "bldump: detected EOF on file searching.\n" );
+			file->eof = true;
 			return false;
 		}
-	};
+		for ( k = 0; k < avail && found == false; ) {
+			read = (read << 8) | window[k++];
+			found = (++charged >= search_bytes && (read & mask) == opt->search_pattern);
+		}
+		file->position += k;
+	}
 
 	/*** read file and write to memory ***/
 	assert( (read & mask) == opt->search_pattern );
 
-	file->position  = (size_t) ftell(file->ptr);
 	memory->address = file->position - search_bytes;
 	
-	for ( j=0, i=search_bytes-1; i >= 0; i--, j++ ) {
-		if ( i < (int)memory->length ) {
-			memory->data[j] = (data_t)(opt->search_pattern >> (i*8));
-		}
+	/* a record shorter than the pattern keeps the leading bytes of it */
+	for ( j=0, i=search_bytes-1; i >= 0 && j < (int)memory->length; i--, j++ ) {
+		memory->data[j] = (data_t)(opt->search_pattern >> (i*8));
 	}
-	memory->size = (size_t)search_bytes;
+	memory->size = (size_t)j;
 
 	return true;
 }
@@ -10,50 +10,165 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <sys/types.h>
 
 /******************
  * Data structure *
  ******************/
 /*** enum ***/
 typedef enum {
-	HEXADECIMAL = 0, DECIMAL, UDECIMAL, BINARY, ASCII
+	HEXADECIMAL = 0, DECIMAL, UDECIMAL, BINARY, ASCII,
+	FLOAT16, FLOAT32, FLOAT64
 } OUTPUT_TYPE;
 
+typedef enum {
+	COMPRESS_NONE = 0, COMPRESS_GZIP, COMPRESS_ZSTD
+} COMPRESS_TYPE;
+
+typedef enum {
+	FIELD_SKIP = 0, FIELD_UNSIGNED, FIELD_SIGNED, FIELD_FLOAT
+} FIELD_TYPE;
+
+/*** data_t ***/
+typedef unsigned char data_t;
+
+/*** range_t ***/
+typedef struct {
+	size_t start; /*!< start address. */
+	size_t end;   /*!< end address, not included. */
+} range_t;
+
+/*** field_t ***/
+typedef struct {
+	FIELD_TYPE type;   /*!< value type of the field. */
+	size_t     offset; /*!< byte offset in a record. */
+	size_t     size;   /*!< byte size of the field. */
+	bool       little; /*!< true if the field is little endian. */
+	uint64_t (*decode)( const data_t* data ); /*!< decoder specialized for size and endian. */
+} field_t;
+
+/*** stats_t ***/
+enum STATS_STAGE {
+	STATS_READ = 0, /*!< file_read, file_read_stride. */
+	STATS_SEARCH,   /*!< file_search. */
+	STATS_REORDER,  /*!< memory_reorder. */
+	STATS_WRITE,    /*!< bldump_write. */
+	STATS_FLUSH,    /*!< bldump_finish and flush of outfile. */
+	STATS_STAGES
+};
+
+typedef struct {
+	uint64_t ns[STATS_STAGES];    /*!< elapsed time of each stage. */
+	uint64_t calls[STATS_STAGES]; /*!< calls of each stage. */
+	uint64_t bytes_in;  /*!< bytes read from infile. */
+	uint64_t bytes_out; /*!< bytes written to outfile. */
+	uint64_t rows;      /*!< records written. */
+	uint64_t reads;     /*!< read calls to infile. */
+	uint64_t writes;    /*!< write system calls to outfile. */
+	uint64_t searches;  /*!< -S : searches. */
+	uint64_t resyncs;   /*!< -S : searches which skipped data. */
+	uint64_t skipped;   /*!< -S : skipped bytes. */
+	uint64_t rejected;  /*!< --where : rows not written. */
+	size_t   row_size;  /*!< bytes of a record. */
+	bool     json;      /*!< --stats=json */
+	FILE*    real;      /*!< outfile under the counting stream. */
+} stats_t;
+
+/*** where_t ***/
+typedef struct where_s where_t; /*!< predicate of --where, see where_compile(). */
+
+/*** tee_t ***/
+typedef struct tee_s tee_t; /*!< sinks of --out, see tee_parse(). */
+
 typedef struct {
 	char*        infile_name;  /*!< <infile> */
 	char*        outfile_name; /*!< <outfile> */
+	char*        batch_name;   /*!< --batch : list file or directory of infiles */
+	int          jobs;         /*!< --jobs : number of worker threads for --batch */
+	char*        serve_name;   /*!< --serve : unix domain socket of the daemon */
+	bool         diff;         /*!< --diff : set as soon as parsed, exits 2 for errors */
+	char*        diff_name;    /*!< --diff : file compared with infile */
+	unsigned long watch_interval; /*!< --watch : polling interval in ms, 0 if off */
+	unsigned long watch_passes;   /*!< --watch : number of passes, 0 if endless */
+	bool         follow;       /*!< --follow : dump the appends of infile */
+	stats_t*     stats;        /*!< --stats : statistics, NULL if off */
+	int          verbose;      /*!< -v : verbose level of a stream, -1 if not set */
 
 	/* input */
 	size_t       start_address;  /*!< -s : start reading address(skip bytes). */
 	size_t       end_address;    /*!< -l : end reading address */
 	uint64_t     search_pattern; /*!< -S : searching word */
 	int          search_length;  /*!< -S : searching word length */
+	range_t*     ranges;         /*!< --ranges : address ranges in requested order. */
+	int          range_count;    /*!< --ranges : number of ranges. */
+	size_t       stride;         /*!< --stride : record size to read a part of. */
+	size_t       stride_offset;  /*!< --offset : offset of reading in a record. */
+	size_t       stride_count;   /*!< --count : reading size of a record. */
+	where_t*     where;          /*!< --where : predicate of the written rows, NULL if off. */
+	bool         decompress;     /*!< -z : decompresses gzip or zstd infile. */
+	char*        index_name;     /*!< --index : seek points of compressed infile. */
 
 	/* container */
 	int			data_fields;   /*!< -f : input data fields. */
 	size_t		data_length;   /*!< -l : input data length. */
 	int			data_order[8]; /*!< -r : byte order of input data */
+	field_t*    layout;        /*!< --layout : field table of a record. */
+	int         layout_fields; /*!< --layout : number of fields in the table. */
+	unsigned int data_bits;    /*!< --bits : bit width of packed data. */
+	bool        lsb_first;     /*!< --lsb-first : bit order of packed data. */
 
 	/* output */
 	bool        show_address;   /*!< -a : data address. */
 	char*       col_delimitter; /*!< -d : delimitter of outputting column. */
 	char*       row_delimitter; /*!< delimitter of outputting row. */
-	OUTPUT_TYPE output_type;    /*!< argument -d, -u, -b */
+	OUTPUT_TYPE output_type;    /*!< argument -d, -u, -b, --float */
+	bool        npy_output;     /*!< --npy : outputs NumPy array of output_type. */
+	bool        column_output;  /*!< --columns : outputs each field to <outfile>.col<n>. */
 	char*		output_format;  /*!< output format. */
+	bool        reverse;        /*!< --reverse : parses the dump text back to binary. */
+	COMPRESS_TYPE compress;     /*!< --compress : compresses outfile by --jobs threads. */
+	int         compress_level; /*!< --compress : level of gzip or zstd. */
+	tee_t*      tee;            /*!< --out : sinks written with outfile, NULL if off. */
 
 } options_t;
 
-/*** file_t ***/
+/*** file_ops_t ***/
+/*! input backend of file_t, chosen by file_open(). */
 typedef struct {
-	FILE* ptr;       /*!< input file pointer */
+	const char* name; /*!< name of the backend. */
+	/*! read up to size bytes at offset into buf, returns read bytes, 0 at the end, -1 on failure. */
+	ssize_t (*read)( void* handle, data_t* buf, size_t size, size_t offset );
+	/*! end offset, 0 if unknown. */
+	size_t (*size)( void* handle );
+	/*! check the next read can be at offset. */
+	bool (*seek)( void* handle, size_t offset );
+	/*! close and free the handle. */
+	void (*close)( void* handle );
+} file_ops_t;
+
+/*** file_t ***/
+typedef struct file_s {
+	FILE* ptr;       /*!< output file pointer */
 	char* name;      /*!< input file name */
 	size_t position; /*!< start address to input */
 	size_t length;   /*!< input file length */
+	struct file_s* columns; /*!< --columns : output files of each field */
+	int   ncolumns;  /*!< --columns : number of column files */
+
+	/* input */
+	const file_ops_t* ops; /*!< backend of infile, NULL for outfile */
+	void*   handle;     /*!< data of the backend */
+	data_t* buf;        /*!< buffer of the backend */
+	size_t  buf_offset; /*!< offset of buf */
+	size_t  buf_size;   /*!< valid bytes of buf */
+	data_t* batch;        /*!< --stride : records read at once */
+	size_t  batch_offset; /*!< offset of batch */
+	size_t  batch_size;   /*!< valid bytes of batch */
+	bool    eof;        /*!< reached to the end */
+	bool    failed;     /*!< failed to read */
 } file_t;
 
 /*** memory_t ***/
-typedef unsigned char data_t;
-
 typedef struct {
 	size_t address; /*!< start address. */
 	data_t* data;   /*!< data buffer pointer. */
@@ -61,6 +176,17 @@ typedef struct {
 	size_t size;    /*!< valid size. */
 } memory_t;
 
+/*** bldump_t ***/
+/*! output sink of the stream, returns bytes consumed. */
+typedef size_t (*bldump_sink_t)( void* user, const char* buf, size_t size );
+typedef struct bldump_s bldump_t; /*!< stream context, see bldump_open(). */
+
+/*** watch_t ***/
+typedef struct watch_s watch_t; /*!< watch context, see watch_open(). */
+
+/*** compress_t ***/
+typedef struct compress_s compress_t; /*!< compressing outfile, see compress_attach(). */
+
 
 /***********************
  * Function assignment *
@@ -69,21 +195,35 @@ int main( int argc, char* argv[] );
 int help(void);
 
 bool bldump_setup( memory_t* memory, file_t* infile, file_t* outfile, options_t* opt );
+size_t bldump_record_size( options_t* opt );
+bool bldump_dump( memory_t* memory, file_t* infile, file_t* outfile, options_t* opt );
 bool bldump_read( memory_t* memory, file_t* infile, options_t* opt );
 bool bldump_write( memory_t* memory, file_t* outfile, options_t* opt );
+bool bldump_finish( memory_t* memory, file_t* outfile, options_t* opt );
+bool bldump_ranges( memory_t* memory, file_t* infile, file_t* outfile, options_t* opt );
 void write_hex( memory_t* memory, file_t* file, options_t* opt );
 void write_dec( memory_t* memory, file_t* outfile, options_t* opt );
+void write_float( memory_t* memory, file_t* outfile, options_t* opt );
+void write_layout( memory_t* memory, file_t* outfile, options_t* opt );
+void write_bits( memory_t* memory, file_t* outfile, options_t* opt );
+size_t bits_unpack( const data_t* data, size_t size, unsigned int width, bool lsb_first, size_t first, size_t count, uint64_t* values );
 void to_printable( memory_t* memory );
+bool write_npy( memory_t* memory, file_t* outfile, options_t* opt );
+bool write_columns( memory_t* memory, file_t* outfile, options_t* opt );
+size_t npy_header( char* buf, size_t size, options_t* opt, size_t rows );
 
 /*** options ***/
 void options_reset( /*@out@*/ options_t* opt );
 bool options_load( options_t* opt, int argc, char* argv[] );
 bool options_clear( options_t* opt );
+bool layout_parse( options_t* opt, const char* spec );
+bool ranges_parse( options_t* opt, const char* spec );
 
 /*** memory ***/
 void memory_init( /*@out@*/ memory_t* memory );
 bool memory_allocate( /*@partial@*/ memory_t* memory, size_t length );
 void memory_clear( /*@in@*/ memory_t* memory );
+void memory_reorder( memory_t* memory, options_t* opt );
 bool memory_free( /*@partial@*/ memory_t* memory );
 
 /*** file ***/
@@ -92,8 +232,71 @@ bool file_open( file_t* file, const char* name, const char* mode );
 int  file_seek( file_t* file, size_t offset );
 bool file_close( file_t* file );
 bool file_read( file_t* file, memory_t* memory, size_t nmemb );
+/*@null@*/ const data_t* file_borrow( file_t* file, size_t size, size_t* avail );
+size_t file_fetch( file_t* file, void* buf, size_t size );
 void file_write( file_t* file, memory_t* memory );
 bool file_search( file_t* file, memory_t* memory, options_t* opt );
+bool file_read_stride( file_t* file, memory_t* memory, options_t* opt );
+
+/*** batch ***/
+bool bldump_batch( options_t* opt );
+
+/*** watch ***/
+bool bldump_watch( options_t* opt );
+/*@null@*/ watch_t* watch_open( const options_t* opt );
+bool watch_pass( watch_t* ctx );
+void watch_close( /*@only@*/ watch_t* ctx );
+
+/*** input ***/
+bool input_open( file_t* file, const char* name );
+bool proc_name( const char* name );
+bool proc_open( file_t* file, const char* name );
+bool decompress_open( file_t* file, const char* index_name );
+
+/*** compress ***/
+bool compress_parse( const char* sub, COMPRESS_TYPE* type, int* level );
+/*@null@*/ compress_t* compress_attach( const options_t* opt, file_t* outfile );
+bool compress_detach( /*@only@*/ compress_t* ctx, file_t* outfile );
+
+/*** where ***/
+/*@null@*/ where_t* where_compile( const options_t* opt, const char* expr );
+bool where_match( const where_t* where, const memory_t* memory );
+void where_free( /*@only@*/ where_t* where );
+
+/*** tee ***/
+bool tee_parse( options_t* opt, const char* spec );
+bool tee_start( tee_t* tee, const options_t* opt, size_t row_size );
+void tee_push( tee_t* tee, const memory_t* memory );
+bool tee_finish( tee_t* tee );
+void tee_free( /*@only@*/ tee_t* tee );
+
+/*** follow ***/
+bool bldump_follow( options_t* opt );
+
+/*** diff ***/
+int  bldump_diff( options_t* opt );
+
+/*** reverse ***/
+bool bldump_reverse( options_t* opt );
+
+/*** stream ***/
+/*@null@*/ bldump_t* bldump_open( const options_t* opt, bldump_sink_t sink, void* user );
+bool bldump_push( bldump_t* ctx, const void* buf, size_t size );
+bool bldump_close( /*@only@*/ bldump_t* ctx );
+void bldump_verbose( bldump_t* ctx, unsigned int level, /*@null@*/ FILE* out );
+/*@null@*/ const stats_t* bldump_stats( const bldump_t* ctx );
+
+/*** serve ***/
+bool bldump_serve( options_t* opt );
+int  bldump_forward( const char* name, int argc, char* argv[] );
+
+/*** stats ***/
+uint64_t stats_now(void);
+void stats_add( stats_t* stats, int stage, uint64_t start );
+void stats_merge( stats_t* stats, const stats_t* from );
+bool stats_attach( stats_t* stats, file_t* outfile, size_t row_size );
+void stats_detach( stats_t* stats, file_t* outfile );
+void stats_print( stats_t* stats, FILE* fp );
 
 /*** utility ***/
 /*@null@*/ char* strclone( const char* str );
@@ -102,6 +305,9 @@ bool strfree( char* str );
 #ifdef TEST
 extern FILE *t_stdin, *t_stdout, *t_stderr;
 extern char* t_tmpname;
+void t_stdout_reset(void);
+void t_stdout_read( char* act, size_t size );
+data_t* t_file_load( const char* name, bool gzip, size_t length, size_t* size );
 #endif
 
 #endif
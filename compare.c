@@ -0,0 +1,278 @@
+/*!
+ * @file
+ * @brief compare - compare two files by blocks, --diff.
+ * @author yukio
+ *
+ * Both files are opened by file_open(), so that a file, a pipe, a
+ * process or -z of a compressed file can be compared, and read by
+ * file_fetch() in batches of blocks of rows. With --jobs=<num> the
+ * workers take the blocks of a batch by an atomic counter and compare
+ * them by memcmp(), marking the differing ones. Only the rows of the
+ * differing blocks are compared row by row, and written side by side
+ * with the address,
+ *
+ *   <address>: <row of infile> | <row of the other file>
+ *
+ * so that the time of writing is of the difference only. The rows over
+ * the end of a file are written with the empty row of the file. A file
+ * truncated while comparing just ends there, as the files are read and
+ * not mapped.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "verbose.h"
+#include "bldump.h"
+
+/*** TEST ***/
+#ifdef TEST
+#define STDOUT	t_stdout
+#else
+#define STDOUT	stdout
+#endif
+
+#define min(a,b) ((a)>(b)?(b):(a))
+#define max(a,b) ((a)<(b)?(b):(a))
+
+#define DIFF_BLOCK (1u << 20) /*!< comparing size at once. */
+#define DIFF_SEPARATOR " | "  /*!< between the rows of two files. */
+
+/*** diff_scan_t ***/
+typedef struct {
+	const data_t*  a;
+	const data_t*  b;
+	size_t         size;    /*!< common size of the batch. */
+	size_t         block;   /*!< bytes of a block, rows of -f x -l. */
+	size_t         nblocks;
+	size_t         next;    /*!< next block to compare, atomic. */
+	unsigned char* differ;  /*!< 1 if the block differs. */
+} diff_scan_t;
+
+static bool diff_open( file_t* file, const char* name, const char* index_name, const options_t* opt )
+{
+	if ( file_open( file, name, "rb" ) == false ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't open infile - %s\n", name );
+		return false;
+	}
+	if ( opt->decompress == true && decompress_open( file, index_name ) == false ) {
+		return false;
+	}
+	if ( opt->start_address > 0 && file_seek( file, opt->start_address ) != 0 ) {
+		return false;
+	}
+	return true;
+}
+
+static void* diff_worker( void* arg )
+{
+	diff_scan_t* scan = (diff_scan_t*)arg;
+	size_t i;
+
+	while ( (i = __atomic_fetch_add( &scan->next, 1, __ATOMIC_RELAXED )) < scan->nblocks ) {
+		size_t pos = i * scan->block;
+		size_t len = (scan->size - pos < scan->block) ? scan->size - pos : scan->block;
+		scan->differ[i] = (memcmp( &scan->a[pos], &scan->b[pos], len ) != 0) ? 1 : 0;
+	}
+	return NULL;
+}
+
+/*!
+ * @brief compare the blocks of the batch by the workers and this thread.
+ */
+static void diff_blocks( diff_scan_t* scan, pthread_t* threads, int nworkers )
+{
+	int j;
+
+	scan->next    = 0;
+	scan->nblocks = (scan->size + scan->block - 1) / scan->block;
+	for ( j = 0; j < nworkers - 1; j++ ) {
+		if ( pthread_create( &threads[j], NULL, diff_worker, scan ) != 0 ) {
+			break;
+		}
+	}
+	(void)diff_worker( scan ); /* this thread works too */
+	while ( --j >= 0 ) {
+		(void)pthread_join( threads[j], NULL );
+	}
+}
+
+/*!
+ * @brief write a row of each file side by side.
+ * @param[in] a row of infile, NULL over the end.
+ * @param[in] na bytes of the row.
+ */
+static bool diff_row( memory_t* memory, file_t* outfile, options_t* opt_a, options_t* opt_b,
+	size_t address, const data_t* a, size_t na, const data_t* b, size_t nb )
+{
+	bool is;
+
+	memory->address = address;
+	memory->size    = na;
+	if ( na > 0 ) {
+		memcpy( memory->data, a, na );
+	}
+	memory_reorder( memory, opt_a );
+	is = bldump_write( memory, outfile, opt_a );
+
+	memory->size = nb;
+	if ( nb > 0 ) {
+		memcpy( memory->data, b, nb );
+	}
+	memory_reorder( memory, opt_b );
+	if ( bldump_write( memory, outfile, opt_b ) == false ) {
+		is = false;
+	}
+	return is;
+}
+
+/*!
+ * @brief --diff : compare infile with the other file, and write the differing rows.
+ * @param[in] opt
+ * @retval 0 same.
+ * @retval 1 differ.
+ * @retval 2 trouble.
+ */
+int bldump_diff( options_t* opt )
+{
+	file_t a, b;
+	diff_scan_t scan;
+	options_t opt_a, opt_b;
+	memory_t memory;
+	file_t outfile;
+	pthread_t* threads = NULL;
+	data_t *buf_a = NULL, *buf_b = NULL;
+	size_t row, batch = 0, pos;
+	size_t rows = 0;
+	int nworkers = (opt->jobs > 1) ? opt->jobs : 1;
+	bool is_ok = true;
+
+	memset( &scan, 0, sizeof(scan) );
+	memory_init( &memory );
+	file_reset( &a );
+	file_reset( &b );
+	file_reset( &outfile );
+
+	/* the index of -z is of infile */
+	row = bldump_record_size( opt );
+	if ( row == 0 || diff_open( &a, opt->infile_name, opt->index_name, opt ) == false
+		|| diff_open( &b, opt->diff_name, NULL, opt ) == false
+		|| memory_allocate( &memory, row ) == false ) {
+		is_ok = false;
+	}
+	if ( is_ok == true ) {
+		scan.block  = (DIFF_BLOCK > row) ? row * (DIFF_BLOCK / row) : row;
+		batch       = scan.block * (size_t)nworkers;
+		buf_a       = (data_t*)malloc( batch );
+		buf_b       = (data_t*)malloc( batch );
+		scan.differ = (unsigned char*)calloc( (size_t)nworkers, 1 );
+		threads     = (pthread_t*)calloc( (size_t)nworkers, sizeof(pthread_t) );
+		if ( buf_a == NULL || buf_b == NULL || scan.differ == NULL || threads == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+			is_ok = false;
+		}
+	}
+	if ( is_ok == true ) {
+		if ( opt->outfile_name == NULL ) {
+			outfile.ptr = STDOUT;
+		} else if ( file_open( &outfile, opt->outfile_name, "wb" ) == false ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't open outfile - %s\n", opt->outfile_name );
+			is_ok = false;
+		}
+	}
+
+	/* infile and the other file are written on a line */
+	opt_a = *opt;
+	opt_a.show_address   = true;
+	opt_a.row_delimitter = (char*)DIFF_SEPARATOR;
+	opt_b = *opt;
+	opt_b.show_address   = false;
+
+	/*** batches of blocks, until the end of both or -e ***/
+	for ( pos = opt->start_address; is_ok == true; ) {
+		size_t want = batch;
+		size_t na, nb, common, off, i;
+
+		if ( opt->end_address != 0 ) {
+			want = (pos < opt->end_address) ? min( want, opt->end_address - pos ) : 0;
+		}
+		if ( want == 0 ) {
+			break;
+		}
+		na = file_fetch( &a, buf_a, want );
+		nb = file_fetch( &b, buf_b, want );
+		if ( a.failed == true || b.failed == true ) {
+			is_ok = false;
+			break;
+		}
+		if ( na == 0 && nb == 0 ) {
+			break;
+		}
+
+		/* common part by blocks */
+		common = min( na, nb );
+		if ( na != nb ) {
+			common -= common % row; /* the last row of the shorter file is over the end */
+		}
+		scan.a    = buf_a;
+		scan.b    = buf_b;
+		scan.size = common;
+		diff_blocks( &scan, threads, nworkers );
+
+		/* rows of the differing blocks */
+		for ( i = 0; is_ok == true && i < scan.nblocks; i++ ) {
+			size_t last = min( (i + 1) * scan.block, common );
+			if ( scan.differ[i] == 0 ) {
+				continue;
+			}
+			for ( off = i * scan.block; is_ok == true && off < last; off += row ) {
+				size_t n = min( last - off, row );
+				if ( memcmp( &buf_a[off], &buf_b[off], n ) != 0 ) {
+					is_ok = diff_row( &memory, &outfile, &opt_a, &opt_b, pos + off, &buf_a[off], n, &buf_b[off], n );
+					rows++;
+				}
+			}
+		}
+
+		/* over the end of a file */
+		for ( off = common; is_ok == true && off < max( na, nb ); off += row ) {
+			size_t ra = (off < na) ? min( na - off, row ) : 0;
+			size_t rb = (off < nb) ? min( nb - off, row ) : 0;
+			is_ok = diff_row( &memory, &outfile, &opt_a, &opt_b, pos + off, &buf_a[off], ra, &buf_b[off], rb );
+			rows++;
+		}
+		pos += max( na, nb );
+		if ( na < want && nb < want ) {
+			break;
+		}
+	}
+	(void)verbose_printf( VERB_LOG, "bldump: diff %lu rows\n", (unsigned long)rows );
+
+	/*** dispose ***/
+	free( scan.differ );
+	free( threads );
+	free( buf_a );
+	free( buf_b );
+	if ( outfile.ptr != NULL ) {
+		(void)fflush( outfile.ptr );
+		(void)file_close( &outfile );
+	}
+	if ( memory.data != NULL ) {
+		(void)memory_free( &memory );
+	}
+	if ( a.name != NULL ) {
+		(void)file_close( &a );
+	}
+	if ( b.name != NULL ) {
+		(void)file_close( &b );
+	}
+
+	if ( is_ok == false ) {
+		return 2;
+	}
+	return (rows > 0) ? 1 : 0;
+}
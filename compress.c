@@ -0,0 +1,421 @@
+/*!
+ * @file
+ * @brief compress - compress outfile by threads, --compress.
+ * @author yukio
+ *
+ * compress_attach() replaces outfile by a stream which cuts the dump
+ * into chunks of COMPRESS_CHUNK bytes, and the workers compress the
+ * chunks in parallel, each into an independent gzip member or zstd
+ * frame. The concatenation of them is a valid .gz or .zst file which
+ * 'gzip -d' or 'zstd -d' decompresses as a whole, like pigz.
+ *
+ * The chunks are in a ring of slots. The formatter fills a slot and
+ * hands it to the workers, and before it fills the slot again, it waits
+ * until the slot is compressed and writes it, so that the chunks are
+ * written in order and the memory is bounded by the ring.
+ */
+
+#define _GNU_SOURCE /* fopencookie */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "verbose.h"
+#include "bldump.h"
+
+#define min(a,b) ((a)>(b)?(b):(a))
+
+#define COMPRESS_CHUNK (1u << 20) /*!< dump bytes of a member. */
+
+typedef enum {
+	SLOT_FREE = 0, SLOT_FILLED, SLOT_BUSY, SLOT_DONE
+} SLOT_STATE;
+
+/*** compress_slot_t ***/
+typedef struct {
+	SLOT_STATE state;
+	data_t*    in;         /*!< dump of the chunk. */
+	size_t     in_size;
+	data_t*    out;        /*!< compressed chunk. */
+	size_t     out_size;
+	size_t     out_length; /*!< allocated bytes of out. */
+	bool       failed;     /*!< failed to compress. */
+} compress_slot_t;
+
+/*** compress_worker_t ***/
+typedef struct {
+	compress_t* ctx;
+	pthread_t   thread;
+	bool        started;
+	z_stream    strm;      /*!< deflate, reset for each chunk. */
+	bool        deflating; /*!< strm is initialized. */
+#ifdef HAVE_ZSTD
+	ZSTD_CCtx*  cctx;
+#endif
+} compress_worker_t;
+
+/*** compress_t ***/
+struct compress_s {
+	COMPRESS_TYPE      type;
+	int                level;
+	FILE*              real;     /*!< outfile under the stream. */
+	compress_slot_t*   slots;
+	int                nslots;
+	uint64_t           seq;      /*!< chunk being filled by the formatter. */
+	uint64_t           next;     /*!< chunk to be taken by a worker. */
+	bool               filling;  /*!< the slot of seq is being filled. */
+	compress_worker_t* workers;
+	int                nworkers;
+	pthread_mutex_t    lock;
+	pthread_cond_t     filled;   /*!< a slot is filled, or stop. */
+	pthread_cond_t     done;     /*!< a slot is compressed. */
+	bool               stop;
+	bool               failed;   /*!< failed to compress or write. */
+};
+
+/*!
+ * @brief compress a chunk into a gzip member.
+ */
+static bool compress_gzip( compress_worker_t* w, compress_slot_t* s )
+{
+	compress_t* c = w->ctx;
+	size_t bound;
+
+	if ( w->deflating == false ) {
+		if ( deflateInit2( &w->strm, c->level, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY ) != Z_OK ) {
+			return false;
+		}
+		w->deflating = true;
+	} else if ( deflateReset( &w->strm ) != Z_OK ) {
+		return false;
+	}
+	bound = deflateBound( &w->strm, (uLong)s->in_size );
+	if ( s->out_length < bound ) {
+		data_t* out = (data_t*)realloc( s->out, bound );
+		if ( out == NULL ) {
+			return false;
+		}
+		s->out        = out;
+		s->out_length = bound;
+	}
+	w->strm.next_in   = s->in;
+	w->strm.avail_in  = (uInt)s->in_size;
+	w->strm.next_out  = s->out;
+	w->strm.avail_out = (uInt)s->out_length;
+	if ( deflate( &w->strm, Z_FINISH ) != Z_STREAM_END ) {
+		return false;
+	}
+	s->out_size = s->out_length - w->strm.avail_out;
+	return true;
+}
+
+#ifdef HAVE_ZSTD
+/*!
+ * @brief compress a chunk into a zstd frame.
+ */
+static bool compress_zstd( compress_worker_t* w, compress_slot_t* s )
+{
+	size_t bound = ZSTD_compressBound( s->in_size );
+	size_t ret;
+
+	if ( w->cctx == NULL && (w->cctx = ZSTD_createCCtx()) == NULL ) {
+		return false;
+	}
+	if ( s->out_length < bound ) {
+		data_t* out = (data_t*)realloc( s->out, bound );
+		if ( out == NULL ) {
+			return false;
+		}
+		s->out        = out;
+		s->out_length = bound;
+	}
+	ret = ZSTD_compressCCtx( w->cctx, s->out, s->out_length, s->in, s->in_size, w->ctx->level );
+	if ( ZSTD_isError( ret ) ) {
+		return false;
+	}
+	s->out_size = ret;
+	return true;
+}
+#endif
+
+/*!
+ * @brief worker : compress the filled slots in order of the chunks.
+ */
+static void* compress_worker( void* arg )
+{
+	compress_worker_t* w = (compress_worker_t*)arg;
+	compress_t* c = w->ctx;
+
+	(void)pthread_mutex_lock( &c->lock );
+	for (;;) {
+		compress_slot_t* s = &c->slots[c->next % (uint64_t)c->nslots];
+		bool is;
+
+		if ( s->state != SLOT_FILLED ) {
+			if ( c->stop == true ) {
+				break;
+			}
+			(void)pthread_cond_wait( &c->filled, &c->lock );
+			continue;
+		}
+		s->state = SLOT_BUSY;
+		c->next++;
+		(void)pthread_mutex_unlock( &c->lock );
+
+#ifdef HAVE_ZSTD
+		is = (c->type == COMPRESS_ZSTD) ? compress_zstd( w, s ) : compress_gzip( w, s );
+#else
+		is = compress_gzip( w, s );
+#endif
+
+		(void)pthread_mutex_lock( &c->lock );
+		s->failed = (is == false);
+		s->state  = SLOT_DONE;
+		(void)pthread_cond_broadcast( &c->done );
+	}
+	(void)pthread_mutex_unlock( &c->lock );
+	return NULL;
+}
+
+/*!
+ * @brief wait until the slot is compressed, and write it.
+ */
+static void compress_take( compress_t* c, compress_slot_t* s )
+{
+	bool is_done;
+
+	(void)pthread_mutex_lock( &c->lock );
+	while ( s->state == SLOT_FILLED || s->state == SLOT_BUSY ) {
+		(void)pthread_cond_wait( &c->done, &c->lock );
+	}
+	is_done  = (s->state == SLOT_DONE);
+	s->state = SLOT_FREE;
+	(void)pthread_mutex_unlock( &c->lock );
+
+	if ( is_done == true ) {
+		if ( s->failed == true ) {
+			if ( c->failed == false ) {
+				(void)verbose_printf( VERB_ERR, "Error: can't compress outfile\n" );
+			}
+			c->failed = true;
+		} else if ( c->failed == false && fwrite( s->out, 1, s->out_size, c->real ) != s->out_size ) {
+			c->failed = true;
+		}
+	}
+	s->in_size = 0;
+}
+
+/*!
+ * @brief hand the slot of the chunk to the workers.
+ */
+static void compress_submit( compress_t* c )
+{
+	compress_slot_t* s = &c->slots[c->seq % (uint64_t)c->nslots];
+
+	(void)pthread_mutex_lock( &c->lock );
+	s->state = SLOT_FILLED;
+	(void)pthread_cond_signal( &c->filled );
+	(void)pthread_mutex_unlock( &c->lock );
+	c->seq++;
+	c->filling = false;
+}
+
+static ssize_t compress_write( void* cookie, const char* buf, size_t size )
+{
+	compress_t* c = (compress_t*)cookie;
+	size_t done = 0;
+
+	while ( done < size && c->failed == false ) {
+		compress_slot_t* s = &c->slots[c->seq % (uint64_t)c->nslots];
+		size_t n;
+
+		if ( c->filling == false ) {
+			compress_take( c, s ); /* the chunk of seq - nslots */
+			c->filling = true;
+		}
+		n = min( size - done, COMPRESS_CHUNK - s->in_size );
+		memcpy( &s->in[s->in_size], &buf[done], n );
+		s->in_size += n;
+		done       += n;
+		if ( s->in_size == COMPRESS_CHUNK ) {
+			compress_submit( c );
+		}
+	}
+	return (c->failed == true) ? -1 : (ssize_t)done;
+}
+
+/*!
+ * @brief stop the workers, and free the context.
+ */
+static void compress_free( compress_t* c )
+{
+	int i;
+
+	(void)pthread_mutex_lock( &c->lock );
+	c->stop = true;
+	(void)pthread_cond_broadcast( &c->filled );
+	(void)pthread_mutex_unlock( &c->lock );
+	for ( i = 0; c->workers != NULL && i < c->nworkers; i++ ) {
+		compress_worker_t* w = &c->workers[i];
+		if ( w->started == true ) {
+			(void)pthread_join( w->thread, NULL );
+		}
+		if ( w->deflating == true ) {
+			(void)deflateEnd( &w->strm );
+		}
+#ifdef HAVE_ZSTD
+		(void)ZSTD_freeCCtx( w->cctx );
+#endif
+	}
+	for ( i = 0; c->slots != NULL && i < c->nslots; i++ ) {
+		free( c->slots[i].in );
+		free( c->slots[i].out );
+	}
+	(void)pthread_mutex_destroy( &c->lock );
+	(void)pthread_cond_destroy( &c->filled );
+	(void)pthread_cond_destroy( &c->done );
+	free( c->slots );
+	free( c->workers );
+	free( c );
+}
+
+/*!
+ * @brief parse the value of --compress=, gzip[,<level>] or zstd[,<level>].
+ * @param[in] sub value of the option.
+ * @param[out] type type of the compression.
+ * @param[out] level level, or the default of the type.
+ * @retval true success.
+ * @retval false wrong type or level.
+ */
+bool compress_parse( const char* sub, COMPRESS_TYPE* type, int* level )
+{
+	const char* tail = &sub[strcspn( sub, "," )];
+
+	if ( tail - sub == 4 && strncmp( sub, "gzip", 4 ) == 0 ) {
+		*type  = COMPRESS_GZIP;
+		*level = 6;
+	} else if ( tail - sub == 4 && strncmp( sub, "zstd", 4 ) == 0 ) {
+		*type  = COMPRESS_ZSTD;
+		*level = 3;
+	} else {
+		(void)verbose_printf( VERB_ERR, "Error: wrong type of --compress - %s\n", sub );
+		return false;
+	}
+	if ( *tail == ',' ) {
+		char* end;
+		long n = strtol( &tail[1], &end, 10 );
+		long max = (*type == COMPRESS_GZIP) ? 9 : 19;
+		if ( end == &tail[1] || *end != '\0' || n < 1 || n > max ) {
+			(void)verbose_printf( VERB_ERR, "Error: wrong level of --compress - %s\n", sub );
+			return false;
+		}
+		*level = (int)n;
+	}
+	return true;
+}
+
+/*!
+ * @brief replace outfile by the compressing stream.
+ * @param[in] opt --compress and --jobs.
+ * @param[in,out] outfile outfile->ptr is replaced until compress_detach().
+ * @return context, NULL on failure and outfile isn't changed.
+ */
+compress_t* compress_attach( const options_t* opt, file_t* outfile )
+{
+	static const cookie_io_functions_t io = { NULL, compress_write, NULL, NULL };
+	compress_t* c;
+	FILE* fp;
+	bool is = true;
+	int i;
+
+#ifndef HAVE_ZSTD
+	if ( opt->compress == COMPRESS_ZSTD ) {
+		(void)verbose_printf( VERB_ERR, "Error: zstd isn't supported by this build\n" );
+		return NULL;
+	}
+#endif
+	c = (compress_t*)calloc( 1, sizeof(compress_t) );
+	if ( c == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		return NULL;
+	}
+	c->type     = opt->compress;
+	c->level    = opt->compress_level;
+	c->nworkers = opt->jobs;
+	if ( c->nworkers <= 0 ) {
+		long n = sysconf( _SC_NPROCESSORS_ONLN );
+		c->nworkers = (n > 0) ? (int)n : 1;
+	}
+	c->nslots  = c->nworkers * 2;
+	(void)pthread_mutex_init( &c->lock, NULL );
+	(void)pthread_cond_init( &c->filled, NULL );
+	(void)pthread_cond_init( &c->done, NULL );
+	c->slots   = (compress_slot_t*)calloc( (size_t)c->nslots, sizeof(compress_slot_t) );
+	c->workers = (compress_worker_t*)calloc( (size_t)c->nworkers, sizeof(compress_worker_t) );
+	if ( c->slots == NULL || c->workers == NULL ) {
+		is = false;
+	}
+	for ( i = 0; is == true && i < c->nslots; i++ ) {
+		c->slots[i].in = (data_t*)malloc( COMPRESS_CHUNK );
+		is = c->slots[i].in != NULL;
+	}
+	if ( is == false ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		compress_free( c );
+		return NULL;
+	}
+	for ( i = 0; i < c->nworkers; i++ ) {
+		c->workers[i].ctx = c;
+		if ( pthread_create( &c->workers[i].thread, NULL, compress_worker, &c->workers[i] ) != 0 ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't create thread\n" );
+			compress_free( c );
+			return NULL;
+		}
+		c->workers[i].started = true;
+	}
+
+	(void)fflush( outfile->ptr );
+	fp = fopencookie( c, "w", io );
+	if ( fp == NULL ) {
+		compress_free( c );
+		return NULL;
+	}
+	c->real      = outfile->ptr;
+	outfile->ptr = fp;
+	(void)verbose_printf( VERB_LOG, "bldump: compress - %s level %d, %d workers\n",
+		(c->type == COMPRESS_ZSTD) ? "zstd" : "gzip", c->level, c->nworkers );
+	return c;
+}
+
+/*!
+ * @brief write the rest of the chunks, and restore outfile.
+ * @retval true success.
+ * @retval false failed to compress or write.
+ */
+bool compress_detach( compress_t* c, file_t* outfile )
+{
+	bool is;
+	int i;
+
+	(void)fflush( outfile->ptr );
+	/* an empty dump is still one empty member or frame, not a 0 byte file */
+	if ( c->seq == 0 || (c->filling == true && c->slots[c->seq % (uint64_t)c->nslots].in_size > 0) ) {
+		compress_submit( c );
+	}
+	for ( i = 0; i < c->nslots; i++ ) { /* oldest first */
+		compress_take( c, &c->slots[(c->seq + (uint64_t)i) % (uint64_t)c->nslots] );
+	}
+	(void)fclose( outfile->ptr );
+	outfile->ptr = c->real;
+	is = c->failed == false && fflush( outfile->ptr ) == 0;
+	compress_free( c );
+	return is;
+}
@@ -0,0 +1,634 @@
+/*!
+ * @file
+ * @brief decompress - gzip and zstd infile, --decompress.
+ * @author yukio
+ *
+ * decompress_open() wraps the backend of infile by a backend which
+ * decompresses it as a stream, so that -s, -e, --ranges and all the
+ * dump modes work with the addresses of the decompressed data, without
+ * writing it to a disk.
+ *
+ * A gzip file can't be seeked, so the inflater keeps a seek point at a
+ * deflate block boundary of every DECOMP_SPAN bytes of the output, with
+ * the 32K window of the history. A read before the position, or beyond
+ * the next seek point, restarts from the nearest seek point instead of
+ * the start of the file. The points are at most DECOMP_POINTS, and
+ * every other one is dropped with the span doubled when they're full.
+ * --index=<file> saves the seek points, so that a later -s jumps deep
+ * into the file by them. The index is of the compressed size and the
+ * first and the last 8 bytes of infile, i.e. the gzip mtime and the
+ * CRC32 and the size of the last member. Its numbers are little endian,
+ * so that an index is read on a host of the other byte order.
+ *
+ * A zstd file, if built with libzstd, is decompressed from the start.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "verbose.h"
+#include "bldump.h"
+
+#define min(a,b) ((a)>(b)?(b):(a))
+
+#define DECOMP_SPAN   1048576 /*!< output bytes between the seek points, at first. */
+#define DECOMP_POINTS 256     /*!< max number of the seek points, 8M of the windows. */
+#define DECOMP_WINDOW 32768   /*!< history of deflate. */
+#define DECOMP_INPUT  65536   /*!< reading size of the compressed data. */
+#define DECOMP_STAMP  16      /*!< the first and the last 8 bytes of infile. */
+#define DECOMP_MAGIC  "BLDZIDX2" /*!< magic of the index file. */
+
+/*** decomp_point_t ***/
+typedef struct {
+	uint64_t out;  /*!< offset of the decompressed data. */
+	uint64_t in;   /*!< offset of the compressed data, of the first whole byte. */
+	uint32_t bits; /*!< bits of the byte before 'in', 0-7. */
+	uint32_t size; /*!< size of the window. */
+	data_t   window[DECOMP_WINDOW]; /*!< history before 'out'. */
+} decomp_point_t;
+
+/*** decomp_t ***/
+typedef struct decomp_s {
+	const file_ops_t* ops; /*!< backend of the compressed data. */
+	void*         handle;
+	const char*   name;    /*!< infile name. */
+	ssize_t     (*decode)( struct decomp_s* d, data_t* buf, size_t size );
+	const data_t* next;    /*!< compressed data to decode. */
+	size_t        avail;   /*!< bytes of next. */
+	size_t        in;      /*!< offset of the compressed data to read next. */
+	size_t        out;     /*!< offset of the decompressed data to decode next. */
+	size_t        size;    /*!< decompressed size, 0 if unknown. */
+	bool          pending; /*!< the decoder may have output without input. */
+	bool          end;     /*!< reached to the end of the data. */
+	data_t*       input;   /*!< buffer of the compressed data. */
+	data_t*       scratch; /*!< output to skip. */
+
+	/* gzip */
+	z_stream        strm;
+	bool            raw;      /*!< restarted at a seek point, in a member. */
+	decomp_point_t* points;   /*!< seek points in ascending order. */
+	int             count;    /*!< number of points. */
+	int             capacity; /*!< allocated points. */
+	size_t          span;     /*!< output bytes between the points. */
+	int             saved;    /*!< points in the index file, -1 if thinned out. */
+	size_t          saved_size; /*!< decompressed size in the index file. */
+	size_t          csize;    /*!< compressed size, for the index. */
+	data_t          stamp[DECOMP_STAMP]; /*!< of the content, for the index. */
+	char*           index_name; /*!< --index */
+#ifdef HAVE_ZSTD
+	ZSTD_DStream*   zstd;
+#endif
+} decomp_t;
+
+/*!
+ * @brief read the next compressed data.
+ * @return read bytes, 0 at the end, -1 on failure.
+ */
+static ssize_t decomp_feed( decomp_t* d )
+{
+	ssize_t n;
+
+	n = d->ops->read( d->handle, d->input, DECOMP_INPUT, d->in );
+	d->next = d->input;
+	if ( n < 0 ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't read infile - %s\n", d->name );
+		return -1;
+	}
+	d->avail = (size_t)n;
+	d->in   += (size_t)n;
+	return n;
+}
+
+/*!
+ * @brief add a seek point at the position, every d->span bytes.
+ */
+static bool decomp_point( decomp_t* d )
+{
+	decomp_point_t* p;
+	uInt size = DECOMP_WINDOW;
+
+	if ( d->out < ((d->count > 0) ? d->points[d->count - 1].out : 0) + d->span ) {
+		return true;
+	}
+	if ( d->count == DECOMP_POINTS ) {
+		int i;
+		for ( i = 1; i < d->count / 2; i++ ) {
+			d->points[i] = d->points[i * 2];
+		}
+		d->count /= 2;
+		d->span  *= 2;
+		d->saved  = -1;
+		if ( d->out < d->points[d->count - 1].out + d->span ) {
+			return true;
+		}
+	}
+	if ( d->count == d->capacity ) {
+		int capacity = (d->capacity > 0) ? min( d->capacity * 2, DECOMP_POINTS ) : 16;
+		p = (decomp_point_t*)realloc( d->points, sizeof(decomp_point_t) * (size_t)capacity );
+		if ( p == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+			return false;
+		}
+		d->points   = p;
+		d->capacity = capacity;
+	}
+	p = &d->points[d->count];
+	p->out  = d->out;
+	p->in   = d->in - d->avail;
+	p->bits = (uint32_t)d->strm.data_type & 7;
+	(void)inflateGetDictionary( &d->strm, p->window, &size );
+	p->size = size;
+	d->count++;
+	return true;
+}
+
+/*!
+ * @brief go to the next member at the end of a gzip member.
+ */
+static bool decomp_member( decomp_t* d )
+{
+	size_t skip = (d->raw == true) ? 8 : 0; /* trailer, read by inflate() unless raw */
+
+	while ( skip > 0 || d->avail == 0 ) {
+		size_t n;
+		if ( d->avail == 0 ) {
+			ssize_t m = decomp_feed( d );
+			if ( m < 0 ) {
+				return false;
+			}
+			if ( m == 0 ) {
+				d->end  = true;
+				d->size = d->out;
+				return true;
+			}
+		}
+		n = min( skip, d->avail );
+		d->next  += n;
+		d->avail -= n;
+		skip     -= n;
+	}
+	(void)inflateReset2( &d->strm, 31 );
+	d->raw = false;
+	return true;
+}
+
+/*!
+ * @brief decompress gzip to buf at the position.
+ * @return decompressed bytes, less than size at the end, -1 on failure.
+ */
+static ssize_t decomp_gzip( decomp_t* d, data_t* buf, size_t size )
+{
+	size_t done = 0;
+
+	while ( done < size && d->end == false ) {
+		uInt avail_in, avail_out;
+		int ret;
+
+		if ( d->avail == 0 && d->pending == false ) {
+			ssize_t m = decomp_feed( d );
+			if ( m < 0 ) {
+				return -1;
+			}
+			if ( m == 0 ) {
+				(void)verbose_printf( VERB_WARNING, "Warning: compressed data is truncated - %s\n", d->name );
+				d->end = true;
+				break;
+			}
+		}
+		avail_in  = (uInt)min( d->avail, (size_t)UINT_MAX );
+		avail_out = (uInt)min( size - done, (size_t)UINT_MAX );
+		d->strm.next_in   = (Bytef*)d->next;
+		d->strm.avail_in  = avail_in;
+		d->strm.next_out  = &buf[done];
+		d->strm.avail_out = avail_out;
+		ret = inflate( &d->strm, Z_BLOCK );
+
+		d->next  += avail_in - d->strm.avail_in;
+		d->avail -= avail_in - d->strm.avail_in;
+		done     += avail_out - d->strm.avail_out;
+		d->out   += avail_out - d->strm.avail_out;
+		d->pending = (d->strm.avail_out == 0);
+
+		if ( ret == Z_STREAM_END ) {
+			d->pending = false;
+			if ( decomp_member( d ) == false ) {
+				return -1;
+			}
+		} else if ( ret != Z_OK && ret != Z_BUF_ERROR ) {
+			(void)verbose_printf( VERB_ERR, "Error: corrupt compressed data - %s at 0x%lx\n", d->name, (unsigned long)(d->in - d->avail) );
+			return -1;
+		} else if ( (d->strm.data_type & 192) == 128 ) { /* at a block boundary, not the last */
+			if ( decomp_point( d ) == false ) {
+				return -1;
+			}
+		}
+	}
+	return (ssize_t)done;
+}
+
+#ifdef HAVE_ZSTD
+/*!
+ * @brief decompress zstd to buf at the position.
+ * @return decompressed bytes, less than size at the end, -1 on failure.
+ */
+static ssize_t decomp_zstd( decomp_t* d, data_t* buf, size_t size )
+{
+	size_t done = 0;
+
+	while ( done < size && d->end == false ) {
+		ZSTD_inBuffer  in;
+		ZSTD_outBuffer out;
+		size_t ret;
+
+		if ( d->avail == 0 && d->pending == false ) {
+			ssize_t m = decomp_feed( d );
+			if ( m < 0 ) {
+				return -1;
+			}
+			if ( m == 0 ) {
+				d->end  = true;
+				d->size = d->out;
+				break;
+			}
+		}
+		in.src   = d->next;
+		in.size  = d->avail;
+		in.pos   = 0;
+		out.dst  = &buf[done];
+		out.size = size - done;
+		out.pos  = 0;
+		ret = ZSTD_decompressStream( d->zstd, &out, &in );
+		if ( ZSTD_isError( ret ) ) {
+			(void)verbose_printf( VERB_ERR, "Error: corrupt compressed data - %s, %s\n", d->name, ZSTD_getErrorName( ret ) );
+			return -1;
+		}
+		d->next  += in.pos;
+		d->avail -= in.pos;
+		done     += out.pos;
+		d->out   += out.pos;
+		d->pending = (out.pos == out.size);
+	}
+	return (ssize_t)done;
+}
+#endif
+
+/*!
+ * @brief the nearest seek point before offset.
+ * @return point, NULL if the start is the nearest.
+ */
+static const decomp_point_t* decomp_nearest( const decomp_t* d, size_t offset )
+{
+	int lo = 0, hi = d->count;
+
+	while ( lo < hi ) {
+		int mid = (lo + hi) / 2;
+		if ( d->points[mid].out <= offset ) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return (lo > 0) ? &d->points[lo - 1] : NULL;
+}
+
+/*!
+ * @brief the point to restart from, to decode at offset.
+ * @param[out] point seek point, NULL for the start.
+ * @retval true restart.
+ * @retval false continue from the position.
+ */
+static bool decomp_restart_at( const decomp_t* d, size_t offset, const decomp_point_t** point )
+{
+	*point = decomp_nearest( d, offset );
+	return offset < d->out || (*point != NULL && (*point)->out > d->out);
+}
+
+/*!
+ * @brief restart the decoder at the seek point, or the start.
+ */
+static bool decomp_restart( decomp_t* d, const decomp_point_t* p )
+{
+	d->next    = NULL;
+	d->avail   = 0;
+	d->pending = false;
+	d->end     = false;
+#ifdef HAVE_ZSTD
+	if ( d->zstd != NULL ) {
+		d->in  = 0;
+		d->out = 0;
+		return ZSTD_isError( ZSTD_DCtx_reset( d->zstd, ZSTD_reset_session_only ) ) == 0;
+	}
+#endif
+	if ( p == NULL ) {
+		d->in  = 0;
+		d->out = 0;
+		d->raw = false;
+		return inflateReset2( &d->strm, 31 ) == Z_OK;
+	}
+	d->in  = (size_t)p->in - ((p->bits > 0) ? 1 : 0);
+	d->out = (size_t)p->out;
+	d->raw = true;
+	(void)inflateReset2( &d->strm, -15 );
+	if ( p->bits > 0 ) {
+		if ( decomp_feed( d ) <= 0 ) {
+			return false;
+		}
+		(void)inflatePrime( &d->strm, (int)p->bits, d->next[0] >> (8 - p->bits) );
+		d->next++;
+		d->avail--;
+	}
+	(void)inflateSetDictionary( &d->strm, p->window, p->size );
+	return true;
+}
+
+static ssize_t decomp_read( void* handle, data_t* buf, size_t size, size_t offset )
+{
+	decomp_t* d = (decomp_t*)handle;
+	const decomp_point_t* p;
+
+	if ( decomp_restart_at( d, offset, &p ) == true && decomp_restart( d, p ) == false ) {
+		return -1;
+	}
+	while ( d->out < offset ) {
+		ssize_t n = d->decode( d, d->scratch, min( offset - d->out, (size_t)DECOMP_INPUT ) );
+		if ( n <= 0 ) {
+			return n;
+		}
+	}
+	return d->decode( d, buf, size );
+}
+
+static size_t decomp_size( void* handle )
+{
+	return ((decomp_t*)handle)->size;
+}
+
+static bool decomp_seek( void* handle, size_t offset )
+{
+	decomp_t* d = (decomp_t*)handle;
+	const decomp_point_t* p;
+
+	if ( decomp_restart_at( d, offset, &p ) == false ) {
+		return true;
+	}
+	return d->ops->seek( d->handle, (p != NULL) ? (size_t)p->in - ((p->bits > 0) ? 1 : 0) : 0 );
+}
+
+/*!
+ * @brief read the stamp of the content, the first and the last 8 bytes.
+ */
+static bool decomp_stamp( decomp_t* d )
+{
+	const size_t half = DECOMP_STAMP / 2;
+	return d->ops->read( d->handle, d->stamp, half, 0 ) == (ssize_t)half
+		&& d->ops->read( d->handle, &d->stamp[half], half, d->csize - half ) == (ssize_t)half;
+}
+
+/*!
+ * @brief write a number of the index in little endian.
+ */
+static bool decomp_put( FILE* fp, uint64_t value, size_t bytes )
+{
+	unsigned char b[8];
+	size_t i;
+
+	for ( i = 0; i < bytes; i++ ) {
+		b[i] = (unsigned char)(value >> (8 * i));
+	}
+	return fwrite( b, 1, bytes, fp ) == bytes;
+}
+
+/*!
+ * @brief read a number of the index in little endian.
+ */
+static bool decomp_get( FILE* fp, uint64_t* value, size_t bytes )
+{
+	unsigned char b[8];
+	size_t i;
+
+	if ( fread( b, 1, bytes, fp ) != bytes ) {
+		return false;
+	}
+	*value = 0;
+	for ( i = bytes; i > 0; i-- ) {
+		*value = (*value << 8) | b[i - 1];
+	}
+	return true;
+}
+
+/*!
+ * @brief load the seek points of --index, if it's of infile.
+ */
+static void decomp_load( decomp_t* d )
+{
+	FILE* fp = fopen( d->index_name, "rb" );
+	char magic[8];
+	data_t stamp[DECOMP_STAMP];
+	uint64_t csize, span, size, count, bits, wsize;
+	bool is;
+	int i;
+
+	if ( fp == NULL ) {
+		(void)verbose_printf( VERB_LOG, "bldump: index - %s is built\n", d->index_name );
+		return;
+	}
+	is = fread( magic, 1, sizeof(magic), fp ) == sizeof(magic) && memcmp( magic, DECOMP_MAGIC, sizeof(magic) ) == 0
+		&& decomp_get( fp, &csize, 8 ) && fread( stamp, 1, sizeof(stamp), fp ) == sizeof(stamp)
+		&& decomp_get( fp, &span, 8 ) && decomp_get( fp, &size, 8 )
+		&& decomp_get( fp, &count, 4 ) && csize == (uint64_t)d->csize
+		&& memcmp( stamp, d->stamp, sizeof(stamp) ) == 0 && span >= DECOMP_SPAN && count <= DECOMP_POINTS;
+	if ( is == true && count > 0 ) {
+		d->points = (decomp_point_t*)malloc( sizeof(decomp_point_t) * (size_t)count );
+		is = d->points != NULL;
+		d->capacity = (int)count;
+	}
+	for ( i = 0; is == true && i < (int)count; i++ ) {
+		decomp_point_t* p = &d->points[i];
+		is = decomp_get( fp, &p->out, 8 ) && decomp_get( fp, &p->in, 8 )
+			&& decomp_get( fp, &bits, 4 ) && decomp_get( fp, &wsize, 4 )
+			&& bits < 8 && wsize <= DECOMP_WINDOW;
+		if ( is == true ) {
+			p->bits = (uint32_t)bits;
+			p->size = (uint32_t)wsize;
+			is = fread( p->window, 1, p->size, fp ) == p->size && (i == 0 || p->out > d->points[i - 1].out);
+		}
+	}
+	(void)fclose( fp );
+
+	if ( is == false ) {
+		(void)verbose_printf( VERB_WARNING, "Warning: index isn't of infile, it's rebuilt - %s\n", d->index_name );
+		free( d->points );
+		d->points   = NULL;
+		d->capacity = 0;
+		return;
+	}
+	d->count = d->saved = (int)count;
+	d->span  = (size_t)span;
+	d->size  = d->saved_size = (size_t)size;
+	(void)verbose_printf( VERB_LOG, "bldump: index - %s, %d seek points\n", d->index_name, d->count );
+}
+
+/*!
+ * @brief save the seek points to --index, if any are added.
+ */
+static void decomp_save( decomp_t* d )
+{
+	FILE* fp;
+	bool is;
+	int i;
+
+	fp = fopen( d->index_name, "wb" );
+	is = fp != NULL && fwrite( DECOMP_MAGIC, 1, 8, fp ) == 8
+		&& decomp_put( fp, (uint64_t)d->csize, 8 ) && fwrite( d->stamp, 1, sizeof(d->stamp), fp ) == sizeof(d->stamp)
+		&& decomp_put( fp, (uint64_t)d->span, 8 ) && decomp_put( fp, (uint64_t)d->size, 8 )
+		&& decomp_put( fp, (uint64_t)d->count, 4 );
+	for ( i = 0; is == true && i < d->count; i++ ) {
+		const decomp_point_t* p = &d->points[i];
+		is = decomp_put( fp, p->out, 8 ) && decomp_put( fp, p->in, 8 )
+			&& decomp_put( fp, p->bits, 4 ) && decomp_put( fp, p->size, 4 )
+			&& fwrite( p->window, 1, p->size, fp ) == p->size;
+	}
+	if ( fp != NULL && fclose( fp ) != 0 ) {
+		is = false;
+	}
+	if ( is == false ) {
+		(void)verbose_printf( VERB_WARNING, "Warning: can't save index - %s\n", d->index_name );
+	}
+}
+
+static void decomp_close( void* handle )
+{
+	decomp_t* d = (decomp_t*)handle;
+
+	if ( d->index_name != NULL && (d->count != d->saved || d->size != d->saved_size) ) {
+		decomp_save( d );
+	}
+#ifdef HAVE_ZSTD
+	if ( d->zstd != NULL ) {
+		(void)ZSTD_freeDStream( d->zstd );
+	} else
+#endif
+	{
+		(void)inflateEnd( &d->strm );
+	}
+	d->ops->close( d->handle );
+	free( d->points );
+	free( d->index_name );
+	free( d->input );
+	free( d->scratch );
+	free( d );
+}
+
+static const file_ops_t decomp_ops = { "decompress", decomp_read, decomp_size, decomp_seek, decomp_close };
+
+/*!
+ * @brief decompress infile, if it's gzip or zstd.
+ *
+ * The backend of file is wrapped at the start of the file, and a file
+ * which isn't compressed is read as it is.
+ * @param[in,out] file infile opened by file_open().
+ * @param[in] index_name --index : file of the seek points, or NULL.
+ * @retval true success.
+ * @retval false failure.
+ */
+bool decompress_open( file_t* file, const char* index_name )
+{
+	const data_t* magic;
+	decomp_t* d;
+	size_t avail;
+	bool gzip, zstd;
+
+	magic = (file->position == 0) ? file_borrow( file, 4, &avail ) : NULL;
+	gzip = magic != NULL && avail >= 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+	zstd = magic != NULL && avail >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd;
+	if ( file->failed == true ) {
+		return false;
+	}
+	if ( gzip == false && zstd == false ) {
+		(void)verbose_printf( VERB_LOG, "bldump: decompress - %s isn't compressed\n", file->name );
+		return true;
+	}
+#ifndef HAVE_ZSTD
+	if ( zstd == true ) {
+		(void)verbose_printf( VERB_ERR, "Error: zstd isn't supported by this build - %s\n", file->name );
+		return false;
+	}
+#endif
+
+	d = (decomp_t*)calloc( 1, sizeof(decomp_t) );
+	if ( d == NULL || (d->input = (data_t*)malloc( DECOMP_INPUT + file->buf_size )) == NULL
+		|| (d->scratch = (data_t*)malloc( DECOMP_INPUT )) == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		if ( d != NULL ) {
+			free( d->input );
+			free( d );
+		}
+		return false;
+	}
+	d->ops    = file->ops;
+	d->handle = file->handle;
+	d->name   = file->name;
+	d->csize  = file->ops->size( file->handle );
+	d->span   = DECOMP_SPAN;
+
+	/* the bytes already read from a stream are decoded first */
+	if ( file->buf != NULL && file->buf_size > 0 ) {
+		(void)memcpy( d->input, file->buf, file->buf_size );
+		d->next  = d->input;
+		d->avail = file->buf_size;
+		d->in    = file->buf_size;
+	}
+
+	if ( gzip == true ) {
+		d->decode = decomp_gzip;
+		if ( inflateInit2( &d->strm, 31 ) != Z_OK ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't init inflate\n" );
+			free( d->input );
+			free( d->scratch );
+			free( d );
+			return false;
+		}
+		if ( index_name != NULL && (d->csize < DECOMP_STAMP || decomp_stamp( d ) == false) ) {
+			(void)verbose_printf( VERB_WARNING, "Warning: --index needs a regular infile - %s\n", file->name );
+		} else if ( index_name != NULL ) {
+			d->index_name = strclone( index_name );
+			decomp_load( d );
+		}
+	}
+#ifdef HAVE_ZSTD
+	if ( zstd == true ) {
+		d->decode = decomp_zstd;
+		d->zstd   = ZSTD_createDStream();
+		if ( d->zstd == NULL || ZSTD_isError( ZSTD_initDStream( d->zstd ) ) ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't init zstd\n" );
+			(void)ZSTD_freeDStream( d->zstd );
+			free( d->input );
+			free( d->scratch );
+			free( d );
+			return false;
+		}
+		if ( index_name != NULL ) {
+			(void)verbose_printf( VERB_WARNING, "Warning: --index is of gzip, zstd is decompressed from the start.\n" );
+		}
+	}
+#endif
+
+	free( file->buf );
+	file->buf        = NULL;
+	file->buf_offset = 0;
+	file->buf_size   = 0;
+	file->ops        = &decomp_ops;
+	file->handle     = d;
+	file->length     = d->size;
+	file->eof        = false;
+	(void)verbose_printf( VERB_LOG, "bldump: decompress - %s, %s\n", file->name, (gzip == true) ? "gzip" : "zstd" );
+	return true;
+}
@@ -0,0 +1,197 @@
+/*!
+ * @file
+ * @brief follow - dump the appends of a growing file, --follow.
+ * @author yukio
+ *
+ * The infile is dumped to the end, and then the appends are dumped as
+ * they are written, like 'tail -f'. The bytes are pushed to a stream of
+ * stream.c, which keeps a partial row and the -S search between the
+ * appends, so that a row is written once all the bytes of it arrive.
+ *
+ * At the end of file, it blocks on inotify until the file is modified,
+ * so that an append is dumped in a few milliseconds without polling,
+ * and the file is read from the last position. It stops when the file
+ * is deleted, truncated, -e is reached, or by SIGINT or SIGTERM.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#include "verbose.h"
+#include "bldump.h"
+
+/*** TEST ***/
+#ifdef TEST
+#define STDOUT	t_stdout
+#else
+#define STDOUT	stdout
+#endif
+
+#define FOLLOW_READ 65536 /*!< reading size. */
+
+static volatile sig_atomic_t follow_stop = 0; /*!< set by SIGINT and SIGTERM. */
+
+static void follow_signal( int sig )
+{
+	(void)sig;
+	follow_stop = 1;
+}
+
+static size_t follow_sink( void* user, const char* buf, size_t size )
+{
+	return fwrite( buf, 1, size, (FILE*)user );
+}
+
+/*!
+ * @brief block until the infile is modified.
+ * @retval true modified, or interrupted by a signal.
+ * @retval false failure of inotify.
+ */
+static bool follow_wait( int ifd )
+{
+	char events[4096];
+	ssize_t n = read( ifd, events, sizeof(events) );
+
+	if ( n < 0 && errno != EINTR ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't wait for infile\n" );
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * @brief read infile to the end, and push it to the stream.
+ * @param[in,out] position bytes read.
+ * @retval true success, at the end of file or -e.
+ * @retval false failure.
+ */
+static bool follow_read( int fd, data_t* buf, bldump_t* ctx, const options_t* opt, size_t* position )
+{
+	while ( follow_stop == 0 && (opt->end_address == 0 || *position < opt->end_address) ) {
+		ssize_t n = read( fd, buf, FOLLOW_READ );
+		if ( n < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( n < 0 ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't read infile - %s\n", opt->infile_name );
+			return false;
+		}
+		if ( n == 0 ) {
+			break;
+		}
+		if ( bldump_push( ctx, buf, (size_t)n ) == false ) {
+			return false;
+		}
+		*position += (size_t)n;
+	}
+	return true;
+}
+
+/*!
+ * @brief --follow : dump infile, and the appends until it is deleted.
+ * @param[in] opt
+ * @retval true success.
+ * @retval false failure.
+ */
+bool bldump_follow( options_t* opt )
+{
+	struct sigaction sa, old_int, old_term;
+	struct stat st;
+	file_t outfile;
+	bldump_t* ctx;
+	data_t* buf;
+	size_t position = 0;
+	int fd, ifd = -1;
+	bool is_ok = true;
+
+	fd = open( opt->infile_name, O_RDONLY );
+	if ( fd < 0 ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't open infile - %s\n", opt->infile_name );
+		return false;
+	}
+	/* watch before the first read, not to miss an append after it */
+	if ( fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) ) {
+		ifd = inotify_init1( IN_CLOEXEC );
+		if ( ifd < 0 || inotify_add_watch( ifd, opt->infile_name, IN_MODIFY | IN_ATTRIB ) < 0 ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't watch infile - %s\n", opt->infile_name );
+			if ( ifd >= 0 ) {
+				(void)close( ifd );
+			}
+			(void)close( fd );
+			return false;
+		}
+	}
+
+	file_reset( &outfile );
+	if ( opt->outfile_name == NULL ) {
+		outfile.ptr = STDOUT;
+	} else if ( file_open( &outfile, opt->outfile_name, "wb" ) == false ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't open outfile - %s\n", opt->outfile_name );
+		is_ok = false;
+	}
+	buf = (data_t*)malloc( FOLLOW_READ );
+	if ( buf == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		is_ok = false;
+	}
+	ctx = (is_ok == true) ? bldump_open( opt, follow_sink, outfile.ptr ) : NULL;
+	if ( ctx == NULL ) {
+		is_ok = false;
+	}
+
+	/* read() of inotify is interrupted by the signals */
+	memset( &sa, 0, sizeof(sa) );
+	sa.sa_handler = follow_signal;
+	(void)sigaction( SIGINT, &sa, &old_int );
+	(void)sigaction( SIGTERM, &sa, &old_term );
+
+	while ( is_ok == true && follow_stop == 0 ) {
+		is_ok = follow_read( fd, buf, ctx, opt, &position );
+		if ( is_ok == true && fflush( outfile.ptr ) != 0 ) {
+			is_ok = false;
+		}
+		if ( is_ok == false || ifd < 0 || (opt->end_address != 0 && position >= opt->end_address) ) {
+			break;
+		}
+		if ( fstat( fd, &st ) != 0 || st.st_nlink == 0 ) {
+			(void)verbose_printf( VERB_LOG, "bldump: follow - infile is deleted\n" );
+			is_ok = follow_read( fd, buf, ctx, opt, &position ); /* appended before the deletion */
+			break;
+		}
+		if ( (size_t)st.st_size < position ) {
+			(void)verbose_printf( VERB_WARNING, "Warning: infile is truncated - %s\n", opt->infile_name );
+			break;
+		}
+		if ( (size_t)st.st_size == position ) {
+			is_ok = follow_wait( ifd );
+		}
+	}
+
+	(void)sigaction( SIGINT, &old_int, NULL );
+	(void)sigaction( SIGTERM, &old_term, NULL );
+	follow_stop = 0;
+
+	if ( ctx != NULL && bldump_close( ctx ) == false ) {
+		is_ok = false;
+	}
+	if ( outfile.ptr == STDOUT ) {
+		(void)fflush( outfile.ptr );
+	} else if ( outfile.ptr != NULL ) {
+		(void)file_close( &outfile );
+	}
+	free( buf );
+	if ( ifd >= 0 ) {
+		(void)close( ifd );
+	}
+	(void)close( fd );
+	return is_ok;
+}
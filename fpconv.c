@@ -0,0 +1,321 @@
+/*!
+ * @file
+ * @brief shortest round-trip formatting of IEEE floating point.
+ * @author yukio
+ *
+ * This is an implementation of Grisu2 by Florian Loitsch,
+ * "Printing Floating-Point Numbers Quickly and Accurately with Integers".
+ * The digits are the shortest that read back to the same binary value
+ * in almost all cases, and always read back to the same value.
+ * The boundaries are computed from the source precision, so that
+ * binary16 and binary32 values are printed as short as their own type.
+ */
+
+#include "fpconv.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/*** diy_fp_t ***/
+typedef struct {
+	uint64_t f; /*!< significand. */
+	int      e; /*!< binary exponent. */
+} diy_fp_t;
+
+/*!
+ * @brief normalized 10^k for k = -348, -340, .. 340.
+ */
+static const struct {
+	uint64_t f;
+	int      e;
+} cached_powers[] = {
+	{ 0xfa8fd5a0081c0288uLL, -1220 }, { 0xbaaee17fa23ebf76uLL, -1193 }, { 0x8b16fb203055ac76uLL, -1166 },
+	{ 0xcf42894a5dce35eauLL, -1140 }, { 0x9a6bb0aa55653b2duLL, -1113 }, { 0xe61acf033d1a45dfuLL, -1087 },
+	{ 0xab70fe17c79ac6cauLL, -1060 }, { 0xff77b1fcbebcdc4fuLL, -1034 }, { 0xbe5691ef416bd60cuLL, -1007 },
+	{ 0x8dd01fad907ffc3cuLL,  -980 }, { 0xd3515c2831559a83uLL,  -954 }, { 0x9d71ac8fada6c9b5uLL,  -927 },
+	{ 0xea9c227723ee8bcbuLL,  -901 }, { 0xaecc49914078536duLL,  -874 }, { 0x823c12795db6ce57uLL,  -847 },
+	{ 0xc21094364dfb5637uLL,  -821 }, { 0x9096ea6f3848984fuLL,  -794 }, { 0xd77485cb25823ac7uLL,  -768 },
+	{ 0xa086cfcd97bf97f4uLL,  -741 }, { 0xef340a98172aace5uLL,  -715 }, { 0xb23867fb2a35b28euLL,  -688 },
+	{ 0x84c8d4dfd2c63f3buLL,  -661 }, { 0xc5dd44271ad3cdbauLL,  -635 }, { 0x936b9fcebb25c996uLL,  -608 },
+	{ 0xdbac6c247d62a584uLL,  -582 }, { 0xa3ab66580d5fdaf6uLL,  -555 }, { 0xf3e2f893dec3f126uLL,  -529 },
+	{ 0xb5b5ada8aaff80b8uLL,  -502 }, { 0x87625f056c7c4a8buLL,  -475 }, { 0xc9bcff6034c13053uLL,  -449 },
+	{ 0x964e858c91ba2655uLL,  -422 }, { 0xdff9772470297ebduLL,  -396 }, { 0xa6dfbd9fb8e5b88fuLL,  -369 },
+	{ 0xf8a95fcf88747d94uLL,  -343 }, { 0xb94470938fa89bcfuLL,  -316 }, { 0x8a08f0f8bf0f156buLL,  -289 },
+	{ 0xcdb02555653131b6uLL,  -263 }, { 0x993fe2c6d07b7facuLL,  -236 }, { 0xe45c10c42a2b3b06uLL,  -210 },
+	{ 0xaa242499697392d3uLL,  -183 }, { 0xfd87b5f28300ca0euLL,  -157 }, { 0xbce5086492111aebuLL,  -130 },
+	{ 0x8cbccc096f5088ccuLL,  -103 }, { 0xd1b71758e219652cuLL,   -77 }, { 0x9c40000000000000uLL,   -50 },
+	{ 0xe8d4a51000000000uLL,   -24 }, { 0xad78ebc5ac620000uLL,     3 }, { 0x813f3978f8940984uLL,    30 },
+	{ 0xc097ce7bc90715b3uLL,    56 }, { 0x8f7e32ce7bea5c70uLL,    83 }, { 0xd5d238a4abe98068uLL,   109 },
+	{ 0x9f4f2726179a2245uLL,   136 }, { 0xed63a231d4c4fb27uLL,   162 }, { 0xb0de65388cc8ada8uLL,   189 },
+	{ 0x83c7088e1aab65dbuLL,   216 }, { 0xc45d1df942711d9auLL,   242 }, { 0x924d692ca61be758uLL,   269 },
+	{ 0xda01ee641a708deauLL,   295 }, { 0xa26da3999aef774auLL,   322 }, { 0xf209787bb47d6b85uLL,   348 },
+	{ 0xb454e4a179dd1877uLL,   375 }, { 0x865b86925b9bc5c2uLL,   402 }, { 0xc83553c5c8965d3duLL,   428 },
+	{ 0x952ab45cfa97a0b3uLL,   455 }, { 0xde469fbd99a05fe3uLL,   481 }, { 0xa59bc234db398c25uLL,   508 },
+	{ 0xf6c69a72a3989f5cuLL,   534 }, { 0xb7dcbf5354e9beceuLL,   561 }, { 0x88fcf317f22241e2uLL,   588 },
+	{ 0xcc20ce9bd35c78a5uLL,   614 }, { 0x98165af37b2153dfuLL,   641 }, { 0xe2a0b5dc971f303auLL,   667 },
+	{ 0xa8d9d1535ce3b396uLL,   694 }, { 0xfb9b7cd9a4a7443cuLL,   720 }, { 0xbb764c4ca7a44410uLL,   747 },
+	{ 0x8bab8eefb6409c1auLL,   774 }, { 0xd01fef10a657842cuLL,   800 }, { 0x9b10a4e5e9913129uLL,   827 },
+	{ 0xe7109bfba19c0c9duLL,   853 }, { 0xac2820d9623bf429uLL,   880 }, { 0x80444b5e7aa7cf85uLL,   907 },
+	{ 0xbf21e44003acdd2duLL,   933 }, { 0x8e679c2f5e44ff8fuLL,   960 }, { 0xd433179d9c8cb841uLL,   986 },
+	{ 0x9e19db92b4e31ba9uLL,  1013 }, { 0xeb96bf6ebadf77d9uLL,  1039 }, { 0xaf87023b9bf0ee6buLL,  1066 },
+};
+
+static const uint32_t pow10_32[] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static diy_fp_t diy_normalize( diy_fp_t v )
+{
+	while ( (v.f & (1uLL << 63)) == 0 ) {
+		v.f <<= 1;
+		v.e--;
+	}
+	return v;
+}
+
+static diy_fp_t diy_multiply( diy_fp_t a, diy_fp_t b )
+{
+	diy_fp_t r;
+	const uint64_t M32 = 0xFFFFFFFFuLL;
+	uint64_t ah = a.f >> 32, al = a.f & M32;
+	uint64_t bh = b.f >> 32, bl = b.f & M32;
+	uint64_t hh = ah * bh, hl = ah * bl, lh = al * bh, ll = al * bl;
+	uint64_t mid = (ll >> 32) + (hl & M32) + (lh & M32) + (1uLL << 31); /* round */
+
+	r.f = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+	r.e = a.e + b.e + 64;
+	return r;
+}
+
+static diy_fp_t cached_power( int e, int* k )
+{
+	diy_fp_t c;
+	double dk = (-61 - e) * 0.30102999566398114 + 347;
+	int n = (int)dk;
+	unsigned int index;
+
+	if ( dk - n > 0.0 ) n++;
+	index = (unsigned int)((n >> 3) + 1);
+	*k = -(-348 + (int)(index << 3));
+	c.f = cached_powers[index].f;
+	c.e = cached_powers[index].e;
+	return c;
+}
+
+static int count_digits( uint32_t n )
+{
+	int d = 1;
+	while ( d < 10 && n >= pow10_32[d] ) d++;
+	return d;
+}
+
+static void grisu_round( char* buf, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w )
+{
+	while ( rest < wp_w && delta - rest >= ten_kappa &&
+		(rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w) ) {
+		buf[len - 1]--;
+		rest += ten_kappa;
+	}
+}
+
+static int digit_gen( diy_fp_t w, diy_fp_t mp, uint64_t delta, char* buf, int* k )
+{
+	const int      shift = -mp.e;
+	const uint64_t one   = 1uLL << shift;
+	const uint64_t wp_w  = mp.f - w.f;
+	uint32_t p1 = (uint32_t)(mp.f >> shift);
+	uint64_t p2 = mp.f & (one - 1);
+	int kappa = count_digits( p1 );
+	int len = 0;
+
+	while ( kappa > 0 ) {
+		uint32_t d = p1 / pow10_32[kappa - 1];
+		uint64_t rest;
+		p1 %= pow10_32[kappa - 1];
+		if ( d != 0 || len != 0 ) {
+			buf[len++] = (char)('0' + d);
+		}
+		kappa--;
+		rest = ((uint64_t)p1 << shift) + p2;
+		if ( rest <= delta ) {
+			*k += kappa;
+			grisu_round( buf, len, delta, rest, (uint64_t)pow10_32[kappa] << shift, wp_w );
+			return len;
+		}
+	}
+
+	while ( true ) {
+		char d;
+		p2    *= 10;
+		delta *= 10;
+		d = (char)(p2 >> shift);
+		if ( d != 0 || len != 0 ) {
+			buf[len++] = (char)('0' + d);
+		}
+		p2 &= one - 1;
+		kappa--;
+		if ( p2 < delta ) {
+			*k += kappa;
+			grisu_round( buf, len, delta, p2, one, wp_w * ((-kappa < 10) ? pow10_32[-kappa] : 0) );
+			return len;
+		}
+	}
+}
+
+/*!
+ * @brief generate the shortest digits of f*2^e.
+ * @param[in] f significand including the hidden bit.
+ * @param[in] e binary exponent.
+ * @param[in] lower_closer true if the lower boundary is closer (f is a power of two).
+ * @param[out] buf digits.
+ * @param[out] k decimal exponent, value is digits*10^k.
+ * @return number of digits.
+ */
+static int grisu2( uint64_t f, int e, bool lower_closer, char* buf, int* k )
+{
+	diy_fp_t v, w, mp, mm, c;
+	int len;
+
+	v.f = f;
+	v.e = e;
+
+	/*** boundaries ***/
+	mp.f = (f << 1) + 1;
+	mp.e = e - 1;
+	mp = diy_normalize( mp );
+	if ( lower_closer ) {
+		mm.f = (f << 2) - 1;
+		mm.e = e - 2;
+	} else {
+		mm.f = (f << 1) - 1;
+		mm.e = e - 1;
+	}
+	mm.f <<= mm.e - mp.e;
+	mm.e = mp.e;
+
+	/*** scale into the range of digit generation ***/
+	c  = cached_power( mp.e, k );
+	w  = diy_multiply( diy_normalize( v ), c );
+	mp = diy_multiply( mp, c );
+	mm = diy_multiply( mm, c );
+	mm.f++;
+	mp.f--;
+
+	len = digit_gen( w, mp, mp.f - mm.f, buf, k );
+	return len;
+}
+
+static int write_exponent( char* buf, int e )
+{
+	int n = 0;
+	buf[n++] = 'e';
+	if ( e < 0 ) {
+		buf[n++] = '-';
+		e = -e;
+	} else {
+		buf[n++] = '+';
+	}
+	if ( e >= 100 ) {
+		buf[n++] = (char)('0' + e / 100);
+		e %= 100;
+		buf[n++] = (char)('0' + e / 10);
+	} else {
+		buf[n++] = (char)('0' + e / 10);
+	}
+	buf[n++] = (char)('0' + e % 10);
+	return n;
+}
+
+/*!
+ * @brief place decimal point of digits*10^k.
+ *
+ * Fixed notation is used for 1e-4 <= |v| < 1e16, otherwise exponent,
+ * the same rule as repr() of python without trailing ".0".
+ */
+static int prettify( char* buf, int len, int k )
+{
+	int kk = len + k; /* 10^(kk-1) <= v < 10^kk */
+	int i;
+
+	if ( k >= 0 && kk <= 16 ) {
+		/* 1234e3 -> 1234000 */
+		for ( i = len; i < kk; i++ ) buf[i] = '0';
+		return kk;
+	} else if ( 0 < kk && kk <= 16 ) {
+		/* 1234e-2 -> 12.34 */
+		memmove( &buf[kk + 1], &buf[kk], (size_t)(len - kk) );
+		buf[kk] = '.';
+		return len + 1;
+	} else if ( -4 < kk && kk <= 0 ) {
+		/* 1234e-6 -> 0.001234 */
+		int offset = 2 - kk;
+		memmove( &buf[offset], &buf[0], (size_t)len );
+		buf[0] = '0';
+		buf[1] = '.';
+		for ( i = 2; i < offset; i++ ) buf[i] = '0';
+		return len + offset;
+	} else if ( len == 1 ) {
+		/* 1e30 */
+		return 1 + write_exponent( &buf[1], kk - 1 );
+	} else {
+		/* 1234e30 -> 1.234e+33 */
+		memmove( &buf[2], &buf[1], (size_t)(len - 1) );
+		buf[1] = '.';
+		return len + 1 + write_exponent( &buf[len + 1], kk - 1 );
+	}
+}
+
+/*!
+ * @brief format IEEE floating point with the shortest round-trip digits.
+ * @param[out] buf output buffer of FPCONV_BUFSIZE bytes at least.
+ * @param[in] bits raw bits of the value.
+ * @param[in] size byte size of the value, 2(binary16), 4(binary32) or 8(binary64).
+ * @return length of the string, or 0 if size is not supported.
+ */
+int fpconv_format( char* buf, uint64_t bits, size_t size )
+{
+	int mant_bits, exp_bits, bias;
+	uint64_t significand, biased;
+	bool negative;
+	int n = 0, len, k = 0;
+
+	switch ( size ) {
+		case 2: mant_bits = 10; exp_bits =  5; break;
+		case 4: mant_bits = 23; exp_bits =  8; break;
+		case 8: mant_bits = 52; exp_bits = 11; break;
+		default: return 0;
+	}
+	bias        = (1 << (exp_bits - 1)) - 1;
+	negative    = ((bits >> (size * 8 - 1)) & 1) != 0;
+	biased      = (bits >> mant_bits) & ((1uLL << exp_bits) - 1);
+	significand = bits & ((1uLL << mant_bits) - 1);
+
+	if ( biased == (1uLL << exp_bits) - 1 ) {
+		if ( significand != 0 ) {
+			strcpy( buf, "nan" );
+			return 3;
+		}
+		strcpy( buf, negative ? "-inf" : "inf" );
+		return negative ? 4 : 3;
+	}
+
+	if ( negative ) {
+		buf[n++] = '-';
+	}
+	if ( biased == 0 && significand == 0 ) {
+		buf[n++] = '0';
+		buf[n] = '\0';
+		return n;
+	}
+
+	if ( biased != 0 ) {
+		len = grisu2( significand | (1uLL << mant_bits), (int)biased - bias - mant_bits,
+			significand == 0 && biased > 1, &buf[n], &k );
+	} else {
+		len = grisu2( significand, 1 - bias - mant_bits, false, &buf[n], &k );
+	}
+	n += prettify( &buf[n], len, k );
+	buf[n] = '\0';
+
+	return n;
+}
@@ -0,0 +1,17 @@
+/*!
+ * @file
+ * @brief shortest round-trip formatting of IEEE floating point.
+ * @author yukio
+ */
+
+#ifndef __fpconv_h__
+#define __fpconv_h__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FPCONV_BUFSIZE 32 /*!< enough buffer size for fpconv_format(). */
+
+int fpconv_format( char* buf, uint64_t bits, size_t size );
+
+#endif /* __fpconv_h__ */
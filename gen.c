@@ -0,0 +1,141 @@
+/*!
+ * @file
+ * @brief bldump-gen - deterministic input generator for 'make bench'.
+ * @author yukio
+ *
+ * usage: bldump-gen <kind> <size>[k|M|G] [<seed>] > <file>
+ *
+ * kind:
+ *  random  uniform random bytes.
+ *  zero    zero-heavy, short random runs in zeros.
+ *  text    ASCII words, spaces and newlines.
+ *  sync    frames of sync word 0xa55a, length and payload,
+ *          with garbage bytes between some frames.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define GEN_BLOCK 65536 /*!< writing size. */
+#define GEN_FRAME 32    /*!< sync : frame size including the sync word. */
+
+static uint64_t gen_state; /*!< xorshift64 state. */
+
+static uint64_t gen_next(void)
+{
+	gen_state ^= gen_state << 13;
+	gen_state ^= gen_state >> 7;
+	gen_state ^= gen_state << 17;
+	return gen_state;
+}
+
+static void gen_random( unsigned char* buf, size_t size )
+{
+	size_t i;
+	for ( i = 0; i < size; i++ ) {
+		buf[i] = (unsigned char)(gen_next() >> 56);
+	}
+}
+
+static void gen_zero( unsigned char* buf, size_t size )
+{
+	size_t i = 0;
+	memset( buf, 0, size );
+	while ( i < size ) {
+		uint64_t r = gen_next();
+		i += (size_t)(r % 64);           /* zeros */
+		if ( (r >> 32) % 4 == 0 ) {
+			size_t n = (size_t)((r >> 40) % 8) + 1; /* random run */
+			for ( ; n > 0 && i < size; n--, i++ ) {
+				buf[i] = (unsigned char)(gen_next() >> 56);
+			}
+		}
+	}
+}
+
+static void gen_text( unsigned char* buf, size_t size )
+{
+	static const char letters[] = "etaoinshrdlucmfwypvbgkjqxz";
+	size_t i = 0;
+	while ( i < size ) {
+		uint64_t r = gen_next();
+		size_t n = (size_t)(r % 10) + 1;
+		for ( ; n > 0 && i < size; n-- ) {
+			r = gen_next();
+			buf[i++] = (unsigned char)letters[(r >> 40) % 13 + (r >> 60) % 13]; /* frequent letters */
+		}
+		if ( i < size ) {
+			buf[i++] = (gen_next() % 12 == 0) ? '\n' : ' ';
+		}
+	}
+}
+
+static void gen_sync( unsigned char* buf, size_t size, size_t* phase )
+{
+	size_t i;
+	for ( i = 0; i < size; i++, (*phase)++ ) {
+		if ( *phase == GEN_FRAME ) {
+			/* garbage between frames, 1 of 16 */
+			if ( gen_next() % 16 == 0 ) {
+				buf[i] = (unsigned char)(gen_next() >> 56);
+				*phase = GEN_FRAME - 1;
+				continue;
+			}
+			*phase = 0;
+		}
+		switch ( *phase ) {
+			case 0:  buf[i] = 0xa5; break;
+			case 1:  buf[i] = 0x5a; break;
+			case 2:  buf[i] = GEN_FRAME - 3; break;
+			default: buf[i] = (unsigned char)(gen_next() >> 56); break;
+		}
+	}
+}
+
+int main( int argc, char* argv[] )
+{
+	static unsigned char buf[GEN_BLOCK];
+	const char* kind;
+	char* end;
+	size_t size, n, phase = 0;
+
+	if ( argc < 3 ) {
+		fprintf( stderr, "usage: bldump-gen random|zero|text|sync <size>[k|M|G] [<seed>]\n" );
+		return 1;
+	}
+	kind = argv[1];
+	size = (size_t)strtoull( argv[2], &end, 0 );
+	switch ( *end ) {
+		case 'k': size <<= 10; break;
+		case 'M': size <<= 20; break;
+		case 'G': size <<= 30; break;
+		default: break;
+	}
+	gen_state = (argc > 3) ? strtoull( argv[3], NULL, 0 ) : 0x9e3779b97f4a7c15uLL;
+	if ( gen_state == 0 ) {
+		gen_state = 1;
+	}
+
+	while ( size > 0 ) {
+		n = (size < sizeof(buf)) ? size : sizeof(buf);
+		if ( strcmp( kind, "random" ) == 0 ) {
+			gen_random( buf, n );
+		} else if ( strcmp( kind, "zero" ) == 0 ) {
+			gen_zero( buf, n );
+		} else if ( strcmp( kind, "text" ) == 0 ) {
+			gen_text( buf, n );
+		} else if ( strcmp( kind, "sync" ) == 0 ) {
+			gen_sync( buf, n, &phase );
+		} else {
+			fprintf( stderr, "bldump-gen: unknown kind - %s\n", kind );
+			return 1;
+		}
+		if ( fwrite( buf, 1, n, stdout ) != n ) {
+			return 1;
+		}
+		size -= n;
+	}
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*!
+ * @file
+ * @brief input - backends of infile, file_ops_t.
+ * @author yukio
+ *
+ * file_open() opens infile by input_open(), which chooses the backend
+ * for it:
+ *
+ * - fd   : a file, a pipe or a device is read by pread(), or read() if
+ *          it isn't seekable, into the buffer of file_t, or straight
+ *          into a large buffer of the caller. A file isn't mapped, since
+ *          the mapping faults by SIGBUS when the file is truncated while
+ *          dumping, e.g. a rotated log.
+ * - proc : the memory of a process, '<pid>:...', see proc.c.
+ *
+ * The readers of bldump.c access infile by file_borrow() and
+ * file_fetch(), and don't depend on the backend.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "verbose.h"
+#include "bldump.h"
+
+#define min(a,b) ((a)>(b)?(b):(a))
+
+/*** fd ***/
+typedef struct {
+	int    fd;
+	bool   seekable; /*!< read by pread(). */
+	size_t position; /*!< offset of fd, if not seekable. */
+	size_t size;     /*!< size of a regular file, 0 if unknown. */
+} input_fd_t;
+
+static ssize_t fd_read( void* handle, data_t* buf, size_t size, size_t offset )
+{
+	input_fd_t* f = (input_fd_t*)handle;
+	ssize_t n;
+
+	if ( f->seekable == true ) {
+		do {
+			n = pread( f->fd, buf, size, (off_t)offset );
+		} while ( n < 0 && errno == EINTR );
+		return n;
+	}
+
+	/* skip to offset by reading */
+	if ( offset < f->position ) {
+		return -1;
+	}
+	while ( f->position < offset ) {
+		do {
+			n = read( f->fd, buf, min( size, offset - f->position ) );
+		} while ( n < 0 && errno == EINTR );
+		if ( n <= 0 ) {
+			return n;
+		}
+		f->position += (size_t)n;
+	}
+	do {
+		n = read( f->fd, buf, size );
+	} while ( n < 0 && errno == EINTR );
+	if ( n > 0 ) {
+		f->position += (size_t)n;
+	}
+	return n;
+}
+
+static size_t fd_size( void* handle )
+{
+	return ((input_fd_t*)handle)->size;
+}
+
+static bool fd_seek( void* handle, size_t offset )
+{
+	input_fd_t* f = (input_fd_t*)handle;
+	return f->seekable == true || offset >= f->position;
+}
+
+static void fd_close( void* handle )
+{
+	input_fd_t* f = (input_fd_t*)handle;
+	(void)close( f->fd );
+	free( f );
+}
+
+static const file_ops_t fd_ops = { "fd", fd_read, fd_size, fd_seek, fd_close };
+
+/*!
+ * @brief open infile with the backend for it.
+ * @param[out] file ops, handle, position and length are set.
+ * @param[in] name infile name.
+ * @retval true success.
+ * @retval false failure.
+ */
+bool input_open( file_t* file, const char* name )
+{
+	struct stat st;
+	input_fd_t* f;
+	int fd;
+
+	if ( proc_name( name ) == true ) {
+		return proc_open( file, name );
+	}
+
+	fd = open( name, O_RDONLY );
+	if ( fd < 0 ) {
+		return false;
+	}
+	if ( fstat( fd, &st ) != 0 ) {
+		(void)close( fd );
+		return false;
+	}
+
+	/* fd */
+	f = (input_fd_t*)malloc( sizeof(input_fd_t) );
+	if ( f == NULL ) {
+		(void)close( fd );
+		return false;
+	}
+	f->fd       = fd;
+	f->seekable = lseek( fd, 0, SEEK_CUR ) >= 0;
+	f->position = 0;
+	f->size     = S_ISREG( st.st_mode ) ? (size_t)st.st_size : 0;
+	file->ops    = &fd_ops;
+	file->handle = f;
+	file->length = f->size;
+	return true;
+}
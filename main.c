@@ -0,0 +1,230 @@
+/*!
+ * @file
+ * @brief bldump - command line of the dump engine in libbldump.
+ * @author yukio
+ * @since 2009-09-20 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+#include <time.h>
+
+#include "verbose.h"
+#include "bldump.h"
+#ifdef TEST
+#include "munit.h"
+#endif
+
+/*** interface ***/
+#ifndef VERSION
+#define VERSION "0.x"
+#endif
+#define BUILD   __DATE__
+
+/*** TEST ***/
+#ifdef TEST
+#define STDOUT	t_stdout
+#define STDERR	t_stderr
+int mu_nfail=0;
+int mu_ntest=0;
+int mu_nassert=0;
+int mu_bench_warmup=10;
+int mu_bench_iters=100;
+#else
+#define STDOUT	stdout
+#define STDERR	stderr
+#endif
+
+/*!
+ * @brief bldump main function.
+ * @retval 0 normal termination.
+ */
+int main( int argc, char* argv[] )
+{
+	bool is_ok;
+
+	options_t opt; 
+	file_t    infile;
+	file_t    outfile;
+	memory_t  memory;
+	compress_t* compress = NULL;
+
+	if ( argc == 2 && strcmp("--version", argv[1]) == 0  ) {
+		fprintf( (STDOUT)?STDOUT:stdout, "bldump version %s (%s)\n", VERSION, BUILD );
+		return 0;
+	}
+#ifdef TEST
+	/* run test */
+	if ( argc == 2 && strcmp("--test", argv[1]) == 0  ) {
+		extern void ts_verbose(void);
+		extern void ts_opt(void);
+		extern void ts_memory(void);
+		extern void ts_file(void);
+		extern void ts_bldump(void);
+		extern void ts_main(void);
+		extern void ts_fpconv(void);
+		extern void ts_batch(void);
+		extern void ts_stream(void);
+		extern void ts_serve(void);
+		extern void ts_diff(void);
+		extern void ts_reverse(void);
+		extern void ts_compare(void);
+		extern void ts_watch(void);
+		extern void ts_follow(void);
+		extern void ts_proc(void);
+		extern void ts_decompress(void);
+		extern void ts_compress(void);
+		extern void ts_tee(void);
+		extern void ts_where(void);
+		ts_verbose();
+		ts_opt();
+		ts_memory();
+		ts_file();
+		ts_bldump();
+		ts_main();
+		ts_fpconv();
+		ts_batch();
+		ts_stream();
+		ts_serve();
+		ts_diff();
+		ts_reverse();
+		ts_compare();
+		ts_watch();
+		ts_follow();
+		ts_proc();
+		ts_decompress();
+		ts_compress();
+		ts_tee();
+		ts_where();
+		mu_show_failures();
+		return mu_nfail;
+	}
+	/* run differential test */
+	if ( argc >= 2 && strcmp("--diff", argv[1]) == 0  ) {
+		extern int t_diff_main( int cases, uint64_t seed );
+		int cases = (argc >= 3) ? atoi( argv[2] ) : 10000;
+		uint64_t seed = (argc >= 4) ? strtoull( argv[3], NULL, 0 ) : (uint64_t)time( NULL );
+		return (t_diff_main( cases, seed ) == 0) ? 0 : 1;
+	}
+	/* run benchmark */
+	if ( argc >= 2 && strcmp("--bench", argv[1]) == 0  ) {
+		extern void ts_bench(void);
+		if ( argc >= 3 ) {
+			mu_bench_iters  = atoi( argv[2] );
+			mu_bench_warmup = mu_bench_iters / 10 + 1;
+		}
+		ts_bench();
+		return 0;
+	}
+	assert( t_stdin != NULL && t_stdout != NULL && t_stderr != NULL );
+#endif
+
+
+	/*** prepare ***/
+	verbose_level = VERB_DEFAULT;
+	if ( verbose_out == NULL ) verbose_out = stdout;
+
+	options_reset( &opt );  
+	memory_init( &memory );
+	file_reset( &infile );
+	file_reset( &outfile );
+
+	/*** arguments ***/
+	is_ok = options_load( &opt, argc, argv  );
+	if ( is_ok == false && opt.diff == true ) {
+		/* diff(1) exits 1 for differing files, and 2 for errors */
+		(void)options_clear( &opt );
+		return 2;
+	}
+
+	/*** batch ***/
+	if ( is_ok == true && opt.batch_name != NULL ) {
+		is_ok = bldump_batch( &opt );
+		if ( opt.stats != NULL ) { /* added up by the workers */
+			stats_print( opt.stats, STDERR );
+		}
+		(void)options_clear( &opt );
+		return (is_ok == true) ? 0 : 1;
+	}
+
+	/*** watch ***/
+	if ( is_ok == true && opt.watch_interval > 0 ) {
+		is_ok = bldump_watch( &opt );
+		(void)options_clear( &opt );
+		return (is_ok == true) ? 0 : 1;
+	}
+
+	/*** follow ***/
+	if ( is_ok == true && opt.follow == true ) {
+		is_ok = bldump_follow( &opt );
+		(void)options_clear( &opt );
+		return (is_ok == true) ? 0 : 1;
+	}
+
+	/*** compare ***/
+	if ( is_ok == true && opt.diff_name != NULL ) {
+		int status = bldump_diff( &opt );
+		(void)options_clear( &opt );
+		return status;
+	}
+
+	/*** text to binary ***/
+	if ( is_ok == true && opt.reverse == true ) {
+		is_ok = bldump_reverse( &opt );
+		(void)options_clear( &opt );
+		return (is_ok == true) ? 0 : 1;
+	}
+
+	/*** daemon ***/
+	if ( is_ok == true && opt.serve_name != NULL ) {
+		is_ok = bldump_serve( &opt );
+		(void)options_clear( &opt );
+		return (is_ok == true) ? 0 : 1;
+	}
+	if ( is_ok == true && opt.outfile_name == NULL && opt.stats == NULL && getenv( "BLDUMP_SERVER" ) != NULL ) {
+		int status = bldump_forward( getenv( "BLDUMP_SERVER" ), argc, argv );
+		if ( status >= 0 ) {
+			(void)options_clear( &opt );
+			return status;
+		}
+		/* no daemon, dumps by itself */
+	}
+
+	/*** set parameter. ***/
+	if ( is_ok == true ) {
+		is_ok = bldump_setup( &memory, &infile, &outfile, &opt );
+	}
+
+	/*** bldump ***/
+	if ( is_ok == true && opt.stats != NULL ) {
+		is_ok = stats_attach( opt.stats, &outfile, bldump_record_size( &opt ) );
+	}
+	if ( is_ok == true && opt.compress != COMPRESS_NONE ) { /* over the counting stream */
+		compress = compress_attach( &opt, &outfile );
+		is_ok = (compress != NULL);
+	}
+	if ( is_ok == true ) {
+		is_ok = bldump_dump( &memory, &infile, &outfile, &opt );
+	}
+	if ( compress != NULL && compress_detach( compress, &outfile ) == false ) {
+		is_ok = false;
+	}
+	if ( opt.stats != NULL ) {
+		stats_detach( opt.stats, &outfile );
+		stats_print( opt.stats, STDERR );
+	}
+
+	/*** dispose ***/
+	(void)file_close( &infile );
+	(void)file_close( &outfile );
+	if ( memory.data != NULL ) {
+		(void)memory_free( &memory );
+	}
+	(void)options_clear( &opt );
+
+	return (is_ok == true) ? 0 : 1;
+}
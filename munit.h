@@ -2,6 +2,7 @@
 #define __munit_h__
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #define mu_failed(file,line,expr) printf( "%s:%u: failed assertion `%s'\n",file,line,expr)
 #define mu_tested(test,passed) printf( "Test: %-25s ... %s\n",test,(passed)?"passed":"FAILED")
 #define mu_assert(expr) do{mu_nassert++;if(!(expr)){++mu_nfail;mu_failed(__FILE__,__LINE__,#expr);}}while(0)
@@ -16,4 +17,11 @@ extern int mu_nassert;
 #define mu_assert_ptr_not_null(a) mu_assert(a!=NULL)
 #define mu_assert_nstring_equal(a,b,n) mu_assert(strncmp((const char*)a,(const char*)b,n)==0)
 #define mu_assert_string_equal(a,b) mu_assert(strcmp((const char*)a,(const char*)b)==0)
+/* benchmark: expr is run mu_bench_warmup times, then timed for mu_bench_iters times over bytes. */
+extern int mu_bench_warmup;
+extern int mu_bench_iters;
+#define mu_bench_ns(t) ((double)(t).tv_sec*1e9+(double)(t).tv_nsec)
+#define mu_benched(name,variant,ns,bytes) printf( "Bench: %-25s %-8s ... %8.3f ns/byte %9.1f MB/s\n",name,variant,(ns)/(bytes),(bytes)*1e3/(ns))
+#define mu_bench(name,variant,bytes,expr) do{int i_;struct timespec t0_,t1_;for(i_=0;i_<mu_bench_warmup;i_++){expr;}clock_gettime(CLOCK_MONOTONIC,&t0_);for(i_=0;i_<mu_bench_iters;i_++){expr;}clock_gettime(CLOCK_MONOTONIC,&t1_);mu_benched(name,variant,mu_bench_ns(t1_)-mu_bench_ns(t0_),(double)(bytes)*mu_bench_iters);}while(0)
+#define mu_run_bench(bench) do{bench();}while(0)
 #endif /* __munit_h__ */
@@ -0,0 +1,284 @@
+/*!
+ * @file
+ * @brief proc - read the memory of a running process as infile.
+ * @author yukio
+ *
+ * The infile '<pid>:<start>-<end>' or '<pid>:<mapping>' is opened as a
+ * backend of file_t whose offset is the virtual address in the process,
+ * so that all the dump modes and -s, -e, -S, --ranges work with the
+ * addresses of the process. <mapping> is the pathname or the basename
+ * of it in /proc/<pid>/maps, e.g. '[heap]' or 'libc.so.6', and the first
+ * mapping of it and the following ones near it, as the segments of a
+ * library, are read as a span.
+ *
+ * The memory is read by process_vm_readv() without stopping the
+ * process, straight into the buffer of file_t or of the caller, with a
+ * remote iovec of each mapping in a read. The gaps between the mappings
+ * and the pages which can't be read are dumped as zeros.
+ */
+
+#define _GNU_SOURCE /* process_vm_readv */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "verbose.h"
+#include "bldump.h"
+
+#define min(a,b) ((a)>(b)?(b):(a))
+
+#define PROC_IOV 64        /*!< remote iovecs of a read. */
+#define PROC_GAP 0x1000000 /*!< largest gap between the mappings of a name. */
+
+/*** proc_t ***/
+typedef struct {
+	pid_t    pid;
+	range_t* ranges;   /*!< mappings in ascending order. */
+	int      count;    /*!< number of ranges. */
+	size_t   page;     /*!< page size. */
+	bool     warned;   /*!< warned of an unreadable page. */
+} proc_t;
+
+/*!
+ * @brief read the pieces of the ranges, an unreadable page is zeros.
+ * @retval true success.
+ * @retval false the process can't be read.
+ */
+static bool proc_readv( proc_t* proc, struct iovec* local, struct iovec* remote, int k )
+{
+	int i = 0;
+
+	while ( i < k ) {
+		ssize_t n = process_vm_readv( proc->pid, &local[i], (unsigned long)(k - i), &remote[i], (unsigned long)(k - i), 0 );
+		size_t skip;
+
+		if ( n < 0 && errno != EFAULT && errno != ENOMEM ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't read process memory - %d\n", (int)proc->pid );
+			return false;
+		}
+		for ( ; n > 0 && i < k; i++ ) {
+			if ( (size_t)n < remote[i].iov_len ) {
+				local[i].iov_base   = (char*)local[i].iov_base + n;
+				local[i].iov_len   -= (size_t)n;
+				remote[i].iov_base  = (char*)remote[i].iov_base + n;
+				remote[i].iov_len  -= (size_t)n;
+				break;
+			}
+			n -= (ssize_t)remote[i].iov_len;
+		}
+		if ( i >= k ) {
+			break;
+		}
+
+		/* zeros to the next page */
+		skip = proc->page - ((size_t)remote[i].iov_base % proc->page);
+		skip = min( skip, remote[i].iov_len );
+		if ( proc->warned == false ) {
+			(void)verbose_printf( VERB_WARNING, "Warning: unreadable memory is dumped as zeros - %lx\n", (unsigned long)(size_t)remote[i].iov_base );
+			proc->warned = true;
+		}
+		memset( local[i].iov_base, 0, skip );
+		local[i].iov_base   = (char*)local[i].iov_base + skip;
+		local[i].iov_len   -= skip;
+		remote[i].iov_base  = (char*)remote[i].iov_base + skip;
+		remote[i].iov_len  -= skip;
+		if ( remote[i].iov_len == 0 ) {
+			i++;
+		}
+	}
+	return true;
+}
+
+static ssize_t proc_read( void* handle, data_t* buf, size_t size, size_t pos )
+{
+	proc_t* proc = (proc_t*)handle;
+	struct iovec local[PROC_IOV], remote[PROC_IOV];
+	size_t end = proc->ranges[proc->count - 1].end;
+	size_t done = 0;
+	int i, k = 0;
+
+	if ( pos >= end ) {
+		return 0;
+	}
+	size = min( size, end - pos );
+	for ( i = 0; i < proc->count && done < size && k < PROC_IOV; i++ ) {
+		const range_t* r = &proc->ranges[i];
+		size_t n;
+		if ( r->end <= pos + done ) {
+			continue;
+		}
+		if ( r->start > pos + done ) { /* gap */
+			n = min( r->start - (pos + done), size - done );
+			memset( &buf[done], 0, n );
+			done += n;
+			if ( done == size ) {
+				break;
+			}
+		}
+		n = min( r->end - (pos + done), size - done );
+		local[k].iov_base  = &buf[done];
+		local[k].iov_len   = n;
+		remote[k].iov_base = (void*)(pos + done);
+		remote[k].iov_len  = n;
+		k++;
+		done += n;
+	}
+	if ( proc_readv( proc, local, remote, k ) == false ) {
+		return -1;
+	}
+	return (ssize_t)done;
+}
+
+static size_t proc_size( void* handle )
+{
+	proc_t* proc = (proc_t*)handle;
+	return proc->ranges[proc->count - 1].end;
+}
+
+static bool proc_seek( void* handle, size_t offset )
+{
+	(void)handle;
+	(void)offset;
+	return true;
+}
+
+static void proc_close( void* handle )
+{
+	proc_t* proc = (proc_t*)handle;
+	free( proc->ranges );
+	free( proc );
+}
+
+static const file_ops_t proc_ops = { "proc", proc_read, proc_size, proc_seek, proc_close };
+
+/*!
+ * @brief add a range of the mapping.
+ */
+static bool proc_add( proc_t* proc, size_t start, size_t end )
+{
+	range_t* ranges = (range_t*)realloc( proc->ranges, sizeof(range_t) * (size_t)(proc->count + 1) );
+	if ( ranges == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		return false;
+	}
+	proc->ranges = ranges;
+	proc->ranges[proc->count].start = start;
+	proc->ranges[proc->count].end   = end;
+	proc->count++;
+	return true;
+}
+
+/*!
+ * @brief add the mappings of the name in /proc/<pid>/maps.
+ */
+static bool proc_maps( proc_t* proc, const char* name )
+{
+	char path[64];
+	char line[4096];
+	FILE* fp;
+	bool is = true;
+
+	(void)snprintf( path, sizeof(path), "/proc/%d/maps", (int)proc->pid );
+	fp = fopen( path, "r" );
+	if ( fp == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't open %s\n", path );
+		return false;
+	}
+	while ( is == true && fgets( line, (int)sizeof(line), fp ) != NULL ) {
+		unsigned long start, end;
+		const char* base;
+		char* p;
+		int n = 0;
+
+		if ( sscanf( line, "%lx-%lx %*s %*s %*s %*s %n", &start, &end, &n ) < 2 || n == 0 ) {
+			continue;
+		}
+		p = &line[n];
+		p[strcspn( p, "\n" )] = '\0';
+		base = strrchr( p, '/' );
+		base = (base != NULL) ? &base[1] : p;
+		if ( *p == '\0' || (strcmp( p, name ) != 0 && strcmp( base, name ) != 0) ) {
+			continue;
+		}
+		if ( proc->count > 0 && start - proc->ranges[proc->count - 1].end > PROC_GAP ) {
+			(void)verbose_printf( VERB_WARNING, "Warning: another mapping of %s at %lx isn't dumped.\n", name, start );
+			break;
+		}
+		is = proc_add( proc, (size_t)start, (size_t)end );
+	}
+	(void)fclose( fp );
+	if ( is == true && proc->count == 0 ) {
+		(void)verbose_printf( VERB_ERR, "Error: no mapping of %s in %s\n", name, path );
+		is = false;
+	}
+	return is;
+}
+
+/*!
+ * @brief check the name is '<pid>:...' of a process, not a file.
+ * @param[in] name infile name.
+ * @retval true process memory.
+ * @retval false file.
+ */
+bool proc_name( const char* name )
+{
+	const char* p = name;
+
+	while ( isdigit( (unsigned char)*p ) != 0 ) {
+		p++;
+	}
+	return p != name && *p == ':' && p[1] != '\0' && access( name, F_OK ) != 0;
+}
+
+/*!
+ * @brief open the memory of a process.
+ *
+ * The position is at the start of the first mapping.
+ * @param[out] file ops, handle, position and length are set.
+ * @param[in] name '<pid>:<start>-<end>' in hex, or '<pid>:<mapping>'.
+ * @retval true success.
+ * @retval false failure.
+ */
+bool proc_open( file_t* file, const char* name )
+{
+	proc_t* proc = (proc_t*)calloc( 1, sizeof(proc_t) );
+	const char* spec = strchr( name, ':' ) + 1;
+	unsigned long long start, end;
+	char* tail;
+	bool is;
+
+	if ( proc == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		return false;
+	}
+	proc->pid  = (pid_t)strtol( name, NULL, 10 );
+	proc->page = (size_t)sysconf( _SC_PAGESIZE );
+
+	start = strtoull( spec, &tail, 16 );
+	if ( tail != spec && *tail == '-' ) {
+		end = strtoull( &tail[1], &tail, 16 );
+		if ( *tail != '\0' || end <= start ) {
+			(void)verbose_printf( VERB_ERR, "Error: wrong address range - %s\n", spec );
+			is = false;
+		} else {
+			is = proc_add( proc, (size_t)start, (size_t)end );
+		}
+	} else {
+		is = proc_maps( proc, spec );
+	}
+	if ( is == false ) {
+		proc_close( proc );
+		return false;
+	}
+	file->ops      = &proc_ops;
+	file->handle   = proc;
+	file->position = proc->ranges[0].start;
+	file->length   = proc_size( proc );
+	return true;
+}
@@ -0,0 +1,437 @@
+/*!
+ * @file
+ * @brief reverse - parse the dump text back to binary, --reverse.
+ * @author yukio
+ *
+ * The infile is the text dumped in hexadecimal(default), -i or -u with
+ * the same -a, -d, -l and -r, and -s if the rows have the address.
+ * A row with the address is written at the address less -s, and a gap
+ * from the previous row, as -S skipped, is filled with zeros.
+ *
+ * The text is read in blocks and parsed in place. A hex pair is decoded
+ * by a table of the digits, and a decimal by a loop of digits without
+ * strtoll(), and the binary is written in blocks. With SSE2, a run of 16
+ * hex digits, i.e. a word of -l 8 or a row of -d '', is decoded at once,
+ * and the rest of it by the table.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "verbose.h"
+#include "bldump.h"
+
+/*** TEST ***/
+#ifdef TEST
+#define STDOUT	t_stdout
+#else
+#define STDOUT	stdout
+#endif
+
+#define REVERSE_BLOCK 65536 /*!< reading and writing size. */
+
+/*! 0x10 | value of a hex digit, 0 if not a digit. */
+static const unsigned char hex_digit[256] = {
+	['0'] = 0x10, ['1'] = 0x11, ['2'] = 0x12, ['3'] = 0x13, ['4'] = 0x14,
+	['5'] = 0x15, ['6'] = 0x16, ['7'] = 0x17, ['8'] = 0x18, ['9'] = 0x19,
+	['a'] = 0x1a, ['b'] = 0x1b, ['c'] = 0x1c, ['d'] = 0x1d, ['e'] = 0x1e, ['f'] = 0x1f,
+	['A'] = 0x1a, ['B'] = 0x1b, ['C'] = 0x1c, ['D'] = 0x1d, ['E'] = 0x1e, ['F'] = 0x1f
+};
+
+/*** reverse_t ***/
+typedef struct {
+	options_t*  opt;
+	FILE*       out;      /*!< outfile. */
+	data_t*     buf;      /*!< binary to write. */
+	size_t      length;   /*!< allocated size of buf. */
+	size_t      size;     /*!< valid size of buf. */
+	size_t      address;  /*!< address of the next byte, -s is 0. */
+	const char* delim;    /*!< -d */
+	size_t      delim_len;
+	bool        is_ok;    /*!< false after a write error. */
+} reverse_t;
+
+static void reverse_flush( reverse_t* rev )
+{
+	if ( rev->size > 0 && fwrite( rev->buf, 1, rev->size, rev->out ) != rev->size ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't write outfile.\n" );
+		rev->is_ok = false;
+	}
+	rev->size = 0;
+}
+
+/*!
+ * @brief make room of the bytes in buf.
+ * @retval false memory allocation failure.
+ */
+static bool reverse_room( reverse_t* rev, size_t bytes )
+{
+	if ( rev->size + bytes <= rev->length ) {
+		return true;
+	}
+	reverse_flush( rev );
+	if ( bytes > rev->length ) {
+		data_t* grown = (data_t*)realloc( rev->buf, bytes );
+		if ( grown == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+			return false;
+		}
+		rev->buf    = grown;
+		rev->length = bytes;
+	}
+	return true;
+}
+
+/*!
+ * @brief fill zeros up to the address of a row.
+ */
+static void reverse_fill( reverse_t* rev, size_t address )
+{
+	while ( rev->address < address ) {
+		size_t n = address - rev->address;
+		if ( rev->size == rev->length ) {
+			reverse_flush( rev );
+		}
+		if ( n > rev->length - rev->size ) {
+			n = rev->length - rev->size;
+		}
+		memset( &rev->buf[rev->size], 0, n );
+		rev->size    += n;
+		rev->address += n;
+	}
+}
+
+#ifdef __SSE2__
+/*!
+ * @brief decode 16 hex digits to 8 bytes.
+ * @retval false not all of them are hex digits, out isn't written.
+ */
+static bool reverse_hex16( const unsigned char* p, data_t* out )
+{
+	const __m128i bias = _mm_set1_epi8( (char)0x80 );
+	__m128i v = _mm_loadu_si128( (const __m128i*)p );
+	__m128i d = _mm_sub_epi8( v, _mm_set1_epi8( '0' ) );
+	__m128i a = _mm_sub_epi8( _mm_or_si128( v, _mm_set1_epi8( 0x20 ) ), _mm_set1_epi8( 'a' ) );
+	/* unsigned d < 10 and a < 6 by the signed compares of the biased */
+	__m128i is_d = _mm_cmplt_epi8( _mm_xor_si128( d, bias ), _mm_set1_epi8( (char)(0x80 + 10) ) );
+	__m128i is_a = _mm_cmplt_epi8( _mm_xor_si128( a, bias ), _mm_set1_epi8( (char)(0x80 + 6) ) );
+	__m128i val;
+
+	if ( _mm_movemask_epi8( _mm_or_si128( is_d, is_a ) ) != 0xffff ) {
+		return false;
+	}
+	val = _mm_or_si128( _mm_and_si128( is_d, d ),
+		_mm_and_si128( is_a, _mm_add_epi8( a, _mm_set1_epi8( 10 ) ) ) );
+	/* a 16bit lane is of the high digit and the low digit of a byte */
+	val = _mm_or_si128( _mm_and_si128( _mm_slli_epi16( val, 4 ), _mm_set1_epi16( 0x00f0 ) ),
+		_mm_srli_epi16( val, 8 ) );
+	_mm_storel_epi64( (__m128i*)out, _mm_packus_epi16( val, val ) );
+	return true;
+}
+
+/*!
+ * @brief decode the hex digits by 16 while they are.
+ * It's out of line, as inlined it slows down the words of -l 1.
+ * @return bytes decoded, a multiple of 8.
+ */
+static __attribute__((noinline)) size_t reverse_hex_run( const unsigned char* p, const unsigned char* end, size_t length, data_t* word )
+{
+	size_t n = 0;
+
+	while ( length - n >= 8 && end - p >= 16 && reverse_hex16( p, &word[n] ) == true ) {
+		n += 8;
+		p += 16;
+	}
+	return n;
+}
+#endif
+
+/*!
+ * @brief parse a hex word of up to -l pairs.
+ * @return bytes of the word, 0 if not a hex pair.
+ */
+static size_t reverse_hex( const char** pp, const char* end, size_t length, data_t* word )
+{
+	const unsigned char* p = (const unsigned char*)*pp;
+	size_t n = 0;
+
+#ifdef __SSE2__
+	if ( length >= 8 ) { /* not to slow down the short words */
+		n  = reverse_hex_run( p, (const unsigned char*)end, length, word );
+		p += 2 * n;
+	}
+#endif
+	for ( ; n < length && p + 1 < (const unsigned char*)end; n++, p += 2 ) {
+		unsigned int hi = hex_digit[p[0]];
+		unsigned int lo = hex_digit[p[1]];
+		if ( (hi & lo & 0x10) == 0 ) {
+			break;
+		}
+		word[n] = (data_t)((hi << 4) | (lo & 0xf));
+	}
+	*pp = (const char*)p;
+	return n;
+}
+
+/*!
+ * @brief parse a decimal of -i or -u to a word of -l bytes.
+ * @return bytes of the word, 0 if not a decimal or out of range.
+ */
+static size_t reverse_dec( const char** pp, const char* end, const options_t* opt, data_t* word )
+{
+	const char* p = *pp;
+	size_t length = opt->data_length;
+	uint64_t value = 0, limit;
+	bool minus = false;
+	size_t j;
+
+	if ( p < end && *p == '-' && opt->output_type == DECIMAL ) {
+		minus = true;
+		p++;
+	}
+	if ( p >= end || (unsigned)(*p - '0') > 9u ) {
+		return 0;
+	}
+	for ( ; p < end && (unsigned)(*p - '0') <= 9u; p++ ) {
+		unsigned int d = (unsigned)(*p - '0');
+		if ( value > (UINT64_MAX - d) / 10 ) {
+			return 0;
+		}
+		value = value * 10 + d;
+	}
+
+	/* range of -l bytes */
+	if ( opt->output_type == DECIMAL ) {
+		limit = (uint64_t)1 << (length * 8 - 1);
+		if ( (minus == true && value > limit) || (minus == false && value >= limit) ) {
+			return 0;
+		}
+		if ( minus == true ) {
+			value = (uint64_t)0 - value;
+		}
+	} else if ( length < 8 && (value >> (length * 8)) != 0 ) {
+		return 0;
+	}
+
+	for ( j = 0; j < length; j++ ) {
+		word[j] = (data_t)(value >> ((length - 1 - j) * 8));
+	}
+	*pp = p;
+	return length;
+}
+
+/*!
+ * @brief parse a row, and write the binary.
+ *
+ * The words are decoded into buf in place, and -r is undone there.
+ *
+ * @param[in,out] rev
+ * @param[in] p row text without the row delimitter.
+ * @param[in] end
+ * @retval true success.
+ * @retval false the text isn't the dump.
+ */
+static bool reverse_row( reverse_t* rev, const char* p, const char* end )
+{
+	const options_t* opt = rev->opt;
+	size_t length = opt->data_length;
+	bool reorder = (opt->data_order[0] != -1);
+	bool hex = (opt->output_type == HEXADECIMAL);
+	data_t *dst, *top, word[8];
+	size_t n, j, bytes;
+
+	/*** address ***/
+	if ( opt->show_address == true ) {
+		size_t address = 0;
+		const char* q = p;
+		for ( ; p < end && (hex_digit[(unsigned char)*p] & 0x10) != 0; p++ ) {
+			address = (address << 4) | (hex_digit[(unsigned char)*p] & 0xf);
+		}
+		if ( p == q || end - p < 2 || p[0] != ':' || p[1] != ' ' ) {
+			return false;
+		}
+		p += 2;
+		if ( address < opt->start_address || address - opt->start_address < rev->address ) {
+			(void)verbose_printf( VERB_ERR, "Error: address goes back - %lx\n", (unsigned long)address );
+			return false;
+		}
+		reverse_fill( rev, address - opt->start_address );
+	}
+
+	/*** room of the words, a decimal has a digit and -d at least ***/
+	bytes = (size_t)(end - p) / 2 + 1;
+	if ( hex == false ) {
+		bytes *= length;
+	}
+	if ( reverse_room( rev, bytes ) == false ) {
+		return false;
+	}
+	top = dst = &rev->buf[rev->size];
+
+	/*** words of -d '', a run of hex pairs ***/
+	if ( hex == true && rev->delim_len == 0 && reorder == false ) {
+		n = reverse_hex( &p, end, (size_t)(end - p) / 2, dst );
+		if ( n == 0 || p != end ) {
+			return false;
+		}
+		dst += n;
+	}
+
+	/*** words ***/
+	while ( p < end ) {
+		if ( dst != top ) {
+			if ( rev->delim_len == 1 ? (*p != rev->delim[0])
+				: ((size_t)(end - p) < rev->delim_len || memcmp( p, rev->delim, rev->delim_len ) != 0) ) {
+				return false;
+			}
+			p += rev->delim_len;
+		}
+
+		if ( hex == true ) {
+			n = reverse_hex( &p, end, length, dst );
+		} else {
+			n = reverse_dec( &p, end, opt, dst );
+		}
+		if ( n == 0 || (n < length && p != end) ) {
+			return false; /* a short word is only at the end of dump */
+		}
+		if ( reorder == true && n == length ) {
+			memcpy( word, dst, n );
+			for ( j = 0; j < n; j++ ) {
+				dst[opt->data_order[j]] = word[j];
+			}
+		}
+		dst += n;
+	}
+	rev->size    += (size_t)(dst - top);
+	rev->address += (size_t)(dst - top);
+	return true;
+}
+
+/*!
+ * @brief --reverse : parse the dump text of infile back to binary.
+ * @param[in] opt
+ * @retval true success.
+ * @retval false failure.
+ */
+bool bldump_reverse( options_t* opt )
+{
+	reverse_t* rev;
+	file_t infile, outfile;
+	char* text;
+	size_t length = REVERSE_BLOCK; /* text buffer, grows for a long row */
+	size_t size = 0, line = 1;
+	bool is_ok = true, is_eof = false;
+
+	if ( opt->output_type != HEXADECIMAL && opt->output_type != DECIMAL && opt->output_type != UDECIMAL ) {
+		(void)verbose_printf( VERB_ERR, "Error: --reverse supports hexadecimal, -i and -u.\n" );
+		return false;
+	}
+	if ( opt->output_type != HEXADECIMAL && opt->col_delimitter[0] == '\0' ) {
+		(void)verbose_printf( VERB_ERR, "Error: --reverse of decimal needs -d of a character at least.\n" );
+		return false;
+	}
+
+	file_reset( &infile );
+	file_reset( &outfile );
+	if ( file_open( &infile, opt->infile_name, "rb" ) == false ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't open infile - %s\n", opt->infile_name );
+		return false;
+	}
+	if ( opt->outfile_name == NULL ) {
+		outfile.ptr = STDOUT;
+	} else if ( file_open( &outfile, opt->outfile_name, "wb" ) == false ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't open outfile - %s\n", opt->outfile_name );
+		(void)file_close( &infile );
+		return false;
+	}
+
+	rev  = (reverse_t*)calloc( 1, sizeof(reverse_t) );
+	text = (char*)malloc( length );
+	if ( rev != NULL ) {
+		rev->length = REVERSE_BLOCK;
+		rev->buf    = (data_t*)malloc( rev->length );
+	}
+	if ( rev == NULL || rev->buf == NULL || text == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		if ( rev != NULL ) {
+			free( rev->buf );
+		}
+		free( rev );
+		free( text );
+		(void)file_close( &infile );
+		(void)file_close( &outfile );
+		return false;
+	}
+	rev->opt       = opt;
+	rev->out       = outfile.ptr;
+	rev->delim     = opt->col_delimitter;
+	rev->delim_len = strlen( opt->col_delimitter );
+	rev->is_ok     = true;
+
+	while ( is_ok == true && rev->is_ok == true && (is_eof == false || size > 0) ) {
+		char *p = text, *nl;
+
+		/*** read ***/
+		if ( is_eof == false ) {
+			size_t n;
+			if ( size == length ) {
+				char* grown = (char*)realloc( text, length * 2 );
+				if ( grown == NULL ) {
+					(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+					is_ok = false;
+					break;
+				}
+				text    = grown;
+				length *= 2;
+				p       = text;
+			}
+			n = file_fetch( &infile, &text[size], length - size );
+			size += n;
+			if ( infile.failed == true ) {
+				is_ok = false;
+				break;
+			}
+			if ( n == 0 ) {
+				is_eof = true;
+			}
+		}
+
+		/*** rows ***/
+		while ( (nl = (char*)memchr( p, '\n', size - (size_t)(p - text) )) != NULL ) {
+			if ( reverse_row( rev, p, nl ) == false ) {
+				is_ok = false;
+				break;
+			}
+			p = nl + 1;
+			line++;
+		}
+		if ( is_ok == true && is_eof == true && p < &text[size] ) {
+			is_ok = reverse_row( rev, p, &text[size] ); /* no row delimitter at the end */
+			p = &text[size];
+		}
+		size -= (size_t)(p - text);
+		memmove( text, p, size );
+	}
+	if ( is_ok == false ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't parse the dump at line %lu.\n", (unsigned long)line );
+	}
+
+	reverse_flush( rev );
+	if ( rev->is_ok == false ) {
+		is_ok = false;
+	}
+	(void)fflush( outfile.ptr );
+	(void)file_close( &outfile );
+	(void)file_close( &infile );
+	free( text );
+	free( rev->buf );
+	free( rev );
+	return is_ok;
+}
@@ -0,0 +1,448 @@
+/*!
+ * @file
+ * @brief serve - daemon dumping requests from a unix domain socket.
+ * @author yukio
+ *
+ * A request is NUL terminated strings of the working directory of the
+ * client and the arguments of bldump, and the end of the request is
+ * shutdown of the writing side.
+ * The response is frames of a type byte, a 32bit length in host byte
+ * order and the payload. SERVE_OUTPUT frames carry the dump text, and a
+ * SERVE_STATUS frame of one byte ends the response.
+ *
+ * Requests are served one by one through the stream API, reading the
+ * infile by pread(), so that a truncated infile ends the dump rather
+ * than faulting. Reading a request and sending a frame time out after
+ * SERVE_TIMEOUT, so that a stalled client doesn't hold the daemon. Recently used infiles are kept open while their size
+ * and mtime are unchanged. The socket is of the owner only.
+ * If the options aren't supported by the stream, or the infile can't be
+ * opened, the status is SERVE_LOCAL and the client dumps by itself, so
+ * that the messages are the same as without the daemon.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "verbose.h"
+#include "bldump.h"
+
+/*** TEST ***/
+#ifdef TEST
+#define STDOUT	t_stdout
+#define SERVE_TIMEOUT 200 /* ms, not to wait long in tests */
+#else
+#define STDOUT	stdout
+#endif
+
+/*** constant ***/
+#define SERVE_CACHE_SIZE   16          /*!< number of cached infiles. */
+#define SERVE_REQUEST_SIZE (64*1024)   /*!< max size of a request. */
+#define SERVE_ARGS         256         /*!< max number of arguments. */
+#define SERVE_PUSH_SIZE    (64*1024)   /*!< pushing size, outputs are sent at each push. */
+#define SERVE_OUTPUT       'o'         /*!< frame of dump text. */
+#define SERVE_STATUS       'x'         /*!< frame of status, the last frame. */
+#ifndef SERVE_TIMEOUT
+#define SERVE_TIMEOUT      5000        /*!< ms of receiving a request and sending a frame. */
+#endif
+
+/*** status ***/
+enum {
+	SERVE_OK    = 0, /*!< dumped. */
+	SERVE_FAIL  = 1, /*!< failed while dumping. */
+	SERVE_LOCAL = 2  /*!< not dumped, the client should dump by itself. */
+};
+
+/*** serve_cache_t ***/
+typedef struct {
+	char*   name;  /*!< absolute path, NULL if unused. */
+	dev_t   dev;   /*!< device of the file. */
+	ino_t   ino;   /*!< inode of the file. */
+	off_t   size;  /*!< size when opened. */
+	time_t  mtime; /*!< mtime when opened. */
+	int     fd;    /*!< open file descriptor. */
+	unsigned long used; /*!< tick of the last use. */
+} serve_cache_t;
+
+static volatile sig_atomic_t serve_stop = 0; /*!< set by SIGINT and SIGTERM. */
+
+static void serve_signal( int sig )
+{
+	(void)sig;
+	serve_stop = 1;
+}
+
+/*!
+ * @brief write all bytes to the socket.
+ */
+static bool serve_send( int fd, const void* buf, size_t size )
+{
+	const char* p = (const char*)buf;
+	while ( size > 0 ) {
+		ssize_t n = send( fd, p, size, MSG_NOSIGNAL );
+		if ( n < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( n <= 0 ) {
+			return false;
+		}
+		p    += n;
+		size -= (size_t)n;
+	}
+	return true;
+}
+
+/*!
+ * @brief read all bytes from the socket.
+ * @return false at the end of stream or error.
+ */
+static bool serve_recv( int fd, void* buf, size_t size )
+{
+	char* p = (char*)buf;
+	while ( size > 0 ) {
+		ssize_t n = read( fd, p, size );
+		if ( n < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( n <= 0 ) {
+			return false;
+		}
+		p    += n;
+		size -= (size_t)n;
+	}
+	return true;
+}
+
+static bool serve_frame( int fd, char type, const void* buf, size_t size )
+{
+	char head[5];
+	uint32_t len = (uint32_t)size;
+
+	head[0] = type;
+	memcpy( &head[1], &len, sizeof(len) );
+	return serve_send( fd, head, sizeof(head) ) && serve_send( fd, buf, size );
+}
+
+/*!
+ * @brief sink of the stream, sends dump text to the client.
+ */
+static size_t serve_sink( void* user, const char* buf, size_t size )
+{
+	int fd = *(int*)user;
+	return serve_frame( fd, SERVE_OUTPUT, buf, size ) ? size : 0;
+}
+
+/*!
+ * @brief release a cache entry.
+ */
+static void serve_cache_drop( serve_cache_t* entry )
+{
+	if ( entry->name != NULL ) {
+		(void)close( entry->fd );
+		free( entry->name );
+	}
+	memset( entry, 0, sizeof(serve_cache_t) );
+}
+
+/*!
+ * @brief find the open file, or open it.
+ * @param[in,out] cache
+ * @param[in] name absolute path.
+ * @param[in] tick current tick.
+ * @return cache entry, or NULL if the file can't be opened.
+ */
+static serve_cache_t* serve_cache_get( serve_cache_t* cache, const char* name, unsigned long tick )
+{
+	serve_cache_t* entry = NULL;
+	struct stat st;
+	int i, fd;
+
+	if ( stat( name, &st ) != 0 || S_ISREG( st.st_mode ) == 0 ) {
+		return NULL;
+	}
+
+	for ( i = 0; i < SERVE_CACHE_SIZE; i++ ) {
+		serve_cache_t* e = &cache[i];
+		if ( e->name != NULL && strcmp( e->name, name ) == 0 ) {
+			if ( e->dev == st.st_dev && e->ino == st.st_ino
+				&& e->size == st.st_size && e->mtime == st.st_mtime ) {
+				e->used = tick;
+				(void)verbose_printf( VERB_DEBUG, "bldump: serve cached - %s\n", name );
+				return e;
+			}
+			serve_cache_drop( e ); /* modified */
+		}
+	}
+
+	/* the unused or least recently used entry */
+	for ( i = 0; i < SERVE_CACHE_SIZE; i++ ) {
+		if ( entry == NULL || cache[i].name == NULL || cache[i].used < entry->used ) {
+			entry = &cache[i];
+			if ( entry->name == NULL ) {
+				break;
+			}
+		}
+	}
+	serve_cache_drop( entry );
+
+	fd = open( name, O_RDONLY );
+	if ( fd < 0 ) {
+		return NULL;
+	}
+	entry->name  = strclone( name );
+	entry->dev   = st.st_dev;
+	entry->ino   = st.st_ino;
+	entry->size  = st.st_size;
+	entry->mtime = st.st_mtime;
+	entry->fd    = fd;
+	entry->used  = tick;
+	return entry;
+}
+
+/*!
+ * @brief dump a request.
+ * @param[in,out] cache
+ * @param[in] fd connection.
+ * @param[in] tick current tick.
+ * @return status of the response.
+ */
+static char serve_request( serve_cache_t* cache, int fd, unsigned long tick )
+{
+	static char buf[SERVE_REQUEST_SIZE];
+	static data_t data[SERVE_PUSH_SIZE];
+	char* argv[SERVE_ARGS];
+	char* path = NULL;
+	char* cwd;
+	int argc = 0;
+	size_t size = 0, i;
+	ssize_t n;
+	options_t opt;
+	serve_cache_t* entry;
+	bldump_t* ctx;
+	char status = SERVE_LOCAL;
+
+	/*** request ***/
+	while ( size < sizeof(buf) && (n = read( fd, &buf[size], sizeof(buf) - size )) != 0 ) {
+		if ( n < 0 ) {
+			if ( errno == EINTR ) continue;
+			return SERVE_LOCAL;
+		}
+		size += (size_t)n;
+	}
+	if ( size == 0 || size >= sizeof(buf) || buf[size - 1] != '\0' ) {
+		return SERVE_LOCAL;
+	}
+	cwd = buf;
+	for ( i = strlen( cwd ) + 1; i < size && argc < SERVE_ARGS; i += strlen( &buf[i] ) + 1 ) {
+		argv[argc++] = &buf[i];
+	}
+
+	/*** options ***/
+	verbose_level = VERB_DEFAULT;
+	options_reset( &opt );
+	if ( argc == 0 || options_load( &opt, argc, argv ) == false
+		|| opt.outfile_name != NULL || opt.batch_name != NULL || opt.serve_name != NULL || opt.reverse == true
+		|| opt.diff_name != NULL || opt.watch_interval > 0 || opt.follow == true || opt.decompress == true
+		|| opt.compress != COMPRESS_NONE || opt.tee != NULL ) {
+		(void)options_clear( &opt );
+		return SERVE_LOCAL;
+	}
+
+	/*** infile ***/
+	if ( opt.infile_name[0] == '/' ) {
+		path = strclone( opt.infile_name );
+	} else {
+		path = (char*)malloc( strlen( cwd ) + strlen( opt.infile_name ) + 2 );
+		if ( path != NULL ) {
+			(void)sprintf( path, "%s/%s", cwd, opt.infile_name );
+		}
+	}
+	entry = (path != NULL) ? serve_cache_get( cache, path, tick ) : NULL;
+
+	/*** dump ***/
+	ctx = (entry != NULL) ? bldump_open( &opt, serve_sink, &fd ) : NULL;
+	if ( ctx != NULL ) {
+		bool is_ok = true;
+		size_t pos = 0;
+		size_t end = (size_t)entry->size;
+
+		if ( opt.end_address != 0 && opt.end_address < end ) {
+			end = opt.end_address;
+		}
+		while ( is_ok == true && pos < end ) {
+			size_t len = (end - pos < SERVE_PUSH_SIZE) ? end - pos : SERVE_PUSH_SIZE;
+			n = pread( entry->fd, data, len, (off_t)pos );
+			if ( n < 0 && errno == EINTR ) {
+				continue;
+			}
+			if ( n <= 0 ) {
+				is_ok = (n == 0); /* truncated after stat() */
+				break;
+			}
+			is_ok = bldump_push( ctx, data, (size_t)n );
+			pos += (size_t)n;
+		}
+		if ( bldump_close( ctx ) == false ) {
+			is_ok = false;
+		}
+		status = (is_ok == true) ? SERVE_OK : SERVE_FAIL;
+	}
+
+	free( path );
+	(void)options_clear( &opt );
+	return status;
+}
+
+/*!
+ * @brief run as a daemon until SIGINT or SIGTERM.
+ * @param[in] opt opt->serve_name is the socket.
+ * @retval true stopped by a signal.
+ * @retval false failure.
+ */
+bool bldump_serve( options_t* opt )
+{
+	serve_cache_t cache[SERVE_CACHE_SIZE];
+	struct sockaddr_un addr;
+	struct sigaction sa;
+	unsigned long tick = 0;
+	unsigned int level = verbose_level;
+	bool is_bound;
+	mode_t mask;
+	int sock, i;
+
+	if ( strlen( opt->serve_name ) >= sizeof(addr.sun_path) ) {
+		(void)verbose_printf( VERB_ERR, "Error: too long socket name - %s\n", opt->serve_name );
+		return false;
+	}
+	memset( &addr, 0, sizeof(addr) );
+	addr.sun_family = AF_UNIX;
+	strcpy( addr.sun_path, opt->serve_name );
+
+	sock = socket( AF_UNIX, SOCK_STREAM, 0 );
+	if ( sock < 0 ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't create socket\n" );
+		return false;
+	}
+	(void)unlink( opt->serve_name );
+	mask = umask( 0177 ); /* 0600, the daemon reads files for the owner only */
+	is_bound = bind( sock, (struct sockaddr*)&addr, sizeof(addr) ) == 0;
+	(void)umask( mask );
+	if ( is_bound == false || listen( sock, 16 ) != 0 ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't listen socket - %s\n", opt->serve_name );
+		(void)close( sock );
+		return false;
+	}
+
+	/* accept() is interrupted by the signals */
+	memset( &sa, 0, sizeof(sa) );
+	sa.sa_handler = serve_signal;
+	(void)sigaction( SIGINT, &sa, NULL );
+	(void)sigaction( SIGTERM, &sa, NULL );
+
+	memset( cache, 0, sizeof(cache) );
+	(void)verbose_printf( VERB_NOTICE, "bldump: serve - %s\n", opt->serve_name );
+
+	while ( serve_stop == 0 ) {
+		struct timeval tv;
+		char status;
+		int fd = accept( sock, NULL, NULL );
+		if ( fd < 0 ) {
+			continue;
+		}
+		/* a stalled client fails by EAGAIN, and the next one is served */
+		tv.tv_sec  = SERVE_TIMEOUT / 1000;
+		tv.tv_usec = (SERVE_TIMEOUT % 1000) * 1000;
+		if ( setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv) ) != 0
+			|| setsockopt( fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv) ) != 0 ) {
+			(void)close( fd );
+			continue;
+		}
+		status = serve_request( cache, fd, ++tick );
+		verbose_level = level; /* -v of the request */
+		(void)serve_frame( fd, SERVE_STATUS, &status, 1 );
+		(void)close( fd );
+	}
+
+	for ( i = 0; i < SERVE_CACHE_SIZE; i++ ) {
+		serve_cache_drop( &cache[i] );
+	}
+	(void)close( sock );
+	(void)unlink( opt->serve_name );
+	serve_stop = 0;
+	return true;
+}
+
+/*!
+ * @brief forward the arguments to the daemon.
+ * @param[in] name socket of the daemon.
+ * @param[in] argc
+ * @param[in] argv
+ * @return exit status, or -1 if the daemon isn't running or can't dump it.
+ */
+int bldump_forward( const char* name, int argc, char* argv[] )
+{
+	struct sockaddr_un addr;
+	char cwd[4096];
+	char head[5];
+	char buf[4096];
+	char status = SERVE_LOCAL;
+	uint32_t len;
+	int sock, i;
+	bool is_ok;
+
+	if ( strlen( name ) >= sizeof(addr.sun_path) || getcwd( cwd, sizeof(cwd) ) == NULL ) {
+		return -1;
+	}
+	memset( &addr, 0, sizeof(addr) );
+	addr.sun_family = AF_UNIX;
+	strcpy( addr.sun_path, name );
+
+	sock = socket( AF_UNIX, SOCK_STREAM, 0 );
+	if ( sock < 0 ) {
+		return -1;
+	}
+	if ( connect( sock, (struct sockaddr*)&addr, sizeof(addr) ) != 0 ) {
+		(void)close( sock );
+		return -1;
+	}
+
+	/*** request ***/
+	is_ok = serve_send( sock, cwd, strlen( cwd ) + 1 );
+	for ( i = 0; is_ok == true && i < argc; i++ ) {
+		is_ok = serve_send( sock, argv[i], strlen( argv[i] ) + 1 );
+	}
+	(void)shutdown( sock, SHUT_WR );
+
+	/*** response ***/
+	while ( is_ok == true && serve_recv( sock, head, sizeof(head) ) == true ) {
+		memcpy( &len, &head[1], sizeof(len) );
+		if ( head[0] == SERVE_STATUS ) {
+			is_ok = (len == 1) && serve_recv( sock, &status, 1 );
+			break;
+		}
+		while ( is_ok == true && len > 0 ) {
+			size_t n = (len < sizeof(buf)) ? len : sizeof(buf);
+			is_ok = serve_recv( sock, buf, n );
+			(void)fwrite( buf, 1, n, STDOUT );
+			len -= (uint32_t)n;
+		}
+	}
+	(void)close( sock );
+	(void)fflush( STDOUT );
+
+	if ( is_ok == false ) {
+		return 1;
+	}
+	return (status == SERVE_LOCAL) ? -1 : (int)status;
+}
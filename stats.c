@@ -0,0 +1,199 @@
+/*!
+ * @file
+ * @brief stats - per-stage timers and counters of --stats.
+ * @author yukio
+ *
+ * The engine measures the stages only if opt->stats isn't NULL, so
+ * a dump without --stats pays a branch per stage.
+ * The outfile is replaced by a stream of fopencookie() which counts the
+ * bytes and the write system calls to the real outfile.
+ */
+
+#define _GNU_SOURCE /* fopencookie */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include "verbose.h"
+#include "bldump.h"
+
+static const char* stats_stage_name[STATS_STAGES] = {
+	"read", "search", "reorder", "write", "flush"
+};
+
+/*!
+ * @brief monotonic time in ns.
+ */
+uint64_t stats_now(void)
+{
+	struct timespec ts;
+	(void)clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint64_t)ts.tv_sec * 1000000000uLL + (uint64_t)ts.tv_nsec;
+}
+
+/*!
+ * @brief add the time from start to the stage.
+ * @param[in,out] stats
+ * @param[in] stage STATS_STAGE
+ * @param[in] start stats_now() at the start of the stage.
+ */
+void stats_add( stats_t* stats, int stage, uint64_t start )
+{
+	stats->ns[stage] += stats_now() - start;
+	stats->calls[stage]++;
+}
+
+/*!
+ * @brief add the counters of another run, e.g. a worker of --batch.
+ * @param[in,out] stats
+ * @param[in] from
+ */
+void stats_merge( stats_t* stats, const stats_t* from )
+{
+	int i;
+
+	for ( i = 0; i < STATS_STAGES; i++ ) {
+		stats->ns[i]    += from->ns[i];
+		stats->calls[i] += from->calls[i];
+	}
+	stats->bytes_in  += from->bytes_in;
+	stats->bytes_out += from->bytes_out;
+	stats->rows      += from->rows;
+	stats->reads     += from->reads;
+	stats->writes    += from->writes;
+	stats->searches  += from->searches;
+	stats->resyncs   += from->resyncs;
+	stats->skipped   += from->skipped;
+	stats->rejected  += from->rejected;
+}
+
+static ssize_t stats_write( void* cookie, const char* buf, size_t size )
+{
+	stats_t* stats = (stats_t*)cookie;
+	int fd = fileno( stats->real );
+	size_t done = 0;
+
+	while ( done < size ) {
+		ssize_t n = write( fd, &buf[done], size - done );
+		stats->writes++;
+		if ( n < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( n <= 0 ) {
+			break;
+		}
+		done += (size_t)n;
+	}
+	stats->bytes_out += done;
+	return (ssize_t)done;
+}
+
+static int stats_seek( void* cookie, off64_t* offset, int whence )
+{
+	stats_t* stats = (stats_t*)cookie;
+	off_t pos = lseek( fileno( stats->real ), (off_t)*offset, whence );
+	if ( pos < 0 ) {
+		return -1;
+	}
+	*offset = (off64_t)pos;
+	return 0;
+}
+
+/*!
+ * @brief count the output to outfile.
+ * @param[in,out] stats
+ * @param[in,out] outfile outfile->ptr is replaced until stats_detach().
+ * @param[in] row_size bytes of a record.
+ * @retval true success.
+ * @retval false failure, outfile isn't changed.
+ */
+bool stats_attach( stats_t* stats, file_t* outfile, size_t row_size )
+{
+	static const cookie_io_functions_t io = { NULL, stats_write, stats_seek, NULL };
+	FILE* fp;
+
+	stats->row_size = row_size;
+	if ( outfile->ptr == NULL ) {
+		return true; /* --columns */
+	}
+	(void)fflush( outfile->ptr );
+	fp = fopencookie( stats, "w", io );
+	if ( fp == NULL ) {
+		return false;
+	}
+	stats->real  = outfile->ptr;
+	outfile->ptr = fp;
+	return true;
+}
+
+/*!
+ * @brief flush the counting stream, and restore outfile.
+ */
+void stats_detach( stats_t* stats, file_t* outfile )
+{
+	if ( stats->real != NULL ) {
+		(void)fclose( outfile->ptr );
+		outfile->ptr = stats->real;
+		stats->real  = NULL;
+	}
+}
+
+/*!
+ * @brief print the statistics.
+ * @param[in] stats
+ * @param[in] fp stream, usually stderr.
+ */
+void stats_print( stats_t* stats, FILE* fp )
+{
+	uint64_t total = 0;
+	int i;
+
+	for ( i = 0; i < STATS_STAGES; i++ ) {
+		total += stats->ns[i];
+	}
+
+	if ( stats->json == true ) {
+		fprintf( fp, "{\"stages\":{" );
+		for ( i = 0; i < STATS_STAGES; i++ ) {
+			fprintf( fp, "%s\"%s\":{\"calls\":%llu,\"ns\":%llu}", (i == 0) ? "" : ",",
+				stats_stage_name[i], (unsigned long long)stats->calls[i], (unsigned long long)stats->ns[i] );
+		}
+		fprintf( fp, "},\"total_ns\":%llu,\"bytes_in\":%llu,\"bytes_out\":%llu,\"rows\":%llu,"
+			"\"reads\":%llu,\"writes\":%llu,\"searches\":%llu,\"resyncs\":%llu,\"skipped\":%llu,\"rejected\":%llu}\n",
+			(unsigned long long)total,
+			(unsigned long long)stats->bytes_in, (unsigned long long)stats->bytes_out,
+			(unsigned long long)stats->rows, (unsigned long long)stats->reads,
+			(unsigned long long)stats->writes, (unsigned long long)stats->searches,
+			(unsigned long long)stats->resyncs, (unsigned long long)stats->skipped,
+			(unsigned long long)stats->rejected );
+		return;
+	}
+
+	fprintf( fp, "%-10s %12s %12s %8s\n", "stage", "calls", "ms", "%" );
+	for ( i = 0; i < STATS_STAGES; i++ ) {
+		fprintf( fp, "%-10s %12llu %12.3f %8.1f\n", stats_stage_name[i],
+			(unsigned long long)stats->calls[i], (double)stats->ns[i] / 1e6,
+			(total > 0) ? 100.0 * (double)stats->ns[i] / (double)total : 0.0 );
+	}
+	fprintf( fp, "%-10s %12s %12.3f\n", "total", "", (double)total / 1e6 );
+	fprintf( fp, "bytes in   %llu (%.1f MB/s)\n", (unsigned long long)stats->bytes_in,
+		(total > 0) ? (double)stats->bytes_in * 1e3 / (double)total : 0.0 );
+	fprintf( fp, "bytes out  %llu\n", (unsigned long long)stats->bytes_out );
+	fprintf( fp, "rows       %llu\n", (unsigned long long)stats->rows );
+	fprintf( fp, "reads      %llu\n", (unsigned long long)stats->reads );
+	fprintf( fp, "writes     %llu\n", (unsigned long long)stats->writes );
+	if ( stats->searches > 0 ) {
+		fprintf( fp, "searches   %llu\n", (unsigned long long)stats->searches );
+		fprintf( fp, "resyncs    %llu (%llu bytes skipped)\n",
+			(unsigned long long)stats->resyncs, (unsigned long long)stats->skipped );
+	}
+	if ( stats->rejected > 0 ) {
+		fprintf( fp, "rejected   %llu\n", (unsigned long long)stats->rejected );
+	}
+}
@@ -0,0 +1,323 @@
+/*!
+ * @file
+ * @brief stream - push API of the dump engine for embedding.
+ * @author yukio
+ *
+ * A caller feeds bytes by bldump_push() in any chunk size, and receives
+ * the formatted text through the sink given to bldump_open().
+ * All the state is in bldump_t, so that many streams can run in
+ * parallel threads: the counters of --stats and the verbosity are of
+ * each stream, and the messages of a push go to the verbose_out of
+ * bldump_open() or bldump_verbose(), by verbose_scope() of the thread.
+ * The writers of bldump.c print to a FILE of fopencookie() which
+ * forwards to the sink.
+ *
+ * @code
+ * options_t opt;
+ * options_reset( &opt );
+ * (void)options_load( &opt, argc, argv );
+ * ctx = bldump_open( &opt, sink, user );
+ * while ( (n = recv( sock, buf, sizeof(buf), 0 )) > 0 ) bldump_push( ctx, buf, n );
+ * bldump_close( ctx );
+ * options_clear( &opt );
+ * @endcode
+ */
+
+#define _GNU_SOURCE /* fopencookie */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "verbose.h"
+#include "bldump.h"
+
+#define min(a,b) ((a)>(b)?(b):(a))
+
+/*** bldump_t ***/
+struct bldump_s {
+	options_t     opt;      /*!< copy of options, pointers are shared. */
+	memory_t      memory;   /*!< a record being filled. */
+	file_t        outfile;  /*!< cookie file to the sink. */
+	bldump_sink_t sink;     /*!< output sink. */
+	void*         user;     /*!< user data of the sink. */
+	size_t        position; /*!< stream address of the next pushed byte. */
+	uint64_t      window;   /*!< -S : last pushed bytes while searching. */
+	size_t        charged;  /*!< -S : bytes in the window. */
+	bool          is_ok;    /*!< false after an error. */
+	stats_t       stats;    /*!< --stats : counters of this stream. */
+	verbose_t     verbose;  /*!< verbosity of this stream. */
+};
+
+static ssize_t stream_write( void* cookie, const char* buf, size_t size )
+{
+	bldump_t* ctx = (bldump_t*)cookie;
+	size_t n = ctx->sink( ctx->user, buf, size );
+	if ( n < size ) {
+		if ( ctx->is_ok == true ) {
+			(void)verbose_printf( VERB_ERR, "Error: sink of stream failed.\n" );
+		}
+		ctx->is_ok = false;
+	}
+	if ( ctx->opt.stats != NULL ) {
+		ctx->stats.writes++;
+		ctx->stats.bytes_out += n;
+	}
+	return (ssize_t)n;
+}
+
+/*!
+ * @brief open a stream in the verbosity of it, see bldump_open().
+ */
+static bldump_t* stream_open( const options_t* opt, bldump_sink_t sink, void* user, const verbose_t* verbose )
+{
+	static const cookie_io_functions_t io = { NULL, stream_write, NULL, NULL };
+	bldump_t* ctx;
+	size_t size;
+	const char* unsupported = NULL;
+
+	if ( opt->range_count > 0 )            unsupported = "--ranges";
+	else if ( opt->stride > 0 )            unsupported = "--stride";
+	else if ( opt->npy_output == true )    unsupported = "--npy";
+	else if ( opt->column_output == true ) unsupported = "--columns";
+	else if ( opt->batch_name != NULL )    unsupported = "--batch";
+	else if ( opt->reverse == true )       unsupported = "--reverse";
+	else if ( opt->compress != COMPRESS_NONE ) unsupported = "--compress";
+	else if ( opt->tee != NULL )           unsupported = "--out";
+	else if ( opt->decompress == true )    unsupported = "-z";
+	else if ( opt->diff_name != NULL )     unsupported = "--diff";
+	else if ( opt->watch_interval > 0 )    unsupported = "--watch";
+	if ( unsupported != NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: %s is not supported by stream.\n", unsupported );
+		return NULL;
+	}
+	if ( sink == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: no sink of stream.\n" );
+		return NULL;
+	}
+
+	ctx = (bldump_t*)calloc( 1, sizeof(bldump_t) );
+	if ( ctx == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		return NULL;
+	}
+	ctx->opt   = *opt;
+	ctx->sink  = sink;
+	ctx->user  = user;
+	ctx->is_ok = true;
+	ctx->verbose = *verbose;
+	memory_init( &ctx->memory );
+	file_reset( &ctx->outfile );
+
+	size = bldump_record_size( &ctx->opt );
+	if ( size == 0 || memory_allocate( &ctx->memory, size ) == false ) {
+		free( ctx );
+		return NULL;
+	}
+	if ( opt->stats != NULL ) { /* not shared with the other streams of opt */
+		ctx->stats.json     = opt->stats->json;
+		ctx->stats.row_size = size;
+		ctx->opt.stats      = &ctx->stats;
+	}
+	ctx->outfile.ptr = fopencookie( ctx, "w", io );
+	if ( ctx->outfile.ptr == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't open stream.\n" );
+		(void)memory_free( &ctx->memory );
+		free( ctx );
+		return NULL;
+	}
+	return ctx;
+}
+
+/*!
+ * @brief open a stream.
+ *
+ * The options which seek the infile or the outfile(--ranges, --stride,
+ * --npy, --columns and --batch), the outfiles of --compress and --out,
+ * -z, --diff and --watch aren't supported, while --follow is of the
+ * pushing side. The stream counts
+ * --stats by itself, see bldump_stats(), and its verbose level is -v of
+ * opt or verbose_level, to verbose_out at the time.
+ * @param[in] opt options, must be kept until bldump_close().
+ * @param[in] sink function receiving the formatted text.
+ * @param[in] user passed to the sink.
+ * @return context, or NULL on failure.
+ */
+bldump_t* bldump_open( const options_t* opt, bldump_sink_t sink, void* user )
+{
+	verbose_t verbose;
+	const verbose_t* prev;
+	bldump_t* ctx;
+
+	verbose.level = (opt->verbose >= 0) ? (unsigned int)opt->verbose : verbose_level;
+	verbose.out   = verbose_out;
+	prev = verbose_scope( &verbose );
+	ctx  = stream_open( opt, sink, user, &verbose );
+	(void)verbose_scope( prev );
+	return ctx;
+}
+
+/*!
+ * @brief write the filled record.
+ */
+static void stream_flush_record( bldump_t* ctx )
+{
+	memory_reorder( &ctx->memory, &ctx->opt );
+	if ( ctx->opt.where != NULL && where_match( ctx->opt.where, &ctx->memory ) == false ) {
+		if ( ctx->opt.stats != NULL ) {
+			ctx->stats.rejected++;
+		}
+	} else if ( bldump_write( &ctx->memory, &ctx->outfile, &ctx->opt ) == false ) {
+		ctx->is_ok = false;
+	}
+	memory_clear( &ctx->memory );
+}
+
+/*!
+ * @brief -S : search the pattern in the pushed bytes, as file_search().
+ *
+ * The window is kept between pushes, so that a pattern split across
+ * them is found. On a match, the record starts with the pattern.
+ * @return bytes consumed, up to the end of the pattern.
+ */
+static size_t stream_search( bldump_t* ctx, const data_t* p, size_t size )
+{
+	memory_t* memory = &ctx->memory;
+	uint64_t mask = (uint64_t)((0x1uLL << ctx->opt.search_length) - 0x1uLL);
+	size_t search_bytes = (size_t)ctx->opt.search_length / 8;
+	size_t i, j;
+
+	for ( i = 0; i < size; ) {
+		ctx->window = (ctx->window << 8) | p[i++];
+		ctx->charged++;
+		if ( ctx->charged >= search_bytes && (ctx->window & mask) == ctx->opt.search_pattern ) {
+			memory->address = ctx->position + i - search_bytes;
+			for ( j = 0; j < search_bytes && j < memory->length; j++ ) {
+				memory->data[j] = (data_t)(ctx->opt.search_pattern >> ((search_bytes - 1 - j) * 8));
+			}
+			memory->size = j;
+			ctx->window  = 0;
+			ctx->charged = 0;
+			break;
+		}
+	}
+	return i;
+}
+
+/*!
+ * @brief push bytes into the stream.
+ *
+ * The address of the first pushed byte is 0. Bytes before -s and after
+ * -e are skipped. Complete records are written to the sink before
+ * returning, and the rest is kept until the next push, as well as the
+ * bytes being searched for -S.
+ * @param[in,out] ctx
+ * @param[in] buf bytes.
+ * @param[in] size size of buf.
+ * @retval true success.
+ * @retval false failure of the sink or the writers.
+ */
+bool bldump_push( bldump_t* ctx, const void* buf, size_t size )
+{
+	const data_t* p = (const data_t*)buf;
+	memory_t* memory = &ctx->memory;
+	const verbose_t* prev = verbose_scope( &ctx->verbose );
+	size_t n;
+
+	if ( ctx->opt.stats != NULL ) {
+		ctx->stats.reads++;
+		ctx->stats.bytes_in += size;
+	}
+	while ( size > 0 && ctx->is_ok == true ) {
+		/* -s, -e */
+		if ( ctx->position < ctx->opt.start_address ) {
+			n = min( ctx->opt.start_address - ctx->position, size );
+		} else if ( ctx->opt.end_address != 0 && ctx->position >= ctx->opt.end_address ) {
+			n = size;
+		} else if ( ctx->opt.search_length > 0 && memory->size == 0 ) {
+			n = size;
+			if ( ctx->opt.end_address != 0 ) {
+				n = min( ctx->opt.end_address - ctx->position, n );
+			}
+			n = stream_search( ctx, p, n );
+			if ( memory->size == memory->length ) {
+				stream_flush_record( ctx );
+			}
+		} else {
+			n = min( memory->length - memory->size, size );
+			if ( ctx->opt.end_address != 0 ) {
+				n = min( ctx->opt.end_address - ctx->position, n );
+			}
+			if ( memory->size == 0 ) {
+				memory->address = ctx->position;
+			}
+			memcpy( &memory->data[memory->size], p, n );
+			memory->size += n;
+			if ( memory->size == memory->length ) {
+				stream_flush_record( ctx );
+			}
+		}
+		ctx->position += n;
+		p    += n;
+		size -= n;
+	}
+
+	if ( fflush( ctx->outfile.ptr ) != 0 ) {
+		ctx->is_ok = false;
+	}
+	(void)verbose_scope( prev );
+	return ctx->is_ok;
+}
+
+/*!
+ * @brief close the stream.
+ *
+ * Writes the last partial record, and frees the context.
+ * @param[in] ctx
+ * @retval true success.
+ * @retval false failure in the stream.
+ */
+bool bldump_close( bldump_t* ctx )
+{
+	const verbose_t* prev = verbose_scope( &ctx->verbose );
+	bool is_ok;
+
+	if ( ctx->is_ok == true && ctx->memory.size > 0 ) {
+		stream_flush_record( ctx );
+	}
+	if ( ctx->is_ok == true ) {
+		ctx->is_ok = bldump_finish( &ctx->memory, &ctx->outfile, &ctx->opt );
+	}
+	if ( fclose( ctx->outfile.ptr ) != 0 ) {
+		ctx->is_ok = false;
+	}
+	(void)memory_free( &ctx->memory );
+	is_ok = ctx->is_ok;
+	free( ctx );
+	(void)verbose_scope( prev );
+	return is_ok;
+}
+
+/*!
+ * @brief set the verbosity of the stream.
+ * @param[in,out] ctx
+ * @param[in] level verbose level.
+ * @param[in] out messages, NULL for none.
+ */
+void bldump_verbose( bldump_t* ctx, unsigned int level, FILE* out )
+{
+	ctx->verbose.level = level;
+	ctx->verbose.out   = out;
+}
+
+/*!
+ * @brief --stats of the stream.
+ * @param[in] ctx
+ * @return counters until bldump_close(), NULL without --stats.
+ */
+const stats_t* bldump_stats( const bldump_t* ctx )
+{
+	return ctx->opt.stats;
+}
@@ -0,0 +1,210 @@
+/*!
+ * @file
+ * @brief unit test of 'batch.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_BATCH_DIR  "t-batch.dir" /*!< directory of test files. */
+#define T_BATCH_LIST "t-batch.lst" /*!< list of test files. */
+
+/*!
+ * @brief make T_BATCH_DIR/<name> filled with n bytes of 0, 1, 2, ...
+ */
+static void t_batch_mkfile( const char* name, int n )
+{
+	char path[80];
+	FILE* fp;
+	int i;
+
+	(void)sprintf( path, "%s/%s", T_BATCH_DIR, name );
+	fp = fopen( path, "wb" );
+	assert( fp != NULL );
+	for ( i = 0; i < n; i++ ) fputc( i, fp );
+	fclose( fp );
+}
+
+/*!
+ * @brief read the 1st line of T_BATCH_DIR/<name>.
+ */
+static void t_batch_head( const char* name, char* act, int size )
+{
+	char path[80];
+	FILE* fp;
+	char* s;
+
+	(void)sprintf( path, "%s/%s", T_BATCH_DIR, name );
+	fp = fopen( path, "rt" );
+	assert( fp != NULL );
+	s = fgets( act, size, fp );
+	assert( s == act );
+	fclose( fp );
+}
+
+/*!
+ * @brief test "bldump -f 4 --batch=<list> --jobs=2"
+ */
+static void t_batch_list(void)
+{
+	options_t opt;
+	char* argv[] = { "bldump", "-f", "4", "--batch=" T_BATCH_LIST, "--jobs=2" };
+	char act[80];
+	char* s;
+	bool ret;
+	FILE* fp;
+
+	/* make input data */
+	t_batch_mkfile( "a.bin", 6 );
+	t_batch_mkfile( "b.bin", 2 );
+	t_batch_mkfile( "c.bin", 4 );
+	fp = fopen( T_BATCH_LIST, "wt" );
+	assert( fp != NULL );
+	fprintf( fp, "# comment\n" );
+	fprintf( fp, "%s/a.bin %s/a.txt\n", T_BATCH_DIR, T_BATCH_DIR );
+	fprintf( fp, "\n" );
+	fprintf( fp, "%s/b.bin\n", T_BATCH_DIR );
+	fprintf( fp, "%s/c.bin\t%s/c.txt\n", T_BATCH_DIR, T_BATCH_DIR );
+	fclose( fp );
+
+	options_reset( &opt );
+	ret = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, true );
+	mu_assert_string_equal( opt.batch_name, T_BATCH_LIST );
+	mu_assert_equal( opt.jobs, 2 );
+
+	fseek( t_stdout, 0, SEEK_SET );
+	ret = bldump_batch( &opt );
+	mu_assert_equal( ret, true );
+
+	/* status */
+	fflush( t_stdout );
+	fseek( t_stdout, 0, SEEK_SET );
+	s = fgets( act, (int)sizeof(act), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "ok\t" T_BATCH_DIR "/a.bin\t" T_BATCH_DIR "/a.txt\t6\n" );
+	s = fgets( act, (int)sizeof(act), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "ok\t" T_BATCH_DIR "/b.bin\t" T_BATCH_DIR "/b.bin.dump\t2\n" );
+	s = fgets( act, (int)sizeof(act), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "ok\t" T_BATCH_DIR "/c.bin\t" T_BATCH_DIR "/c.txt\t4\n" );
+
+	/* outfiles */
+	t_batch_head( "a.txt", act, (int)sizeof(act) );
+	mu_assert_string_equal( act, "00 01 02 03\n" );
+	t_batch_head( "b.bin.dump", act, (int)sizeof(act) );
+	mu_assert_string_equal( act, "00 01\n" );
+	t_batch_head( "c.txt", act, (int)sizeof(act) );
+	mu_assert_string_equal( act, "00 01 02 03\n" );
+
+	/* missing infile */
+	fp = fopen( T_BATCH_LIST, "at" );
+	assert( fp != NULL );
+	fprintf( fp, "%s/none.bin\n", T_BATCH_DIR );
+	fclose( fp );
+	fseek( t_stdout, 0, SEEK_SET );
+	ret = bldump_batch( &opt );
+	mu_assert_equal( ret, false );
+
+	(void)options_clear( &opt );
+	(void)remove( T_BATCH_LIST );
+	(void)remove( T_BATCH_DIR "/a.txt" );
+	(void)remove( T_BATCH_DIR "/b.bin.dump" );
+	(void)remove( T_BATCH_DIR "/c.txt" );
+	(void)remove( T_BATCH_DIR "/none.bin.dump" );
+}
+
+/*!
+ * @brief test "bldump -A -d '' --batch=<dir>"
+ */
+static void t_batch_dir(void)
+{
+	options_t opt;
+	char* argv[] = { "bldump", "-A", "-d", "", "--batch=" T_BATCH_DIR };
+	char act[80];
+	char* s;
+	bool ret;
+
+	options_reset( &opt );
+	ret = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, true );
+
+	fseek( t_stdout, 0, SEEK_SET );
+	ret = bldump_batch( &opt );
+	mu_assert_equal( ret, true );
+
+	/* sorted by name */
+	fflush( t_stdout );
+	fseek( t_stdout, 0, SEEK_SET );
+	s = fgets( act, (int)sizeof(act), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "ok\t" T_BATCH_DIR "/a.bin\t" T_BATCH_DIR "/a.bin.dump\t6\n" );
+	s = fgets( act, (int)sizeof(act), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "ok\t" T_BATCH_DIR "/b.bin\t" T_BATCH_DIR "/b.bin.dump\t2\n" );
+	s = fgets( act, (int)sizeof(act), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "ok\t" T_BATCH_DIR "/c.bin\t" T_BATCH_DIR "/c.bin.dump\t4\n" );
+
+	/* *.dump of the 1st run are not dumped again */
+	fseek( t_stdout, 0, SEEK_SET );
+	ret = bldump_batch( &opt );
+	mu_assert_equal( ret, true );
+	fflush( t_stdout );
+	fseek( t_stdout, 0, SEEK_SET );
+	s = fgets( act, (int)sizeof(act), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "ok\t" T_BATCH_DIR "/a.bin\t" T_BATCH_DIR "/a.bin.dump\t6\n" );
+
+	(void)options_clear( &opt );
+
+	/* --stats of the workers are added up */
+	{
+		char* argv2[] = { "bldump", "--stats", "-f", "4", "--jobs=2", "--batch=" T_BATCH_DIR };
+		options_reset( &opt );
+		ret = options_load( &opt, (int)(sizeof(argv2)/sizeof(char*)), argv2 );
+		mu_assert_equal( ret, true );
+		ret = bldump_batch( &opt );
+		mu_assert_equal( ret, true );
+		assert( opt.stats != NULL );
+		mu_assert_equal( opt.stats->bytes_in, 12 );
+		mu_assert_equal( opt.stats->rows, 4 );
+		mu_assert_equal( opt.stats->bytes_out, 36 );
+		(void)options_clear( &opt );
+	}
+	(void)remove( T_BATCH_DIR "/a.bin.dump" );
+	(void)remove( T_BATCH_DIR "/b.bin.dump" );
+	(void)remove( T_BATCH_DIR "/c.bin.dump" );
+}
+
+void ts_batch(void)
+{
+	/* init */
+	t_stdout = tmpfile();
+	verbose_out = tmpfile();
+	assert( t_stdout != NULL && verbose_out != NULL );
+	(void)mkdir( T_BATCH_DIR, 0755 );
+
+	/* test */
+	mu_run_test(t_batch_list); // bldump -f 4 --batch=<list> --jobs=2
+	mu_run_test(t_batch_dir);  // bldump -A -d '' --batch=<dir>
+
+	/* cleanup */
+	(void)remove( T_BATCH_DIR "/a.bin" );
+	(void)remove( T_BATCH_DIR "/b.bin" );
+	(void)remove( T_BATCH_DIR "/c.bin" );
+	(void)rmdir( T_BATCH_DIR );
+	(void)fclose( t_stdout );
+	(void)fclose( verbose_out );
+	t_stdout = NULL;
+	verbose_out = NULL;
+}
@@ -0,0 +1,196 @@
+/*!
+ * @file
+ * @brief microbenchmarks of the kernels, run by 'bldump-test --bench [<iters>]'.
+ *
+ * The kernels are called on in-memory data, and the output is written
+ * to /dev/null, so that CPU cost is separated from I/O. file_search
+ * reads a small file, which stays in the buffer of file_t.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_BENCH_SIZE (64*1024) /*!< bytes of the data. */
+#define T_BENCH_IN   "t-bench.tmp" /*!< infile of file_search. */
+
+static data_t  t_bench_data[T_BENCH_SIZE]; /*!< random data. */
+static file_t  t_bench_out;                /*!< /dev/null */
+
+/*!
+ * @brief load options from arguments.
+ */
+static void t_bench_options( options_t* opt, int argc, char* argv[] )
+{
+	bool ret;
+	options_reset( opt );
+	ret = options_load( opt, argc, argv );
+	assert( ret == true );
+	(void)ret;
+}
+
+/*!
+ * @brief run a writer on each row of the data.
+ */
+static void t_bench_rows( void (*writer)( memory_t*, file_t*, options_t* ), options_t* opt )
+{
+	memory_t memory;
+	size_t row = opt->data_length * (size_t)opt->data_fields;
+	size_t pos;
+
+	memory_init( &memory );
+	for ( pos = 0; pos + row <= T_BENCH_SIZE; pos += row ) {
+		memory.address = pos;
+		memory.data    = &t_bench_data[pos];
+		memory.length  = row;
+		memory.size    = row;
+		writer( &memory, &t_bench_out, opt );
+	}
+}
+
+/*!
+ * @brief write_hex, -a and -A.
+ */
+static void b_write_hex(void)
+{
+	options_t opt;
+	char* argv_hex[]  = { "bldump", "b" };
+	char* argv_addr[] = { "bldump", "-a", "b" };
+
+	t_bench_options( &opt, (int)(sizeof(argv_hex)/sizeof(char*)), argv_hex );
+	mu_bench( "write_hex", "scalar", T_BENCH_SIZE, t_bench_rows( write_hex, &opt ) );
+	(void)options_clear( &opt );
+
+	t_bench_options( &opt, (int)(sizeof(argv_addr)/sizeof(char*)), argv_addr );
+	mu_bench( "write_hex -a", "scalar", T_BENCH_SIZE, t_bench_rows( write_hex, &opt ) );
+	(void)options_clear( &opt );
+}
+
+/*!
+ * @brief write_dec, -i -l 2 and -u -l 8.
+ */
+static void b_write_dec(void)
+{
+	options_t opt;
+	char* argv_i2[] = { "bldump", "-i", "-l", "2", "b" };
+	char* argv_u8[] = { "bldump", "-u", "-l", "8", "b" };
+
+	t_bench_options( &opt, (int)(sizeof(argv_i2)/sizeof(char*)), argv_i2 );
+	mu_bench( "write_dec -i -l 2", "scalar", T_BENCH_SIZE, t_bench_rows( write_dec, &opt ) );
+	(void)options_clear( &opt );
+
+	t_bench_options( &opt, (int)(sizeof(argv_u8)/sizeof(char*)), argv_u8 );
+	mu_bench( "write_dec -u -l 8", "scalar", T_BENCH_SIZE, t_bench_rows( write_dec, &opt ) );
+	(void)options_clear( &opt );
+}
+
+/*!
+ * @brief to_printable.
+ */
+static void b_to_printable(void)
+{
+	static data_t work[T_BENCH_SIZE];
+	memory_t memory;
+
+	memory_init( &memory );
+	memory.data   = work;
+	memory.length = T_BENCH_SIZE;
+	memory.size   = T_BENCH_SIZE;
+	mu_bench( "to_printable", "scalar", T_BENCH_SIZE,
+		( memcpy( work, t_bench_data, T_BENCH_SIZE ), to_printable( &memory ) ) );
+}
+
+/*!
+ * @brief memory_reorder, -r 3210 and -r 10.
+ */
+static void b_reorder(void)
+{
+	static data_t work[T_BENCH_SIZE];
+	options_t opt;
+	memory_t memory;
+	char* argv_r4[] = { "bldump", "-r", "3210", "b" };
+	char* argv_r2[] = { "bldump", "-r", "10", "b" };
+
+	memcpy( work, t_bench_data, T_BENCH_SIZE );
+	memory_init( &memory );
+	memory.data   = work;
+	memory.length = T_BENCH_SIZE;
+	memory.size   = T_BENCH_SIZE;
+
+	t_bench_options( &opt, (int)(sizeof(argv_r4)/sizeof(char*)), argv_r4 );
+	mu_bench( "memory_reorder -r 3210", "scalar", T_BENCH_SIZE, memory_reorder( &memory, &opt ) );
+	(void)options_clear( &opt );
+
+	t_bench_options( &opt, (int)(sizeof(argv_r2)/sizeof(char*)), argv_r2 );
+	mu_bench( "memory_reorder -r 10", "scalar", T_BENCH_SIZE, memory_reorder( &memory, &opt ) );
+	(void)options_clear( &opt );
+}
+
+/*!
+ * @brief file_search over data without the pattern, of a file by the backend.
+ */
+static void b_file_search(void)
+{
+	static data_t zero[T_BENCH_SIZE];
+	options_t opt;
+	memory_t memory;
+	file_t file;
+	FILE* fp;
+	data_t buf[16];
+	char* argv[] = { "bldump", "-S", "a55a", "b" };
+	bool ret;
+
+	fp = fopen( T_BENCH_IN, "wb" );
+	assert( fp != NULL );
+	(void)fwrite( zero, 1, sizeof(zero), fp );
+	fclose( fp );
+
+	t_bench_options( &opt, (int)(sizeof(argv)/sizeof(char*)), argv );
+	file_reset( &file );
+	ret = file_open( &file, T_BENCH_IN, "rb" );
+	assert( ret == true );
+	(void)ret;
+	memory_init( &memory );
+	memory.data   = buf;
+	memory.length = sizeof(buf);
+
+	mu_bench( "file_search -S a55a", "scalar", T_BENCH_SIZE,
+		( (void)file_seek( &file, 0 ), memory.size = 0, (void)file_search( &file, &memory, &opt ) ) );
+
+	(void)file_close( &file );
+	(void)options_clear( &opt );
+	(void)remove( T_BENCH_IN );
+}
+
+void ts_bench(void)
+{
+	size_t i;
+	uint32_t x = 2463534242u;
+
+	/* init */
+	for ( i = 0; i < T_BENCH_SIZE; i++ ) {
+		x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+		t_bench_data[i] = (data_t)x;
+	}
+	file_reset( &t_bench_out );
+	t_bench_out.ptr = fopen( "/dev/null", "wb" );
+	assert( t_bench_out.ptr != NULL );
+	printf( "### bench %d KiB x %d iterations\n", T_BENCH_SIZE / 1024, mu_bench_iters );
+
+	/* bench */
+	mu_run_bench(b_write_hex);
+	mu_run_bench(b_write_dec);
+	mu_run_bench(b_to_printable);
+	mu_run_bench(b_reorder);
+	mu_run_bench(b_file_search);
+
+	/* cleanup */
+	(void)fclose( t_bench_out.ptr );
+	t_bench_out.ptr = NULL;
+}
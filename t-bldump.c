@@ -6,6 +6,8 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <unistd.h>
+#include <zlib.h>
 
 #include "munit.h"
 #include "verbose.h"
@@ -15,6 +17,60 @@ FILE *t_stdin, *t_stdout, *t_stderr;
 char* t_tmpname  = "t-bldump.tmp" ;
 char* t_tmpname2 = "t-bldump2.tmp" ;
 
+/*!
+ * @brief empty t_stdout before a dump.
+ */
+void t_stdout_reset(void)
+{
+	fflush( t_stdout );
+	(void)ftruncate( fileno( t_stdout ), 0 );
+	rewind( t_stdout );
+}
+
+/*!
+ * @brief read t_stdout from the start as a string.
+ * @param[out] act
+ * @param[in] size size of act.
+ */
+void t_stdout_read( char* act, size_t size )
+{
+	size_t n;
+	fflush( t_stdout );
+	fseek( t_stdout, 0, SEEK_SET );
+	n = fread( act, 1, size - 1, t_stdout );
+	act[n] = '\0';
+}
+
+/*!
+ * @brief read a file, or a gzip file of members by gzread().
+ * @param[in] name
+ * @param[in] gzip decompresses the file.
+ * @param[in] length max bytes to read.
+ * @param[out] size bytes read.
+ * @return malloc()ed data.
+ */
+data_t* t_file_load( const char* name, bool gzip, size_t length, size_t* size )
+{
+	data_t* data = (data_t*)malloc( length );
+	assert( data != NULL );
+
+	if ( gzip == true ) {
+		gzFile gz = gzopen( name, "rb" );
+		int n;
+		assert( gz != NULL );
+		n = gzread( gz, data, (unsigned int)length );
+		assert( n >= 0 );
+		*size = (size_t)n;
+		(void)gzclose( gz );
+	} else {
+		FILE* fp = fopen( name, "rb" );
+		assert( fp != NULL );
+		*size = fread( data, 1, length, fp );
+		fclose( fp );
+	}
+	return data;
+}
+
 /*!
  * @brief test bldump::help().
  */
@@ -83,7 +139,7 @@ static void t_bldump_setup(void)
 		opt.infile_name = tmpnam(NULL); /* not exist */
 		is = bldump_setup( &memory, &infile, &outfile, &opt );
 		mu_assert_equal( is, false );
-		mu_assert_ptr_null( infile.ptr );
+		mu_assert_ptr_null( infile.handle );
 	}
 
 	/* infile=exist, outfile=NULL(stdout) */
@@ -92,7 +148,7 @@ static void t_bldump_setup(void)
 		opt.outfile_name = NULL;
 		is = bldump_setup( &memory, &infile, &outfile, &opt );
 		mu_assert_equal( is, true );
-		mu_assert_ptr_not_null( infile.ptr );
+		mu_assert_ptr_not_null( infile.handle );
 		mu_assert_equal( outfile.ptr, t_stdout  );
 		mu_assert_ptr_not_null( memory.data );
 		(void) file_close( &infile );
@@ -116,7 +172,7 @@ static void t_bldump_setup(void)
 		opt.outfile_name = t_tmpname2;
 		is = bldump_setup( &memory, &infile, &outfile, &opt );
 		mu_assert_equal( is, true );
-		mu_assert_ptr_not_null( infile.ptr );
+		mu_assert_ptr_not_null( infile.handle );
 		mu_assert_ptr_not_null( outfile.ptr );
 		(void) file_close( &infile );
 		(void) file_close( &outfile );
@@ -130,7 +186,7 @@ static void t_bldump_setup(void)
 		opt.start_address = 1;
 		is = bldump_setup( &memory, &infile, &outfile, &opt );
 		mu_assert_equal( is, true );
-		mu_assert_ptr_not_null( infile.ptr );
+		mu_assert_ptr_not_null( infile.handle );
 		mu_assert_equal( infile.position, 1 );
 		mu_assert_equal( outfile.ptr, t_stdout  );
 		mu_assert_ptr_not_null( memory.data );
@@ -147,7 +203,7 @@ static void t_bldump_setup(void)
 		opt.data_length = 0;
 		is = bldump_setup( &memory, &infile, &outfile, &opt );
 		mu_assert_equal( is, false );
-		mu_assert_ptr_not_null( infile.ptr );
+		mu_assert_ptr_not_null( infile.handle );
 		mu_assert_ptr_not_null( outfile.ptr );
 		mu_assert_ptr_null( memory.data );
 		(void) file_close( &infile );
@@ -160,7 +216,7 @@ static void t_bldump_setup(void)
 		opt.data_fields = 0;
 		is = bldump_setup( &memory, &infile, &outfile, &opt );
 		mu_assert_equal( is, false );
-		mu_assert_ptr_not_null( infile.ptr );
+		mu_assert_ptr_not_null( infile.handle );
 		mu_assert_ptr_not_null( outfile.ptr );
 		mu_assert_ptr_null( memory.data );
 		(void) file_close( &infile );
@@ -512,6 +568,229 @@ static void t_bldump_binary(void)
 	}
 }
 
+/*!
+ * @brief test of FLOAT32 format of bldump_write().
+ */
+static void t_bldump_float(void)
+{
+	int i;
+	file_t outfile;
+	memory_t memory;
+	options_t opt;
+	char data[] = {
+		0x3f, 0xc0, 0x00, 0x00, /* 1.5 */
+		0xbd, 0xcc, 0xcc, 0xcd, /* -0.1 */
+		0x7f, 0x80, 0x00, 0x00, /* inf */
+		0x01, 0x02              /* partial value */
+	};
+
+	file_reset( &outfile );
+	memory_init( &memory );
+	options_reset( &opt );
+
+	(void) memory_allocate( &memory, sizeof(data) );
+	for ( i=0; i<(int)sizeof(data); i++ ) memory.data[i] = (data_t) data[i];
+	memory.size    = sizeof(data);
+	memory.address = 0;
+
+	/* 1.5,-0.1,inf */
+	{
+		FILE* in;
+		char buf[100];
+		size_t reads;
+		opt.output_type    = FLOAT32;
+		opt.show_address   = false;
+		opt.data_length    = 4;
+		opt.col_delimitter = ",";
+		opt.row_delimitter = "\n";
+
+		(void) file_open( &outfile, t_tmpname, "wb" );
+		(void) bldump_write( &memory, &outfile, &opt );
+		(void) file_close( &outfile );
+
+		in = fopen( t_tmpname, "rb" );
+		reads = fread( buf, 1, 100, in );
+		fclose( in );
+		mu_assert_equal( reads, 13 );
+		mu_assert_nstring_equal( buf, "1.5,-0.1,inf\n", 13 );
+	}
+
+	(void) memory_free( &memory );
+	remove( t_tmpname );
+}
+
+/*!
+ * @brief test of bits_unpack().
+ */
+static void t_bits_unpack(void)
+{
+	data_t data[] = { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0, 0x11, 0x22 };
+	uint64_t values[8];
+	size_t n;
+
+	/* 12 bit, MSB first */
+	n = bits_unpack( data, sizeof(data), 12, false, 0, 8, values );
+	mu_assert_equal( n, 6 );
+	mu_assert_equal( values[0], 0x123 );
+	mu_assert_equal( values[1], 0x456 );
+	mu_assert_equal( values[4], 0xdef );
+	mu_assert_equal( values[5], 0x011 );
+
+	/* 12 bit, LSB first */
+	n = bits_unpack( data, sizeof(data), 12, true, 0, 8, values );
+	mu_assert_equal( n, 6 );
+	mu_assert_equal( values[0], 0x412 );
+	mu_assert_equal( values[1], 0x563 );
+
+	/* 24 bit from the 2nd value */
+	n = bits_unpack( data, sizeof(data), 24, false, 1, 8, values );
+	mu_assert_equal( n, 2 );
+	mu_assert_equal( values[0], 0x789abc );
+	mu_assert_equal( values[1], 0xdef011 );
+
+	/* count */
+	n = bits_unpack( data, sizeof(data), 4, false, 0, 3, values );
+	mu_assert_equal( n, 3 );
+	mu_assert_equal( values[2], 0x3 );
+}
+
+/*!
+ * @brief test of --bits format of bldump_write().
+ */
+static void t_bldump_bits(void)
+{
+	int i;
+	file_t outfile;
+	memory_t memory;
+	options_t opt;
+	char data[] = { 0x80, 0x07, 0xff, 0x00, 0x10 };
+
+	file_reset( &outfile );
+	memory_init( &memory );
+	options_reset( &opt );
+
+	(void) memory_allocate( &memory, sizeof(data) );
+	for ( i=0; i<(int)sizeof(data); i++ ) memory.data[i] = (data_t) data[i];
+	memory.size    = sizeof(data);
+	memory.address = 0;
+
+	opt.data_bits      = 12;
+	opt.show_address   = false;
+	opt.col_delimitter = ",";
+	opt.row_delimitter = "\n";
+
+	/* 800,7ff,001 */
+	{
+		FILE* in;
+		char buf[100];
+		size_t reads;
+		opt.output_type = HEXADECIMAL;
+
+		(void) file_open( &outfile, t_tmpname, "wb" );
+		(void) bldump_write( &memory, &outfile, &opt );
+		(void) file_close( &outfile );
+
+		in = fopen( t_tmpname, "rb" );
+		reads = fread( buf, 1, 100, in );
+		fclose( in );
+		mu_assert_equal( reads, 12 );
+		mu_assert_nstring_equal( buf, "800,7ff,001\n", 12 );
+	}
+
+	/* -2048,2047,1 */
+	{
+		FILE* in;
+		char buf[100];
+		size_t reads;
+		opt.output_type = DECIMAL;
+
+		(void) file_open( &outfile, t_tmpname, "wb" );
+		(void) bldump_write( &memory, &outfile, &opt );
+		(void) file_close( &outfile );
+
+		in = fopen( t_tmpname, "rb" );
+		reads = fread( buf, 1, 100, in );
+		fclose( in );
+		mu_assert_equal( reads, 13 );
+		mu_assert_nstring_equal( buf, "-2048,2047,1\n", 13 );
+	}
+
+	/* 2048,2047,1 */
+	{
+		FILE* in;
+		char buf[100];
+		size_t reads;
+		opt.output_type = UDECIMAL;
+
+		(void) file_open( &outfile, t_tmpname, "wb" );
+		(void) bldump_write( &memory, &outfile, &opt );
+		(void) file_close( &outfile );
+
+		in = fopen( t_tmpname, "rb" );
+		reads = fread( buf, 1, 100, in );
+		fclose( in );
+		mu_assert_equal( reads, 12 );
+		mu_assert_nstring_equal( buf, "2048,2047,1\n", 12 );
+	}
+
+	(void) memory_free( &memory );
+	remove( t_tmpname );
+}
+
+/*!
+ * @brief test of --layout format of bldump_write().
+ */
+static void t_bldump_layout(void)
+{
+	int i;
+	file_t outfile;
+	memory_t memory;
+	options_t opt;
+	char data[] = {
+		0x81,                   /* u8    : 129 */
+		0xfe, 0xff,             /* s16le : -2 */
+		0x00, 0x01, 0x00, 0x00, /* u32be : 65536 */
+		0x00, 0x00, 0xc0, 0x3f, /* f32le : 1.5 */
+		0xcc, 0xcc,             /* skip2 */
+		0x7f, 0xff, 0xff, 0x00  /* partial record */
+	};
+
+	file_reset( &outfile );
+	memory_init( &memory );
+	options_reset( &opt );
+
+	(void) memory_allocate( &memory, sizeof(data) );
+	for ( i=0; i<(int)sizeof(data); i++ ) memory.data[i] = (data_t) data[i];
+	memory.size    = sizeof(data);
+	memory.address = 0x10;
+
+	{
+		FILE* in;
+		char buf[100];
+		size_t reads;
+		bool is;
+		is = layout_parse( &opt, "u8,s16le,u32be,f32le,skip2" );
+		mu_assert_equal( is, true );
+		opt.show_address   = true;
+		opt.col_delimitter = ",";
+		opt.row_delimitter = "\n";
+
+		(void) file_open( &outfile, t_tmpname, "wb" );
+		(void) bldump_write( &memory, &outfile, &opt );
+		(void) file_close( &outfile );
+
+		in = fopen( t_tmpname, "rb" );
+		reads = fread( buf, 1, 100, in );
+		fclose( in );
+		mu_assert_equal( reads, 34 );
+		mu_assert_nstring_equal( buf, "00000010: 129,-2,65536,1.5,127,-1\n", 34 );
+	}
+
+	free( opt.layout );
+	(void) memory_free( &memory );
+	remove( t_tmpname );
+}
+
 /*!
  * @brief test of reordering of bldump_read().
  */
@@ -607,6 +886,10 @@ void ts_bldump(void)
 	mu_run_test(t_bldump_decimal);
 	mu_run_test(t_bldump_udecimal);
 	mu_run_test(t_bldump_binary);
+	mu_run_test(t_bldump_float);
+	mu_run_test(t_bldump_layout);
+	mu_run_test(t_bits_unpack);
+	mu_run_test(t_bldump_bits);
 
 	/* cleanup */
 	(void) fclose( t_stdin  );
@@ -0,0 +1,193 @@
+/*!
+ * @file
+ * @brief unit test of 'compare.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <zlib.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_COMPARE_A "t-compare.a"
+#define T_COMPARE_B "t-compare.b"
+#define T_COMPARE_GZ "t-compare.gz"
+
+static void t_compare_file( const char* name, const unsigned char* data, size_t size )
+{
+	FILE* fp = fopen( name, "wb" );
+	assert( fp != NULL );
+	(void)fwrite( data, 1, size, fp );
+	fclose( fp );
+}
+
+/*!
+ * @brief test "bldump -f 4 --diff a b", a is shorter than b.
+ */
+static void t_compare_rows(void)
+{
+	int ret;
+	char* argv[] = { "bldump", "-f", "4", "--diff", T_COMPARE_A, T_COMPARE_B };
+	unsigned char a[4096 + 10], b[4096 + 13];
+	char act[256];
+	size_t i;
+
+	for ( i = 0; i < sizeof(b); i++ ) {
+		b[i] = (unsigned char)i;
+	}
+	memcpy( a, b, sizeof(a) );
+	b[5]    = 0xff;
+	b[4093] = 0xee;
+	t_compare_file( T_COMPARE_A, a, sizeof(a) );
+	t_compare_file( T_COMPARE_B, b, sizeof(b) );
+
+	t_stdout_reset();
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 1 );
+
+	t_stdout_read( act, sizeof(act) );
+	mu_assert_string_equal( act,
+		"00000004: 04 05 06 07 | 04 ff 06 07\n"
+		"00000ffc: fc fd fe ff | fc ee fe ff\n"
+		"00001008: 08 09 | 08 09 0a 0b\n"
+		"0000100c:  | 0c\n" );
+}
+
+/*!
+ * @brief test "bldump -r 10 -f 2 --jobs=3 --diff a b" of 3 blocks, and -s, -e.
+ */
+static void t_compare_jobs(void)
+{
+	int ret;
+	char* argv[] = { "bldump", "-r", "10", "-f", "2", "--jobs=3", "--diff", T_COMPARE_A, T_COMPARE_B };
+	static unsigned char a[3 << 20], b[3 << 20];
+	char act[256];
+	size_t i;
+
+	for ( i = 0; i < sizeof(a); i++ ) {
+		a[i] = b[i] = (unsigned char)(i >> 8);
+	}
+	t_compare_file( T_COMPARE_A, a, sizeof(a) );
+	t_compare_file( T_COMPARE_B, b, sizeof(b) );
+
+	/* same */
+	t_stdout_reset();
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 0 );
+	t_stdout_read( act, sizeof(act) );
+	mu_assert_string_equal( act, "" );
+
+	/* differ in the 2nd and the 3rd block */
+	b[(1 << 20) + 1] = 0x12;
+	b[(3 << 20) - 4] = 0x34;
+	t_compare_file( T_COMPARE_B, b, sizeof(b) );
+	t_stdout_reset();
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 1 );
+	t_stdout_read( act, sizeof(act) );
+	mu_assert_string_equal( act,
+		"00100000: 0000 0000 | 1200 0000\n"
+		"002ffffc: ffff ffff | ff34 ffff\n" );
+
+	/* -s and -e */
+	{
+		char* argv[] = { "bldump", "-s", "0x100000", "-e", "0x100004", "--diff", T_COMPARE_A, T_COMPARE_B };
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act, "00100000: 00 00 00 00 | 00 12 00 00\n" );
+	}
+}
+
+/*!
+ * @brief test "bldump -z -f 4 --diff a.gz b", of the decompressed data.
+ */
+static void t_compare_decompress(void)
+{
+	int ret;
+	char* argv[] = { "bldump", "-z", "-f", "4", "--diff", T_COMPARE_GZ, T_COMPARE_B };
+	unsigned char a[300], b[296];
+	char act[256];
+	gzFile gz;
+	size_t i;
+
+	for ( i = 0; i < sizeof(a); i++ ) {
+		a[i] = (unsigned char)i;
+	}
+	memcpy( b, a, sizeof(b) );
+	b[200] = 0x55;
+	gz = gzopen( T_COMPARE_GZ, "wb" );
+	assert( gz != NULL );
+	(void)gzwrite( gz, a, (unsigned int)sizeof(a) );
+	(void)gzclose( gz );
+	t_compare_file( T_COMPARE_B, b, sizeof(b) );
+
+	t_stdout_reset();
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 1 );
+	t_stdout_read( act, sizeof(act) );
+	mu_assert_string_equal( act,
+		"000000c8: c8 c9 ca cb | 55 c9 ca cb\n"
+		"00000128: 28 29 2a 2b | \n" );
+}
+
+/*!
+ * @brief test the errors of --diff.
+ */
+static void t_compare_error(void)
+{
+	int ret;
+	{
+		char* argv[] = { "bldump", "-a", "--diff", T_COMPARE_A };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 2 );
+	}
+	{
+		char* argv[] = { "bldump", "-a", "--diff", T_COMPARE_A, "t-compare.none" };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 2 );
+	}
+	{
+		char* argv[] = { "bldump", "--npy", "--diff", T_COMPARE_A, T_COMPARE_B };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 2 );
+	}
+	{
+		/* "--diff" of the delimiter isn't --diff */
+		char* argv[] = { "bldump", "-d", "--diff", "--nope", T_COMPARE_A };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+}
+
+void ts_compare(void)
+{
+	/* init */
+	verbose_out = tmpfile();
+	t_stdin  = tmpfile();
+	t_stdout = tmpfile();
+	t_stderr = tmpfile();
+	assert( verbose_out != NULL && t_stdin != NULL && t_stdout != NULL && t_stderr != NULL );
+
+	/* test */
+	mu_run_test(t_compare_rows);  // bldump -f 4 --diff a b
+	mu_run_test(t_compare_jobs);  // bldump -r 10 -f 2 --jobs=3 --diff a b
+	mu_run_test(t_compare_decompress); // bldump -z -f 4 --diff a.gz b
+	mu_run_test(t_compare_error);
+
+	/* cleanup */
+	(void)remove( T_COMPARE_A );
+	(void)remove( T_COMPARE_B );
+	(void)remove( T_COMPARE_GZ );
+	(void)fclose( verbose_out );
+	(void)fclose( t_stdin );
+	(void)fclose( t_stdout );
+	(void)fclose( t_stderr );
+	verbose_out = NULL;
+	t_stdin = t_stdout = t_stderr = NULL;
+}
@@ -0,0 +1,183 @@
+/*!
+ * @file
+ * @brief unit test of 'compress.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <zlib.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_COMPRESS_IN   "t-compress.in"
+#define T_COMPRESS_OUT  "t-compress.out"
+#define T_COMPRESS_GZ   "t-compress.gz"
+#define T_COMPRESS_SIZE 1000000 /*!< infile size, the dump is over some chunks. */
+
+/*!
+ * @brief test "bldump --compress=gzip --jobs=3", members are in order.
+ */
+static void t_compress_gzip(void)
+{
+	data_t *exp, *act;
+	size_t exp_size, act_size;
+	int ret;
+
+	{
+		char* argv[] = { "bldump", "-a", T_COMPRESS_IN, T_COMPRESS_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+	}
+	{
+		char* argv[] = { "bldump", "-a", "--compress=gzip", "--jobs=3", T_COMPRESS_IN, T_COMPRESS_GZ };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+	}
+	exp = t_file_load( T_COMPRESS_OUT, false, 4 * T_COMPRESS_SIZE, &exp_size );
+	act = t_file_load( T_COMPRESS_GZ, true, 4 * T_COMPRESS_SIZE, &act_size );
+	mu_assert( exp_size > 3 * (1u << 20) );
+	mu_assert_equal( act_size, exp_size );
+	mu_assert( memcmp( act, exp, exp_size ) == 0 );
+	free( exp );
+	free( act );
+
+	/* outfile is gzip */
+	{
+		char* argv[] = { "bldump", "-f", "2", "-e", "2", T_COMPRESS_GZ };
+		char buf[32];
+		size_t n;
+		fseek( t_stdout, 0, SEEK_SET );
+		(void)main( (int)(sizeof(argv)/sizeof(char*)), argv ); /* stopped at end address */
+		fflush( t_stdout );
+		fseek( t_stdout, 0, SEEK_SET );
+		n = fread( buf, 1, sizeof(buf) - 1, t_stdout );
+		buf[n] = '\0';
+		mu_assert_nstring_equal( buf, "1f 8b\n", 6 );
+	}
+}
+
+/*!
+ * @brief test "bldump --compress=gzip,1 -b" of a short output, one member.
+ */
+static void t_compress_short(void)
+{
+	char* argv[] = { "bldump", "-b", "-e", "100", "--compress=gzip,1", "--jobs=1", T_COMPRESS_IN, T_COMPRESS_GZ };
+	data_t *exp, *act;
+	size_t exp_size, act_size;
+
+	(void)main( (int)(sizeof(argv)/sizeof(char*)), argv ); /* stopped at end address */
+	exp = t_file_load( T_COMPRESS_IN, false, 4 * T_COMPRESS_SIZE, &exp_size );
+	act = t_file_load( T_COMPRESS_GZ, true, 4 * T_COMPRESS_SIZE, &act_size );
+	mu_assert_equal( act_size, 100 );
+	mu_assert( memcmp( act, exp, 100 ) == 0 );
+	free( exp );
+	free( act );
+}
+
+/*!
+ * @brief test "bldump --compress=gzip -s <past EOF>", an empty gzip member.
+ */
+static void t_compress_empty(void)
+{
+	char* argv[] = { "bldump", "-s", "2000000", "--compress=gzip", T_COMPRESS_IN, T_COMPRESS_GZ };
+	data_t* act;
+	size_t act_size;
+	z_stream strm;
+	data_t buf[16];
+	int ret;
+
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 0 );
+	act = t_file_load( T_COMPRESS_GZ, false, 4 * T_COMPRESS_SIZE, &act_size );
+	mu_assert( act_size > 0 );
+
+	/* inflate to the end of the member */
+	memset( &strm, 0, sizeof(strm) );
+	mu_assert_equal( inflateInit2( &strm, 31 ), Z_OK );
+	strm.next_in   = act;
+	strm.avail_in  = (uInt)act_size;
+	strm.next_out  = buf;
+	strm.avail_out = (uInt)sizeof(buf);
+	mu_assert_equal( inflate( &strm, Z_FINISH ), Z_STREAM_END );
+	mu_assert_equal( strm.total_out, 0 );
+	mu_assert_equal( strm.avail_in, 0 );
+	(void)inflateEnd( &strm );
+	free( act );
+}
+
+/*!
+ * @brief test the errors of --compress.
+ */
+static void t_compress_error(void)
+{
+	int ret;
+	{
+		char* argv[] = { "bldump", "--compress=lz4", T_COMPRESS_IN, T_COMPRESS_GZ };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		const char* args[] = { "--compress=gzip,0", "--compress=gzip,12", "--compress=gzip,abc", "--compress=gzip,", "--compress=zstd,20" };
+		int i;
+		for ( i = 0; i < (int)(sizeof(args)/sizeof(args[0])); i++ ) {
+			char* argv[] = { "bldump", (char*)args[i], T_COMPRESS_IN, T_COMPRESS_GZ };
+			ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+			mu_assert_equal( ret, 1 );
+		}
+	}
+	{
+		char* argv[] = { "bldump", "--compress=gzip", "--npy", T_COMPRESS_IN, T_COMPRESS_GZ };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+#ifndef HAVE_ZSTD
+	{
+		char* argv[] = { "bldump", "--compress=zstd", T_COMPRESS_IN, T_COMPRESS_GZ };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+#endif
+}
+
+void ts_compress(void)
+{
+	unsigned int x = 1;
+	FILE* fp;
+	int i;
+
+	/* init */
+	verbose_out = tmpfile();
+	t_stdin  = tmpfile();
+	t_stdout = tmpfile();
+	t_stderr = tmpfile();
+	assert( verbose_out != NULL && t_stdin != NULL && t_stdout != NULL && t_stderr != NULL );
+
+	fp = fopen( T_COMPRESS_IN, "wb" );
+	assert( fp != NULL );
+	for ( i = 0; i < T_COMPRESS_SIZE; i++ ) {
+		x = x * 1103515245u + 12345u;
+		(void)fputc( (int)((x >> 16) & 0xff), fp );
+	}
+	fclose( fp );
+
+	/* test */
+	mu_run_test(t_compress_gzip);  // bldump --compress=gzip --jobs=3
+	mu_run_test(t_compress_short); // bldump --compress=gzip,1 -b
+	mu_run_test(t_compress_empty); // bldump --compress=gzip -s <past EOF>
+	mu_run_test(t_compress_error); // bldump --compress=lz4
+
+	/* cleanup */
+	(void)remove( T_COMPRESS_IN );
+	(void)remove( T_COMPRESS_OUT );
+	(void)remove( T_COMPRESS_GZ );
+	(void)fclose( verbose_out );
+	(void)fclose( t_stdin );
+	(void)fclose( t_stdout );
+	(void)fclose( t_stderr );
+	verbose_out = NULL;
+	t_stdin = t_stdout = t_stderr = NULL;
+}
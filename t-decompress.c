@@ -0,0 +1,217 @@
+/*!
+ * @file
+ * @brief unit test of 'decompress.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_DECOMP_GZ   "t-decompress.gz"
+#define T_DECOMP_IDX  "t-decompress.idx"
+#define T_DECOMP_SIZE 3000000 /*!< decompressed size, over the seek points. */
+
+static data_t t_decomp_data[T_DECOMP_SIZE];
+
+/*!
+ * @brief write data to T_DECOMP_GZ by gzip members of size bytes, of the level.
+ */
+static void t_decompress_write( size_t member, size_t size, int level )
+{
+	static data_t out[T_DECOMP_SIZE + 65536];
+	FILE* fp = fopen( T_DECOMP_GZ, "wb" );
+	size_t pos;
+
+	assert( fp != NULL );
+	for ( pos = 0; pos < size; pos += member ) {
+		z_stream strm;
+		memset( &strm, 0, sizeof(strm) );
+		assert( deflateInit2( &strm, level, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY ) == Z_OK );
+		strm.next_in   = &t_decomp_data[pos];
+		strm.avail_in  = (uInt)((size - pos < member) ? size - pos : member);
+		strm.next_out  = out;
+		strm.avail_out = (uInt)sizeof(out);
+		assert( deflate( &strm, Z_FINISH ) == Z_STREAM_END );
+		(void)fwrite( out, 1, sizeof(out) - strm.avail_out, fp );
+		(void)deflateEnd( &strm );
+	}
+	fclose( fp );
+}
+
+/*!
+ * @brief dump "-a -f 4 -s <start> -e <start+4>" of T_DECOMP_GZ, and compare with the data.
+ */
+static void t_decompress_dump( const char* opt, size_t start )
+{
+	char s[32], e[32], exp[64], act[256];
+	char* argv[] = { "bldump", "-a", "-f", "4", "-s", s, "-e", e, (char*)opt, T_DECOMP_GZ };
+	const data_t* d = &t_decomp_data[start];
+
+	(void)snprintf( s, sizeof(s), "%lu", (unsigned long)start );
+	(void)snprintf( e, sizeof(e), "%lu", (unsigned long)(start + 4) );
+	(void)snprintf( exp, sizeof(exp), "%08lx: %02x %02x %02x %02x\n", (unsigned long)start, d[0], d[1], d[2], d[3] );
+	t_stdout_reset();
+	(void)main( (int)(sizeof(argv)/sizeof(char*)), argv ); /* stopped at end address */
+	t_stdout_read( act, sizeof(act) );
+	mu_assert_string_equal( act, exp );
+}
+
+/*!
+ * @brief test "bldump -z -s <num>" of gzip members, back and forth.
+ */
+static void t_decompress_gzip(void)
+{
+	t_decompress_write( 1000000, T_DECOMP_SIZE, 6 );
+	t_decompress_dump( "-z", 0 );
+	t_decompress_dump( "-z", 999998 );   /* over the members */
+	t_decompress_dump( "-z", 2999996 );
+
+	/* ranges jump back to the seek points */
+	{
+		char* argv[] = { "bldump", "-f", "2", "-z", "--ranges=2500000+2,1500000+2", T_DECOMP_GZ };
+		char exp[96], act[256];
+		int ret;
+		(void)snprintf( exp, sizeof(exp), "# %08x-%08x\n%02x %02x\n# %08x-%08x\n%02x %02x\n",
+			2500000, 2500002, t_decomp_data[2500000], t_decomp_data[2500001],
+			1500000, 1500002, t_decomp_data[1500000], t_decomp_data[1500001] );
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act, exp );
+	}
+
+	/* not compressed without -z */
+	{
+		char act[32];
+		char* argv[] = { "bldump", "-f", "2", "-e", "2", T_DECOMP_GZ };
+		t_stdout_reset();
+		(void)main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act, "1f 8b\n" );
+	}
+}
+
+/*!
+ * @brief test "bldump --index=<file> -s <num>", the index is built and used.
+ */
+static void t_decompress_index(void)
+{
+	FILE* fp;
+
+	t_decompress_write( T_DECOMP_SIZE, T_DECOMP_SIZE, 6 );
+	(void)remove( T_DECOMP_IDX );
+	t_decompress_dump( "--index=" T_DECOMP_IDX, 2999996 );
+	fp = fopen( T_DECOMP_IDX, "rb" );
+	mu_assert( fp != NULL );
+	if ( fp != NULL ) {
+		unsigned char head[40];
+		size_t n = fread( head, 1, sizeof(head), fp );
+		fclose( fp );
+		/* magic, compressed size, stamp and the span of 1M in little endian */
+		mu_assert_equal( n, sizeof(head) );
+		mu_assert( memcmp( head, "BLDZIDX2", 8 ) == 0 );
+		mu_assert( memcmp( &head[32], "\x00\x00\x10\x00\x00\x00\x00\x00", 8 ) == 0 );
+	}
+	t_decompress_dump( "--index=" T_DECOMP_IDX, 2200000 );
+	t_decompress_dump( "--index=" T_DECOMP_IDX, 10 );
+
+	/* an index of another file is rebuilt */
+	t_decompress_write( 500000, T_DECOMP_SIZE, 6 );
+	t_decompress_dump( "--index=" T_DECOMP_IDX, 2200000 );
+	t_decompress_dump( "--index=" T_DECOMP_IDX, 1000000 );
+
+	/* of another content of the same size, by the stamp of the content */
+	t_decompress_write( T_DECOMP_SIZE, T_DECOMP_SIZE, 0 );
+	t_decompress_dump( "--index=" T_DECOMP_IDX, 2200000 );
+	t_decomp_data[T_DECOMP_SIZE - 1] ^= 0xff;
+	t_decompress_write( T_DECOMP_SIZE, T_DECOMP_SIZE, 0 );
+	fflush( verbose_out );
+	(void)ftruncate( fileno( verbose_out ), 0 );
+	rewind( verbose_out );
+	t_decompress_dump( "--index=" T_DECOMP_IDX, 2200000 );
+	{
+		char msg[256];
+		size_t n;
+		fflush( verbose_out );
+		rewind( verbose_out );
+		n = fread( msg, 1, sizeof(msg) - 1, verbose_out );
+		msg[n] = '\0';
+		mu_assert( strstr( msg, "index isn't of infile" ) != NULL );
+	}
+	t_decomp_data[T_DECOMP_SIZE - 1] ^= 0xff;
+	(void)remove( T_DECOMP_IDX );
+}
+
+/*!
+ * @brief test "bldump -z" of truncated and corrupt data, and the errors.
+ */
+static void t_decompress_error(void)
+{
+	char* argv[] = { "bldump", "-z", T_DECOMP_GZ };
+	int ret;
+
+	/* truncated, dumps to the end of it */
+	t_decompress_write( T_DECOMP_SIZE, 1000, 6 );
+	(void)truncate( T_DECOMP_GZ, 100 );
+	t_stdout_reset();
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 0 );
+
+	/* corrupt */
+	{
+		FILE* fp = fopen( T_DECOMP_GZ, "wb" );
+		assert( fp != NULL );
+		(void)fwrite( "\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\x03\xff\xff\xff\xff", 1, 14, fp );
+		fclose( fp );
+	}
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 1 );
+	{
+		char* argv2[] = { "bldump", "-z", "--reverse", T_DECOMP_GZ };
+		ret = main( (int)(sizeof(argv2)/sizeof(char*)), argv2 );
+		mu_assert_equal( ret, 1 );
+	}
+}
+
+void ts_decompress(void)
+{
+	unsigned int x = 1;
+	size_t i;
+
+	/* init */
+	verbose_out = tmpfile();
+	t_stdin  = tmpfile();
+	t_stdout = tmpfile();
+	t_stderr = tmpfile();
+	assert( verbose_out != NULL && t_stdin != NULL && t_stdout != NULL && t_stderr != NULL );
+
+	/* compressible data of short runs */
+	for ( i = 0; i < T_DECOMP_SIZE; i++ ) {
+		if ( i % 4 == 0 ) {
+			x = x * 1103515245u + 12345u;
+		}
+		t_decomp_data[i] = (data_t)((x >> 16) & 0x3f);
+	}
+
+	/* test */
+	mu_run_test(t_decompress_gzip);  // bldump -z -s <num>
+	mu_run_test(t_decompress_index); // bldump --index=<file> -s <num>
+	mu_run_test(t_decompress_error); // bldump -z of truncated data
+
+	/* cleanup */
+	(void)remove( T_DECOMP_GZ );
+	(void)fclose( verbose_out );
+	(void)fclose( t_stdin );
+	(void)fclose( t_stdout );
+	(void)fclose( t_stderr );
+	verbose_out = NULL;
+	t_stdin = t_stdout = t_stderr = NULL;
+}
@@ -0,0 +1,379 @@
+/*!
+ * @file
+ * @brief differential test of the engines.
+ *
+ * Random inputs are dumped with random options by the reference engine,
+ * main() which reads by stdio and writes by the fprintf based writers,
+ * and by each engine of t_engines[], and the outputs are compared byte
+ * for byte. An engine which doesn't support the options is skipped.
+ *
+ * 'bldump-test --test' runs T_DIFF_CASES cases, and
+ * 'bldump-test --diff [<cases>] [<seed>]' runs more.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_DIFF_CASES 300            /*!< cases of --test. */
+#define T_DIFF_SIZE  700            /*!< max input size. */
+#define T_DIFF_ARGS  24             /*!< max arguments. */
+#define T_DIFF_IN    "t-diff.in"    /*!< infile. */
+#define T_DIFF_REF   "t-diff.ref"   /*!< outfile of the reference. */
+#define T_DIFF_OUT   "t-diff.out"   /*!< outfile of an engine. */
+#define T_DIFF_LIST  "t-diff.lst"   /*!< --batch list. */
+
+/*** t_buf_t ***/
+typedef struct {
+	char*  data; /*!< bytes. */
+	size_t size; /*!< valid size. */
+	size_t length; /*!< allocated size. */
+} t_buf_t;
+
+/*** t_engine_t ***/
+typedef struct {
+	const char* name;
+	/*! dump in by the options, returns false if the options aren't supported. */
+	bool (*run)( int argc, char* argv[], const data_t* in, size_t size, t_buf_t* out );
+} t_engine_t;
+
+static uint64_t t_diff_state; /*!< xorshift64 state. */
+
+static uint64_t t_diff_rand(void)
+{
+	t_diff_state ^= t_diff_state << 13;
+	t_diff_state ^= t_diff_state >> 7;
+	t_diff_state ^= t_diff_state << 17;
+	return t_diff_state;
+}
+
+static size_t t_diff_range( size_t n )
+{
+	return (size_t)(t_diff_rand() % n);
+}
+
+static void t_buf_append( t_buf_t* buf, const char* data, size_t size )
+{
+	if ( buf->size + size > buf->length ) {
+		buf->length = (buf->size + size) * 2;
+		buf->data   = (char*)realloc( buf->data, buf->length );
+		assert( buf->data != NULL );
+	}
+	memcpy( &buf->data[buf->size], data, size );
+	buf->size += size;
+}
+
+static void t_buf_load( t_buf_t* buf, const char* name )
+{
+	char block[4096];
+	size_t n;
+	FILE* fp = fopen( name, "rb" );
+
+	buf->size = 0;
+	if ( fp == NULL ) {
+		return;
+	}
+	while ( (n = fread( block, 1, sizeof(block), fp )) > 0 ) {
+		t_buf_append( buf, block, n );
+	}
+	fclose( fp );
+}
+
+/*!
+ * @brief load options of argv with the infile.
+ */
+static bool t_diff_options( options_t* opt, int argc, char* argv[] )
+{
+	char* args[T_DIFF_ARGS + 2];
+	memcpy( args, argv, sizeof(char*) * (size_t)argc );
+	args[argc] = T_DIFF_IN;
+	options_reset( opt );
+	if ( options_load( opt, argc + 1, args ) == false ) {
+		(void)options_clear( opt );
+		return false;
+	}
+	return true;
+}
+
+/*** engines ***/
+
+static size_t t_diff_sink( void* user, const char* buf, size_t size )
+{
+	t_buf_append( (t_buf_t*)user, buf, size );
+	return size;
+}
+
+/*!
+ * @brief stream API, the input is pushed at once or by random chunks.
+ */
+static bool t_diff_stream( int argc, char* argv[], const data_t* in, size_t size, t_buf_t* out, bool chunked )
+{
+	options_t opt;
+	bldump_t* ctx;
+	size_t pos = 0;
+
+	if ( t_diff_options( &opt, argc, argv ) == false ) {
+		return false;
+	}
+	ctx = bldump_open( &opt, t_diff_sink, out );
+	if ( ctx == NULL ) {
+		(void)options_clear( &opt );
+		return false;
+	}
+	while ( pos < size ) {
+		size_t n = chunked ? t_diff_range( 97 ) + 1 : size;
+		if ( n > size - pos ) n = size - pos;
+		(void)bldump_push( ctx, &in[pos], n );
+		pos += n;
+	}
+	(void)bldump_close( ctx );
+	(void)options_clear( &opt );
+	return true;
+}
+
+static bool t_diff_stream_once( int argc, char* argv[], const data_t* in, size_t size, t_buf_t* out )
+{
+	return t_diff_stream( argc, argv, in, size, out, false );
+}
+
+static bool t_diff_stream_chunked( int argc, char* argv[], const data_t* in, size_t size, t_buf_t* out )
+{
+	return t_diff_stream( argc, argv, in, size, out, true );
+}
+
+/*!
+ * @brief --batch, a worker dumps the list of the infile.
+ */
+static bool t_diff_batch( int argc, char* argv[], const data_t* in, size_t size, t_buf_t* out )
+{
+	options_t opt;
+	char* args[T_DIFF_ARGS + 2];
+	FILE* fp;
+
+	(void)in;
+	(void)size;
+	fp = fopen( T_DIFF_LIST, "wt" );
+	assert( fp != NULL );
+	fprintf( fp, "%s %s\n", T_DIFF_IN, T_DIFF_OUT );
+	fclose( fp );
+
+	memcpy( args, argv, sizeof(char*) * (size_t)argc );
+	args[argc] = "--batch=" T_DIFF_LIST;
+	options_reset( &opt );
+	if ( options_load( &opt, argc + 1, args ) == false ) {
+		(void)options_clear( &opt );
+		return false;
+	}
+	(void)remove( T_DIFF_OUT );
+	fseek( t_stdout, 0, SEEK_SET );
+	(void)bldump_batch( &opt );
+	(void)options_clear( &opt );
+	t_buf_load( out, T_DIFF_OUT );
+	return true;
+}
+
+static const t_engine_t t_engines[] = {
+	{ "stream",         t_diff_stream_once },
+	{ "stream-chunked", t_diff_stream_chunked },
+	{ "batch",          t_diff_batch },
+};
+
+/*!
+ * @brief make random arguments.
+ * @param[out] argv
+ * @param[out] strs storage of the argument strings.
+ * @param[in] in input data, to pick a -S pattern from.
+ * @param[in] size
+ * @return argc
+ */
+static int t_diff_args( char* argv[], char strs[][16], const data_t* in, size_t size )
+{
+	static char* delims[] = { " ", ",", "", "\t", "::" };
+	static char* orders[] = { "10", "3210", "1032", "0123", "76543210", "01234567", "2301" };
+	static char* types[]  = { NULL, "-i", "-u", "-A" };
+	int argc = 0, n = 0;
+	char* type;
+
+	argv[argc++] = "bldump";
+
+	/* -l or -r */
+	if ( t_diff_range( 4 ) == 0 ) {
+		argv[argc++] = "-r";
+		argv[argc++] = orders[t_diff_range( sizeof(orders)/sizeof(char*) )];
+	} else {
+		(void)sprintf( strs[n], "%u", 1u << t_diff_range( 4 ) );
+		argv[argc++] = "-l";
+		argv[argc++] = strs[n++];
+	}
+
+	/* -f */
+	(void)sprintf( strs[n], "%u", (unsigned int)t_diff_range( 8 ) + 1 );
+	argv[argc++] = "-f";
+	argv[argc++] = strs[n++];
+
+	/* output */
+	type = types[t_diff_range( sizeof(types)/sizeof(char*) )];
+	if ( type != NULL ) {
+		argv[argc++] = type;
+	}
+	if ( t_diff_range( 2 ) == 0 ) {
+		argv[argc++] = "-a";
+	}
+	if ( t_diff_range( 2 ) == 0 ) {
+		argv[argc++] = "-d";
+		argv[argc++] = delims[t_diff_range( sizeof(delims)/sizeof(char*) )];
+	}
+
+	/* input */
+	if ( t_diff_range( 3 ) == 0 && size > 0 ) {
+		(void)sprintf( strs[n], "%u", (unsigned int)t_diff_range( size ) );
+		argv[argc++] = "-s";
+		argv[argc++] = strs[n++];
+	}
+	if ( t_diff_range( 3 ) == 0 && size > 0 ) {
+		(void)sprintf( strs[n], "%u", (unsigned int)t_diff_range( size ) + 1 );
+		argv[argc++] = "-e";
+		argv[argc++] = strs[n++];
+	}
+	if ( t_diff_range( 5 ) == 0 && size > 2 ) {
+		size_t pos = t_diff_range( size - 1 );
+		if ( t_diff_range( 2 ) == 0 ) {
+			(void)sprintf( strs[n], "%02x", in[pos] );
+		} else {
+			(void)sprintf( strs[n], "%02x%02x", in[pos], in[pos + 1] );
+		}
+		argv[argc++] = "-S";
+		argv[argc++] = strs[n++];
+	}
+	assert( argc <= T_DIFF_ARGS );
+	return argc;
+}
+
+/*!
+ * @brief run cases.
+ * @param[in] cases number of cases.
+ * @param[in] seed random seed.
+ * @return number of mismatches.
+ */
+static int t_diff_run( int cases, uint64_t seed )
+{
+	static data_t in[T_DIFF_SIZE];
+	t_buf_t ref, out;
+	char* argv[T_DIFF_ARGS + 2];
+	char strs[8][16];
+	int c, argc, fail = 0, compared = 0;
+	size_t size, i, e;
+
+	memset( &ref, 0, sizeof(ref) );
+	memset( &out, 0, sizeof(out) );
+	t_diff_state = (seed != 0) ? seed : 1;
+
+	for ( c = 0; c < cases; c++ ) {
+		/* input, random or of a few values to hit -S */
+		uint64_t alphabet = t_diff_range( 2 ) ? 256 : 4;
+		FILE* fp;
+
+		size = t_diff_range( T_DIFF_SIZE );
+		for ( i = 0; i < size; i++ ) {
+			in[i] = (data_t)t_diff_range( alphabet );
+		}
+		fp = fopen( T_DIFF_IN, "wb" );
+		assert( fp != NULL );
+		(void)fwrite( in, 1, size, fp );
+		fclose( fp );
+
+		argc = t_diff_args( argv, strs, in, size );
+
+		/* reference */
+		argv[argc]     = T_DIFF_IN;
+		argv[argc + 1] = T_DIFF_REF;
+		(void)remove( T_DIFF_REF );
+		(void)main( argc + 2, argv );
+		t_buf_load( &ref, T_DIFF_REF );
+
+		for ( e = 0; e < sizeof(t_engines)/sizeof(t_engine_t); e++ ) {
+			out.size = 0;
+			if ( t_engines[e].run( argc, argv, in, size, &out ) == false ) {
+				continue;
+			}
+			compared++;
+			if ( out.size != ref.size || memcmp( out.data, ref.data, ref.size ) != 0 ) {
+				int a;
+				for ( i = 0; i < out.size && i < ref.size && out.data[i] == ref.data[i]; i++ );
+				printf( "diff: %s differs at %lu (size %lu, ref %lu), input %lu bytes, case %d seed 0x%llx:",
+					t_engines[e].name, (unsigned long)i, (unsigned long)out.size, (unsigned long)ref.size,
+					(unsigned long)size, c, (unsigned long long)seed );
+				for ( a = 0; a < argc; a++ ) printf( " '%s'", argv[a] );
+				printf( "\n" );
+				fail++;
+			}
+		}
+	}
+	printf( "### diff %d cases, %d compared, %d differ\n", cases, compared, fail );
+
+	free( ref.data );
+	free( out.data );
+	(void)remove( T_DIFF_IN );
+	(void)remove( T_DIFF_REF );
+	(void)remove( T_DIFF_OUT );
+	(void)remove( T_DIFF_LIST );
+	return fail;
+}
+
+/*!
+ * @brief test of random cases.
+ */
+static void t_diff_random(void)
+{
+	mu_assert_equal( t_diff_run( T_DIFF_CASES, 0x2545f4914f6cdd1duLL ), 0 );
+}
+
+static void t_diff_init(void)
+{
+	verbose_out = tmpfile();
+	t_stdin  = tmpfile();
+	t_stdout = tmpfile();
+	t_stderr = tmpfile();
+	assert( verbose_out != NULL && t_stdin != NULL && t_stdout != NULL && t_stderr != NULL );
+}
+
+static void t_diff_cleanup(void)
+{
+	(void)fclose( verbose_out );
+	(void)fclose( t_stdin );
+	(void)fclose( t_stdout );
+	(void)fclose( t_stderr );
+	verbose_out = NULL;
+	t_stdin = t_stdout = t_stderr = NULL;
+}
+
+/*!
+ * @brief 'bldump-test --diff [<cases>] [<seed>]'
+ * @return number of mismatches.
+ */
+int t_diff_main( int cases, uint64_t seed )
+{
+	int fail;
+	t_diff_init();
+	fail = t_diff_run( cases, seed );
+	t_diff_cleanup();
+	return fail;
+}
+
+void ts_diff(void)
+{
+	/* init */
+	t_diff_init();
+
+	/* test */
+	mu_run_test(t_diff_random); // reference vs engines
+
+	/* cleanup */
+	t_diff_cleanup();
+}
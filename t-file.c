@@ -6,6 +6,8 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "munit.h"
 #include "verbose.h"
@@ -57,15 +59,15 @@ static void t_file_open(void)
 		is = file_open( &file, t_tmpname, "rt" );
 		mu_assert_equal( is, true );
 		mu_assert_string_equal( file.name, t_tmpname );
-		mu_assert_ptr_not_null( file.ptr );
+		mu_assert_ptr_not_null( file.ops );
+		mu_assert_ptr_null( file.ptr );
 		mu_assert_equal( file.position, 0L );
 		mu_assert_equal( file.length,   5 );
 
-		fclose( file.ptr );
-		file.ptr = NULL;
+		(void)file_close( &file );
 	}
 
-	assert( file.ptr == NULL );
+	assert( file.handle == NULL );
 }
 
 /*!
@@ -83,7 +85,7 @@ static void t_file_close(void)
 	{
 		is = file_close( &file );
 		mu_assert_equal( is, true );
-		mu_assert_ptr_null( file.ptr );
+		mu_assert_ptr_null( file.handle );
 	}
 	/* file_close() - failure */
 	{
@@ -118,6 +120,74 @@ static void t_file_seek(void)
 	file_close( &file );
 }
 
+/*!
+ * @brief test of file_fetch and file_seek of a pipe, the fd backend.
+ */
+static void t_file_pipe(void)
+{
+	char name[32], buf[8];
+	int fds[2];
+	size_t val;
+	file_t file;
+
+	assert( pipe( fds ) == 0 );
+	assert( write( fds[1], "hello", 5 ) == 5 );
+	(void)close( fds[1] );
+	(void)snprintf( name, sizeof(name), "/dev/fd/%d", fds[0] );
+
+	file_reset( &file );
+	mu_assert_equal( file_open( &file, name, "rb" ), true );
+	mu_assert_string_equal( file.ops->name, "fd" );
+	mu_assert_equal( file.length, 0 );
+
+	val = file_fetch( &file, buf, 2 );
+	mu_assert_equal( val, 2 );
+	mu_assert_nstring_equal( buf, "he", 2 );
+
+	/* seek back in the buffer */
+	mu_assert_equal( file_seek( &file, 1 ), 0 );
+	val = file_fetch( &file, buf, sizeof(buf) );
+	mu_assert_equal( val, 4 );
+	mu_assert_nstring_equal( buf, "ello", 4 );
+	mu_assert_equal( file.eof, true );
+
+	file_close( &file );
+	(void)close( fds[0] );
+}
+
+/*!
+ * @brief test that a file truncated while reading ends at its new size.
+ */
+static void t_file_truncate(void)
+{
+	const char* name = "t-file-truncate.tmp";
+	static char data[256 * 1024];
+	char buf[8];
+	size_t val;
+	file_t file;
+	FILE* fp;
+
+	fp = fopen( name, "wb" );
+	assert( fp != NULL );
+	(void)fwrite( data, 1, sizeof(data), fp );
+	fclose( fp );
+
+	file_reset( &file );
+	mu_assert_equal( file_open( &file, name, "rb" ), true );
+	val = file_fetch( &file, buf, sizeof(buf) );
+	mu_assert_equal( val, sizeof(buf) );
+
+	/* not SIGBUS of a mapping */
+	assert( truncate( name, 4096 ) == 0 );
+	mu_assert_equal( file_seek( &file, sizeof(data) / 2 ), 0 );
+	val = file_fetch( &file, buf, sizeof(buf) );
+	mu_assert_equal( val, 0 );
+	mu_assert_equal( file.eof, true );
+
+	file_close( &file );
+	(void)remove( name );
+}
+
 /*!
  * @brief test of file_read.
  */
@@ -274,6 +344,24 @@ static void t_file_search(void)
 		mu_assert_equal( is, false );
 	}
 
+	/* pattern longer than a record */
+	{
+		file_close( &file );
+		file_open( &file, t_tmpname, "rt" ); /* hello */
+		memory_free( &memory );
+		memory_allocate( &memory, 1 );
+		memory_clear( &memory );
+
+		opt.search_pattern = 0x6c6c;
+		opt.search_length  = 16;
+		opt.end_address    = 0;
+		is = file_search( &file, &memory, &opt );
+		mu_assert_equal( is,             true );
+		mu_assert_equal( memory.address, 2 );
+		mu_assert_equal( memory.size,    1 );
+		mu_assert_equal( memory.data[0], 0x6c );
+	}
+
 	file_close( &file );
 	memory_free( &memory );
 }
@@ -303,6 +391,8 @@ void ts_file(void)
 	mu_run_test(t_file_open);
 	mu_run_test(t_file_close);
 	mu_run_test(t_file_seek);
+	mu_run_test(t_file_pipe);
+	mu_run_test(t_file_truncate);
 	mu_run_test(t_file_read);
 	mu_run_test(t_file_search);
 	mu_run_test(t_file_write); // this test overwrite t_tmpname file.
@@ -0,0 +1,166 @@
+/*!
+ * @file
+ * @brief unit test of 'follow.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_FOLLOW_IN  "t-follow.in"
+#define T_FOLLOW_OUT "t-follow.out"
+
+/*** t_follow_t ***/
+typedef struct {
+	int    argc;
+	char** argv;
+	int    ret;  /*!< return of main. */
+} t_follow_t;
+
+static void* t_follow_main( void* arg )
+{
+	t_follow_t* t = (t_follow_t*)arg;
+	t->ret = main( t->argc, t->argv );
+	return NULL;
+}
+
+static void t_follow_append( const void* data, size_t size )
+{
+	FILE* fp = fopen( T_FOLLOW_IN, "ab" );
+	assert( fp != NULL );
+	(void)fwrite( data, 1, size, fp );
+	fclose( fp );
+}
+
+/*!
+ * @brief wait until the outfile is the expected text, for 5 sec at most.
+ */
+static void t_follow_wait( const char* exp )
+{
+	char act[256];
+	int i;
+
+	for ( i = 0; i < 500; i++ ) {
+		size_t n = 0;
+		FILE* fp = fopen( T_FOLLOW_OUT, "rb" );
+		if ( fp != NULL ) {
+			n = fread( act, 1, sizeof(act) - 1, fp );
+			fclose( fp );
+		}
+		act[n] = '\0';
+		if ( strcmp( act, exp ) == 0 ) {
+			break;
+		}
+		(void)usleep( 10000 );
+	}
+	mu_assert_string_equal( act, exp );
+}
+
+/*!
+ * @brief test "bldump --follow -f 4", a partial row is held until completed.
+ */
+static void t_follow_append_rows(void)
+{
+	char* argv[] = { "bldump", "--follow", "-f", "4", T_FOLLOW_IN, T_FOLLOW_OUT };
+	t_follow_t t = { (int)(sizeof(argv)/sizeof(char*)), argv, -1 };
+	pthread_t th;
+
+	(void)remove( T_FOLLOW_IN );
+	(void)remove( T_FOLLOW_OUT );
+	t_follow_append( "012345", 6 );
+	assert( pthread_create( &th, NULL, t_follow_main, &t ) == 0 );
+	t_follow_wait( "30 31 32 33\n" );
+
+	t_follow_append( "67", 2 );
+	t_follow_wait( "30 31 32 33\n34 35 36 37\n" );
+
+	/* the last partial row is written when the infile is deleted */
+	t_follow_append( "8", 1 );
+	(void)remove( T_FOLLOW_IN );
+	(void)pthread_join( th, NULL );
+	mu_assert_equal( t.ret, 0 );
+	t_follow_wait( "30 31 32 33\n34 35 36 37\n38\n" );
+}
+
+/*!
+ * @brief test "bldump --follow -f 3 -S aa55 -a", the pattern is split by the appends.
+ */
+static void t_follow_search(void)
+{
+	char* argv[] = { "bldump", "--follow", "-f", "3", "-S", "aa55", "-a", T_FOLLOW_IN, T_FOLLOW_OUT };
+	t_follow_t t = { (int)(sizeof(argv)/sizeof(char*)), argv, -1 };
+	pthread_t th;
+
+	(void)remove( T_FOLLOW_IN );
+	(void)remove( T_FOLLOW_OUT );
+	t_follow_append( "\x00\xaa", 2 );
+	assert( pthread_create( &th, NULL, t_follow_main, &t ) == 0 );
+	(void)usleep( 20000 );
+	t_follow_append( "\x55\x01\x02", 3 );
+	t_follow_wait( "00000001: aa 55 01\n" );
+
+	(void)remove( T_FOLLOW_IN );
+	(void)pthread_join( th, NULL );
+	mu_assert_equal( t.ret, 0 );
+	t_follow_wait( "00000001: aa 55 01\n" );
+}
+
+/*!
+ * @brief test "bldump --follow -e 4" and the errors.
+ */
+static void t_follow_error(void)
+{
+	int ret;
+
+	/* -e ends without waiting */
+	{
+		char* argv[] = { "bldump", "--follow", "-e", "4", T_FOLLOW_IN, T_FOLLOW_OUT };
+		(void)remove( T_FOLLOW_IN );
+		t_follow_append( "01234567", 8 );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_follow_wait( "30 31 32 33\n" );
+	}
+	{
+		char* argv[] = { "bldump", "--follow", "--watch", T_FOLLOW_IN };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--follow", "t-follow.none" };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+}
+
+void ts_follow(void)
+{
+	/* init */
+	verbose_out = tmpfile();
+	t_stdin  = tmpfile();
+	t_stdout = tmpfile();
+	t_stderr = tmpfile();
+	assert( verbose_out != NULL && t_stdin != NULL && t_stdout != NULL && t_stderr != NULL );
+
+	/* test */
+	mu_run_test(t_follow_append_rows); // bldump --follow -f 4
+	mu_run_test(t_follow_search);      // bldump --follow -f 3 -S aa55 -a
+	mu_run_test(t_follow_error);       // bldump --follow -e 4
+
+	/* cleanup */
+	(void)remove( T_FOLLOW_IN );
+	(void)remove( T_FOLLOW_OUT );
+	(void)fclose( verbose_out );
+	(void)fclose( t_stdin );
+	(void)fclose( t_stdout );
+	(void)fclose( t_stderr );
+	verbose_out = NULL;
+	t_stdin = t_stdout = t_stderr = NULL;
+}
@@ -0,0 +1,119 @@
+/*!
+ * @file
+ * @brief unit test of 'fpconv.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "munit.h"
+#include "fpconv.h"
+
+/*!
+ * @brief format binary64 and compare with 'exp'.
+ */
+static int t_double( double value, const char* exp )
+{
+	char buf[FPCONV_BUFSIZE];
+	uint64_t bits;
+	memcpy( &bits, &value, sizeof(bits) );
+	(void)fpconv_format( buf, bits, sizeof(bits) );
+	return strcmp( buf, exp ) == 0;
+}
+
+/*!
+ * @brief test of binary64.
+ */
+static void t_fpconv_double(void)
+{
+	mu_assert( t_double( 0.0, "0" ) );
+	mu_assert( t_double( -0.0, "-0" ) );
+	mu_assert( t_double( 1.0, "1" ) );
+	mu_assert( t_double( 0.1, "0.1" ) );
+	mu_assert( t_double( -2.5, "-2.5" ) );
+	mu_assert( t_double( 3.14159, "3.14159" ) );
+	mu_assert( t_double( 1e15, "1000000000000000" ) );
+	mu_assert( t_double( 1e16, "1e+16" ) );
+	mu_assert( t_double( 0.0001, "0.0001" ) );
+	mu_assert( t_double( 0.00001, "1e-05" ) );
+	mu_assert( t_double( 123456789012345678.0, "1.2345678901234568e+17" ) );
+	mu_assert( t_double( 1.7976931348623157e308, "1.7976931348623157e+308" ) );
+	mu_assert( t_double( 5e-324, "5e-324" ) );
+}
+
+/*!
+ * @brief test of binary16 and binary32.
+ */
+static void t_fpconv_short(void)
+{
+	char buf[FPCONV_BUFSIZE];
+	int len;
+
+	/* binary32 */
+	len = fpconv_format( buf, 0x3dcccccduLL, 4 ); /* 0.1f */
+	mu_assert_equal( len, 3 );
+	mu_assert_string_equal( buf, "0.1" );
+	(void)fpconv_format( buf, 0xc0490fdbuLL, 4 ); /* -pi */
+	mu_assert_string_equal( buf, "-3.1415927" );
+
+	/* binary16 */
+	(void)fpconv_format( buf, 0x3e00uLL, 2 );
+	mu_assert_string_equal( buf, "1.5" );
+	(void)fpconv_format( buf, 0x3555uLL, 2 );
+	mu_assert_string_equal( buf, "0.3333" );
+	(void)fpconv_format( buf, 0x7bffuLL, 2 ); /* max */
+	mu_assert_string_equal( buf, "65500" );
+
+	/* special */
+	(void)fpconv_format( buf, 0x7c00uLL, 2 );
+	mu_assert_string_equal( buf, "inf" );
+	(void)fpconv_format( buf, 0xff800000uLL, 4 );
+	mu_assert_string_equal( buf, "-inf" );
+	(void)fpconv_format( buf, 0x7ff8000000000000uLL, 8 );
+	mu_assert_string_equal( buf, "nan" );
+
+	/* unsupported size */
+	len = fpconv_format( buf, 0, 3 );
+	mu_assert_equal( len, 0 );
+}
+
+/*!
+ * @brief test of round trip with pseudo random values.
+ */
+static void t_fpconv_roundtrip(void)
+{
+	int i, fail = 0;
+	uint64_t x = 88172645463325252uLL;
+	char buf[FPCONV_BUFSIZE];
+
+	for ( i = 0; i < 100000; i++ ) {
+		double d, r;
+		float f, q;
+		uint32_t b;
+
+		x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		memcpy( &d, &x, sizeof(d) );
+		if ( d == d && d - d == 0.0 ) { /* finite */
+			(void)fpconv_format( buf, x, 8 );
+			r = strtod( buf, NULL );
+			if ( memcmp( &r, &d, sizeof(d) ) != 0 ) fail++;
+		}
+		b = (uint32_t)x;
+		memcpy( &f, &b, sizeof(f) );
+		if ( f == f && f - f == 0.0f ) {
+			(void)fpconv_format( buf, b, 4 );
+			q = strtof( buf, NULL );
+			if ( memcmp( &q, &f, sizeof(f) ) != 0 ) fail++;
+		}
+	}
+	mu_assert_equal( fail, 0 );
+}
+
+void ts_fpconv(void)
+{
+	/* test */
+	mu_run_test(t_fpconv_double);
+	mu_run_test(t_fpconv_short);
+	mu_run_test(t_fpconv_roundtrip);
+}
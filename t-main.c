@@ -5,7 +5,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <assert.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include "munit.h"
 #include "verbose.h"
@@ -203,6 +206,359 @@ static void t_main_ascii(void)
 	remove( t_tmpname );
 }
 
+/*!
+ * @brief test "bldump --npy -i -l 2 -f 2"
+ */
+static void t_main_npy(void)
+{
+	int ret;
+	char* argv[] = { "bldump", "--npy", "-i", "-l", "2", "-f", "2", t_tmpname, "t-bldump.npy" };
+	char exp[] = { 0x00, 0x01, 0xff, 0xfe, 0x00, 0x03 };
+	char act[256];
+	size_t reads;
+
+	/* make input data */
+	{
+		FILE* fp = fopen( t_tmpname, "wb" );
+		assert( fp != NULL );
+		(void)fwrite( exp, 1, sizeof(exp), fp );
+		fclose( fp );
+	}
+
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv ); 
+	mu_assert_equal( ret, 0 );
+
+	{
+		FILE* fp = fopen( "t-bldump.npy", "rb" );
+		assert( fp != NULL );
+		reads = fread( act, 1, sizeof(act), fp );
+		fclose( fp );
+	}
+	mu_assert_equal( reads, 128 + 8 );
+	mu_assert_nstring_equal( act, "\x93NUMPY\x01\x00\x76\x00{'descr': '>i2', 'fortran_order': False, 'shape': (", 64 );
+	mu_assert( strstr( &act[10], "   2, 2), }" ) != NULL );
+	mu_assert_equal( act[127], '\n' );
+	mu_assert_equal( act[128+5], 0x03 );
+	mu_assert_equal( act[128+7], 0x00 ); /* filled with zero */
+
+	/* --npy needs outfile */
+	{
+		char* argv[] = { "bldump", "--npy", t_tmpname };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( ret, 1 );
+	}
+
+	remove( "t-bldump.npy" );
+	remove( t_tmpname );
+}
+
+/*!
+ * @brief test "bldump --columns -f 3"
+ */
+static void t_main_columns(void)
+{
+	int ret;
+	char exp[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09 };
+	char act[80];
+	size_t reads;
+
+	/* make input data */
+	{
+		FILE* fp = fopen( t_tmpname, "wb" );
+		assert( fp != NULL );
+		(void)fwrite( exp, 1, sizeof(exp), fp );
+		fclose( fp );
+	}
+
+	/* text */
+	{
+		char* argv[] = { "bldump", "--columns", "-f", "3", t_tmpname, "t-bldump.out" };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( ret, 0 );
+		{
+			FILE* fp = fopen( "t-bldump.out.col0", "rb" );
+			assert( fp != NULL );
+			reads = fread( act, 1, sizeof(act), fp );
+			fclose( fp );
+		}
+		mu_assert_equal( reads, 12 );
+		mu_assert_nstring_equal( act, "00\n03\n06\n09\n", 12 );
+		{
+			FILE* fp = fopen( "t-bldump.out.col2", "rb" );
+			assert( fp != NULL );
+			reads = fread( act, 1, sizeof(act), fp );
+			fclose( fp );
+		}
+		mu_assert_equal( reads, 9 );
+		mu_assert_nstring_equal( act, "02\n05\n08\n", 9 );
+	}
+
+	/* binary */
+	{
+		char* argv[] = { "bldump", "--columns", "-b", "-f", "2", "-l", "2", t_tmpname, "t-bldump.out" };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( ret, 0 );
+		{
+			FILE* fp = fopen( "t-bldump.out.col1", "rb" );
+			assert( fp != NULL );
+			reads = fread( act, 1, sizeof(act), fp );
+			fclose( fp );
+		}
+		mu_assert_equal( reads, 4 );
+		mu_assert_equal( act[0], 0x02 );
+		mu_assert_equal( act[1], 0x03 );
+		mu_assert_equal( act[2], 0x06 );
+		mu_assert_equal( act[3], 0x07 );
+	}
+
+	remove( "t-bldump.out.col0" );
+	remove( "t-bldump.out.col1" );
+	remove( "t-bldump.out.col2" );
+	remove( t_tmpname );
+}
+
+/*!
+ * @brief test "bldump --stride=N --offset=K --count=L"
+ */
+static void t_main_stride(void)
+{
+	int ret;
+	char act[80];
+	char* s;
+	size_t i;
+
+	/* make input data, 0x00, 0x01, .. */
+	{
+		FILE* fp = fopen( t_tmpname, "wb" );
+		assert( fp != NULL );
+		for ( i = 0; i < 2*8192+4096+2; i++ ) fputc( (int)(i & 0xff), fp );
+		fclose( fp );
+	}
+
+	/* small stride (stdio), stopped at end address */
+	{
+		char* argv[] = { "bldump", "-a", "-s", "2", "-e", "33", "--stride=16", "--offset=4", "--count=3", t_tmpname };
+		fseek( t_stdout, 0, SEEK_SET );
+		(void) main( (int)(sizeof(argv)/sizeof(char*)), argv ); 
+
+		fflush( t_stdout );
+		fseek( t_stdout, 0, SEEK_SET );
+		s = fgets( act, (int)(sizeof(act)), t_stdout );
+		assert( s == act );
+		mu_assert_nstring_equal( act, "00000006: 06 07 08\n", 19 );
+		s = fgets( act, (int)(sizeof(act)), t_stdout );
+		assert( s == act );
+		mu_assert_nstring_equal( act, "00000016: 16 17 18\n", 19 );
+	}
+
+	/* large stride (pread), the last record is cut off by EOF */
+	{
+		char* argv[] = { "bldump", "-l", "2", "--stride=8192", "--offset=4096", "--count=4", t_tmpname };
+		fseek( t_stdout, 0, SEEK_SET );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( ret, 0 );
+
+		fflush( t_stdout );
+		fseek( t_stdout, 0, SEEK_SET );
+		s = fgets( act, (int)(sizeof(act)), t_stdout );
+		assert( s == act );
+		mu_assert_nstring_equal( act, "0001 0203\n", 10 );
+		s = fgets( act, (int)(sizeof(act)), t_stdout );
+		assert( s == act );
+		mu_assert_nstring_equal( act, "0001 0203\n", 10 );
+		s = fgets( act, (int)(sizeof(act)), t_stdout );
+		assert( s == act );
+		mu_assert_nstring_equal( act, "0001\n", 5 );
+	}
+
+	/* records of a batch, cut off by end address */
+	{
+		char* argv[] = { "bldump", "-l", "2", "-e", "12290", "--stride=8192", "--offset=4096", "--count=4", t_tmpname };
+		t_stdout_reset();
+		(void)main( (int)(sizeof(argv)/sizeof(char*)), argv ); /* stopped at end address */
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act, "0001 0203\n0001\n" );
+	}
+
+	/* huge stride (pread of each record) */
+	{
+		char* argv[] = { "bldump", "--stride=200000", "--offset=7", "--count=2", t_tmpname };
+		FILE* fp = fopen( t_tmpname, "wb" );
+		assert( fp != NULL );
+		for ( i = 0; i < 2*200000+8; i++ ) fputc( (int)(i & 0xff), fp );
+		fclose( fp );
+
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act, "07 08\n47 48\n87\n" );
+	}
+
+	/* offset + count > stride (error) */
+	{
+		char* argv[] = { "bldump", "--stride=16", "--offset=14", "--count=4", t_tmpname };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( ret, 1 );
+	}
+
+	remove( t_tmpname );
+}
+
+/*!
+ * @brief test "bldump -f 4 --ranges"
+ */
+static void t_main_ranges(void)
+{
+	int ret;
+	char* argv[] = { "bldump", "-f", "4", "--ranges=8-14,0+2,10-12,100-200", t_tmpname };
+	char act[80];
+	char* s;
+	size_t i;
+
+	/* make input data, 0x00, 0x01, .. 0x3f */
+	{
+		FILE* fp = fopen( t_tmpname, "wb" );
+		assert( fp != NULL );
+		for ( i = 0; i < 64; i++ ) fputc( (int)i, fp );
+		fclose( fp );
+	}
+
+	fseek( t_stdout, 0, SEEK_SET );
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv ); 
+	mu_assert_equal( ret, 0 );
+
+	fflush( t_stdout );
+	fseek( t_stdout, 0, SEEK_SET );
+	s = fgets( act, (int)(sizeof(act)), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "# 00000008-0000000e\n" );
+	s = fgets( act, (int)(sizeof(act)), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "08 09 0a 0b\n" );
+	s = fgets( act, (int)(sizeof(act)), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "0c 0d\n" );
+	s = fgets( act, (int)(sizeof(act)), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "# 00000000-00000002\n" );
+	s = fgets( act, (int)(sizeof(act)), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "00 01\n" );
+	s = fgets( act, (int)(sizeof(act)), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "# 0000000a-0000000c\n" );
+	s = fgets( act, (int)(sizeof(act)), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "0a 0b\n" );
+	s = fgets( act, (int)(sizeof(act)), t_stdout );
+	assert( s == act );
+	mu_assert_string_equal( act, "# 00000064-000000c8\n" ); /* out of file */
+
+	remove( t_tmpname );
+}
+
+/*!
+ * @brief test "bldump -f 4 --ranges" of a pipe, over the buffer and not ascending.
+ */
+static void t_main_ranges_pipe(void)
+{
+	static unsigned char data[200000];
+	char name[32], act[256], exp[256];
+	char* argv[] = { "bldump", "-f", "4", "--ranges=150000+4,10+4,149998+4", name };
+	int fds[2], ret;
+	pid_t pid;
+	size_t i;
+
+	for ( i = 0; i < sizeof(data); i++ ) {
+		data[i] = (unsigned char)(i ^ (i >> 8));
+	}
+	assert( pipe( fds ) == 0 );
+	pid = fork();
+	assert( pid >= 0 );
+	if ( pid == 0 ) {
+		(void)close( fds[0] );
+		ret = (write( fds[1], data, sizeof(data) ) == (ssize_t)sizeof(data)) ? 0 : 1;
+		_exit( ret );
+	}
+	(void)close( fds[1] );
+	(void)snprintf( name, sizeof(name), "/dev/fd/%d", fds[0] );
+
+	t_stdout_reset();
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 0 );
+	(void)close( fds[0] );
+	(void)waitpid( pid, NULL, 0 );
+
+	(void)snprintf( exp, sizeof(exp),
+		"# 000249f0-000249f4\n%02x %02x %02x %02x\n"
+		"# 0000000a-0000000e\n%02x %02x %02x %02x\n"
+		"# 000249ee-000249f2\n%02x %02x %02x %02x\n",
+		data[150000], data[150001], data[150002], data[150003],
+		data[10], data[11], data[12], data[13],
+		data[149998], data[149999], data[150000], data[150001] );
+	t_stdout_read( act, sizeof(act) );
+	mu_assert_string_equal( act, exp );
+}
+
+/*!
+ * @brief test "bldump --stats"
+ */
+static void t_main_stats(void)
+{
+	int ret;
+	char act[512];
+	size_t reads;
+	size_t i;
+
+	/* make input data, 0x00, 0x01, .. 0x09 */
+	{
+		FILE* fp = fopen( t_tmpname, "wb" );
+		assert( fp != NULL );
+		for ( i = 0; i < 10; i++ ) fputc( (int)i, fp );
+		fclose( fp );
+	}
+
+	/* json */
+	{
+		char* argv[] = { "bldump", "-f", "4", "--stats=json", t_tmpname };
+		fseek( t_stdout, 0, SEEK_SET );
+		fseek( t_stderr, 0, SEEK_SET );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( ret, 0 );
+
+		fflush( t_stdout );
+		fseek( t_stdout, 0, SEEK_SET );
+		reads = fread( act, 1, 30, t_stdout );
+		mu_assert_equal( reads, 30 );
+		mu_assert_nstring_equal( act, "00 01 02 03\n04 05 06 07\n08 09\n", 30 );
+
+		fflush( t_stderr );
+		fseek( t_stderr, 0, SEEK_SET );
+		memset( act, 0, sizeof(act) );
+		reads = fread( act, 1, sizeof(act) - 1, t_stderr );
+		mu_assert( strstr( act, "\"write\":{\"calls\":3," ) != NULL );
+		mu_assert( strstr( act, "\"bytes_in\":10,\"bytes_out\":30,\"rows\":3," ) != NULL );
+	}
+
+	/* text, -S */
+	{
+		char* argv[] = { "bldump", "-f", "4", "-S", "05", "--stats", t_tmpname };
+		fseek( t_stdout, 0, SEEK_SET );
+		fseek( t_stderr, 0, SEEK_SET );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( ret, 0 );
+
+		fflush( t_stderr );
+		fseek( t_stderr, 0, SEEK_SET );
+		memset( act, 0, sizeof(act) );
+		reads = fread( act, 1, sizeof(act) - 1, t_stderr );
+		mu_assert( strstr( act, "rows       1\n" ) != NULL );
+		mu_assert( strstr( act, "searches   2\n" ) != NULL );
+		mu_assert( strstr( act, "resyncs    1 (5 bytes skipped)\n" ) != NULL );
+	}
+}
+
 /*!
  * @brief test "bldump --version"
  */
@@ -242,6 +598,12 @@ void ts_main(void)
 	mu_run_test(t_main_reorder); // bldump -r 3210
 	mu_run_test(t_main_search);  // bldump -l 2 -f 1 -a -S FF
 	mu_run_test(t_main_ascii);   // bldump -A -d '' -l 4 -f 1
+	mu_run_test(t_main_npy);     // bldump --npy -i -l 2 -f 2
+	mu_run_test(t_main_columns); // bldump --columns -f 3
+	mu_run_test(t_main_stride);  // bldump --stride --offset --count
+	mu_run_test(t_main_ranges);  // bldump -f 4 --ranges
+	mu_run_test(t_main_ranges_pipe); // bldump -f 4 --ranges <pipe>
+	mu_run_test(t_main_stats);   // bldump --stats
 	mu_run_test(t_main_ver);     // bldump --version
 
 	/* cleanup */
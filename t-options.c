@@ -554,6 +554,258 @@ static void t_opt_search(void)
 	}
 }
 
+/*!
+ * @brief test --layout
+ */
+static void t_opt_layout(void)
+{
+	options_t opt;
+	bool is;
+
+	/* --layout */
+	{
+		char* argv[] = { "bldump", "--layout=u8,s16le,u32be,f32le,skip4", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, true );
+		mu_assert_ptr_not_null( opt.layout );
+		mu_assert_equal( opt.layout_fields, 5 );
+		mu_assert_equal( opt.data_length, 15 );
+		mu_assert_equal( opt.data_fields, 1 );
+		mu_assert_equal( opt.layout[1].type, FIELD_SIGNED );
+		mu_assert_equal( opt.layout[1].offset, 1 );
+		mu_assert_equal( opt.layout[1].little, true );
+		mu_assert_equal( opt.layout[2].type, FIELD_UNSIGNED );
+		mu_assert_equal( opt.layout[2].size, 4 );
+		mu_assert_equal( opt.layout[2].little, false );
+		mu_assert_equal( opt.layout[3].type, FIELD_FLOAT );
+		mu_assert_equal( opt.layout[4].type, FIELD_SKIP );
+		mu_assert_equal( opt.layout[4].offset, 11 );
+		(void)options_clear( &opt );
+		mu_assert_ptr_null( opt.layout );
+	}
+
+	/* --layout=u12 (error) */
+	{
+		char* argv[] = { "bldump", "--layout=u8,u12", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, false );
+		mu_assert_ptr_null( opt.layout );
+	}
+
+	/* --layout=f8 (error for a float narrower than f16) */
+	{
+		char* argv[] = { "bldump", "--layout=f8", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, false );
+	}
+
+	/* -l --layout (error for conflict of other options) */
+	{
+		char* argv[] = { "bldump", "-l", "2", "--layout=u8", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, false );
+	}
+}
+
+/*!
+ * @brief test --float
+ */
+static void t_opt_float(void)
+{
+	options_t opt;
+	bool is;
+
+	/* --float=f32 */
+	{
+		char* argv[] = { "bldump", "--float=f32", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, true );
+		mu_assert_equal( opt.output_type, FLOAT32 );
+		mu_assert_equal( opt.data_length, 4 );
+		mu_assert_equal( opt.data_order[0], -1 );
+	}
+
+	/* --float=f16le */
+	{
+		char* argv[] = { "bldump", "--float=f16le", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, true );
+		mu_assert_equal( opt.output_type, FLOAT16 );
+		mu_assert_equal( opt.data_length, 2 );
+		mu_assert_equal( opt.data_order[0], 1 );
+		mu_assert_equal( opt.data_order[1], 0 );
+	}
+
+	/* --float=f64be */
+	{
+		char* argv[] = { "bldump", "--float=f64be", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, true );
+		mu_assert_equal( opt.output_type, FLOAT64 );
+		mu_assert_equal( opt.data_length, 8 );
+	}
+
+	/* --float=f24 (error) */
+	{
+		char* argv[] = { "bldump", "--float=f24", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, false );
+	}
+
+	/* --float=f32xx (error) */
+	{
+		char* argv[] = { "bldump", "--float=f32xx", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, false );
+	}
+
+	/* -l --float (error for conflict of other options) */
+	{
+		char* argv[] = { "bldump", "-l", "4", "--float=f32", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, false );
+	}
+}
+
+/*!
+ * @brief test --bits, --lsb-first
+ */
+static void t_opt_bits(void)
+{
+	options_t opt;
+	bool is;
+
+	/* --bits */
+	{
+		char* argv[] = { "bldump", "--bits=12", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, true );
+		mu_assert_equal( opt.data_bits, 12 );
+		mu_assert_equal( opt.lsb_first, false );
+		mu_assert_equal( opt.data_length, 1 );
+	}
+
+	/* --lsb-first */
+	{
+		char* argv[] = { "bldump", "--bits=24", "--lsb-first", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, true );
+		mu_assert_equal( opt.data_bits, 24 );
+		mu_assert_equal( opt.lsb_first, true );
+	}
+
+	/* --bits=57 (error) */
+	{
+		char* argv[] = { "bldump", "--bits=57", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, false );
+	}
+
+	/* --bits -l (error for conflict of other options) */
+	{
+		char* argv[] = { "bldump", "--bits=12", "-l", "2", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, false );
+	}
+}
+
+/*!
+ * @brief test --npy
+ */
+static void t_opt_npy(void)
+{
+	options_t opt;
+	bool is;
+
+	/* --npy */
+	{
+		char* argv[] = { "bldump", "--npy", "-i", "infile", "outfile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, true );
+		mu_assert_equal( opt.npy_output, true );
+		mu_assert_equal( opt.output_type, DECIMAL );
+	}
+
+	/* --npy --bits (error) */
+	{
+		char* argv[] = { "bldump", "--npy", "--bits=12", "infile", "outfile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, false );
+	}
+}
+
+/*!
+ * @brief test --ranges
+ */
+static void t_opt_ranges(void)
+{
+	options_t opt;
+	bool is;
+
+	/* --ranges */
+	{
+		char* argv[] = { "bldump", "--ranges=0x10-0x20,4+2", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, true );
+		mu_assert_equal( opt.range_count, 2 );
+		mu_assert_equal( opt.ranges[0].start, 0x10 );
+		mu_assert_equal( opt.ranges[0].end,   0x20 );
+		mu_assert_equal( opt.ranges[1].start, 4 );
+		mu_assert_equal( opt.ranges[1].end,   6 );
+		(void)options_clear( &opt );
+		mu_assert_ptr_null( opt.ranges );
+	}
+
+	/* --ranges=@<file> */
+	{
+		char* argv[] = { "bldump", "--ranges=@t-bldump.tmp", "infile" };
+		FILE* fp = fopen( "t-bldump.tmp", "wt" );
+		assert( fp != NULL );
+		fputs( "1-2\n3+4\n\n5-6\n", fp );
+		fclose( fp );
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, true );
+		mu_assert_equal( opt.range_count, 3 );
+		mu_assert_equal( opt.ranges[1].end, 7 );
+		mu_assert_equal( opt.ranges[2].start, 5 );
+		remove( "t-bldump.tmp" );
+	}
+
+	/* --ranges=2-1 (error) */
+	{
+		char* argv[] = { "bldump", "--ranges=2-1", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, false );
+	}
+
+	/* --ranges=1 (error) */
+	{
+		char* argv[] = { "bldump", "--ranges=1", "infile" };
+		options_reset( &opt );
+		is = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ); 
+		mu_assert_equal( is, false );
+	}
+}
+
 void ts_opt(void)
 {
 	/* init */
@@ -582,6 +834,11 @@ void ts_opt(void)
 	mu_run_test(t_opt_end);            //options_load( bldump -e|--end-address)
 	mu_run_test(t_opt_reorder);        //options_load( bldump -r|--reorder)
 	mu_run_test(t_opt_search);         //options_load( bldump -S|--search)
+	mu_run_test(t_opt_layout);         //options_load( bldump --layout)
+	mu_run_test(t_opt_float);          //options_load( bldump --float)
+	mu_run_test(t_opt_bits);           //options_load( bldump --bits --lsb-first)
+	mu_run_test(t_opt_npy);            //options_load( bldump --npy)
+	mu_run_test(t_opt_ranges);         //options_load( bldump --ranges)
 
 	/* cleanup */
 	fclose( t_stdin  );
@@ -0,0 +1,134 @@
+/*!
+ * @file
+ * @brief unit test of 'proc.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+/*!
+ * @brief test "bldump -a -f 8 <pid>:<start>-<end>" of this process, and -s, -S.
+ */
+static void t_proc_range(void)
+{
+	static unsigned char data[64];
+	char name[64], exp[256], act[256];
+	size_t addr = (size_t)data;
+	int ret, i;
+
+	for ( i = 0; i < (int)sizeof(data); i++ ) {
+		data[i] = (unsigned char)i;
+	}
+	(void)snprintf( name, sizeof(name), "%d:%lx-%lx", (int)getpid(), (unsigned long)addr, (unsigned long)(addr + 12) );
+	mu_assert_equal( proc_name( name ), true );
+	{
+		char* argv[] = { "bldump", "-a", "-f", "8", name };
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		(void)snprintf( exp, sizeof(exp), "%08lx: 00 01 02 03 04 05 06 07\n%08lx: 08 09 0a 0b\n",
+			(unsigned long)addr, (unsigned long)(addr + 8) );
+		mu_assert_string_equal( act, exp );
+	}
+	/* -s is the address in the process */
+	{
+		char start[32];
+		char* argv[] = { "bldump", "-a", "-s", start, name };
+		(void)snprintf( start, sizeof(start), "%lu", (unsigned long)(addr + 10) );
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		(void)snprintf( exp, sizeof(exp), "%08lx: 0a 0b\n", (unsigned long)(addr + 10) );
+		mu_assert_string_equal( act, exp );
+	}
+	{
+		char* argv[] = { "bldump", "-a", "-f", "2", "-S", "0506", name };
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		(void)snprintf( exp, sizeof(exp), "%08lx: 05 06\n", (unsigned long)(addr + 5) );
+		mu_assert_string_equal( act, exp );
+	}
+	/* unreadable page is zeros */
+	{
+		char* argv[] = { "bldump", name };
+		(void)snprintf( name, sizeof(name), "%d:0-4", (int)getpid() );
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act, "00 00 00 00\n" );
+	}
+}
+
+/*!
+ * @brief test "bldump -f 4 <pid>:<mapping>" of the executable of this process.
+ */
+static void t_proc_maps(void)
+{
+	char exe[4096], name[4200], act[256];
+	const char* base;
+	ssize_t n;
+	int ret;
+
+	n = readlink( "/proc/self/exe", exe, sizeof(exe) - 1 );
+	assert( n > 0 );
+	exe[n] = '\0';
+	base = strrchr( exe, '/' );
+	base = (base != NULL) ? &base[1] : exe;
+
+	(void)snprintf( name, sizeof(name), "%d:%s", (int)getpid(), base );
+	{
+		char* argv[] = { "bldump", "-a", "-f", "4", name };
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert( strstr( act, ": 7f 45 4c 46\n" ) != NULL ); /* ELF header */
+	}
+
+	/* errors */
+	{
+		char* argv[] = { "bldump", name };
+		(void)snprintf( name, sizeof(name), "%d:t-proc.none", (int)getpid() );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+		(void)snprintf( name, sizeof(name), "%d:20-10", (int)getpid() );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	mu_assert_equal( proc_name( "12:" ), false );
+	mu_assert_equal( proc_name( "t-proc.c" ), false );
+}
+
+void ts_proc(void)
+{
+	/* init */
+	verbose_out = tmpfile();
+	t_stdin  = tmpfile();
+	t_stdout = tmpfile();
+	t_stderr = tmpfile();
+	assert( verbose_out != NULL && t_stdin != NULL && t_stdout != NULL && t_stderr != NULL );
+
+	/* test */
+	mu_run_test(t_proc_range); // bldump -a -f 8 <pid>:<start>-<end>
+	mu_run_test(t_proc_maps);  // bldump -f 4 <pid>:<mapping>
+
+	/* cleanup */
+	(void)fclose( verbose_out );
+	(void)fclose( t_stdin );
+	(void)fclose( t_stdout );
+	(void)fclose( t_stderr );
+	verbose_out = NULL;
+	t_stdin = t_stdout = t_stderr = NULL;
+}
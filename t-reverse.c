@@ -0,0 +1,252 @@
+/*!
+ * @file
+ * @brief unit test of 'reverse.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_REVERSE_BIN "t-reverse.bin"
+#define T_REVERSE_TXT "t-reverse.txt"
+#define T_REVERSE_OUT "t-reverse.out"
+
+static void t_reverse_text( const char* text )
+{
+	FILE* fp = fopen( T_REVERSE_TXT, "wb" );
+	assert( fp != NULL );
+	(void)fputs( text, fp );
+	fclose( fp );
+}
+
+static size_t t_reverse_read( const char* name, unsigned char* buf, size_t size )
+{
+	size_t n;
+	FILE* fp = fopen( name, "rb" );
+	assert( fp != NULL );
+	n = fread( buf, 1, size, fp );
+	fclose( fp );
+	return n;
+}
+
+/*!
+ * @brief test "bldump -a -r 10 -d ," and the reverse of it.
+ */
+static void t_reverse_hex(void)
+{
+	int ret;
+	char* dump[] = { "bldump", "-a", "-r", "10", "-d", ",", "-f", "3", T_REVERSE_BIN, T_REVERSE_TXT };
+	char* rev[]  = { "bldump", "--reverse", "-a", "-r", "10", "-d", ",", T_REVERSE_TXT, T_REVERSE_OUT };
+	unsigned char exp[256], act[300];
+	size_t i, n;
+
+	for ( i = 0; i < sizeof(exp); i++ ) {
+		exp[i] = (unsigned char)(i * 7);
+	}
+	{
+		FILE* fp = fopen( T_REVERSE_BIN, "wb" );
+		assert( fp != NULL );
+		(void)fwrite( exp, 1, sizeof(exp), fp );
+		fclose( fp );
+	}
+
+	ret = main( (int)(sizeof(dump)/sizeof(char*)), dump );
+	mu_assert_equal( ret, 0 );
+	ret = main( (int)(sizeof(rev)/sizeof(char*)), rev );
+	mu_assert_equal( ret, 0 );
+
+	n = t_reverse_read( T_REVERSE_OUT, act, sizeof(act) );
+	mu_assert_equal( n, sizeof(exp) );
+	mu_assert( memcmp( act, exp, sizeof(exp) ) == 0 );
+
+	/* upper case and a short word at the end */
+	{
+		char* argv[] = { "bldump", "--reverse", "-l", "2", "-d", "", T_REVERSE_TXT, T_REVERSE_OUT };
+		t_reverse_text( "0A0bFF\n10" );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		n = t_reverse_read( T_REVERSE_OUT, act, sizeof(act) );
+		mu_assert_equal( n, 4 );
+		mu_assert( memcmp( act, "\x0a\x0b\xff\x10", 4 ) == 0 );
+	}
+
+	/* runs of 16 digits, of -l 8 and of -d '' */
+	{
+		char* argv[] = { "bldump", "--reverse", "-l", "8", T_REVERSE_TXT, T_REVERSE_OUT };
+		t_reverse_text( "0123456789abcdef FEDCBA9876543210\n09afAF90faFA0a9f 0aff\n" );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		n = t_reverse_read( T_REVERSE_OUT, act, sizeof(act) );
+		mu_assert_equal( n, 26 );
+		mu_assert( memcmp( act, "\x01\x23\x45\x67\x89\xab\xcd\xef\xfe\xdc\xba\x98\x76\x54\x32\x10"
+			"\x09\xaf\xaf\x90\xfa\xfa\x0a\x9f\x0a\xff", 26 ) == 0 );
+	}
+	{
+		char* argv[] = { "bldump", "--reverse", "-d", "", T_REVERSE_TXT, T_REVERSE_OUT };
+		t_reverse_text( "000102030405060708090a0b0c0d0e0f101112\n13\n" );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		n = t_reverse_read( T_REVERSE_OUT, act, sizeof(act) );
+		mu_assert_equal( n, 20 );
+		for ( i = 0; i < n; i++ ) {
+			mu_assert_equal( act[i], i );
+		}
+	}
+}
+
+/*!
+ * @brief test "bldump --reverse -i" and "-u".
+ */
+static void t_reverse_dec(void)
+{
+	int ret;
+	unsigned char act[32];
+	size_t n;
+
+	{
+		char* argv[] = { "bldump", "--reverse", "-i", "-l", "2", "-d", ", ", T_REVERSE_TXT, T_REVERSE_OUT };
+		t_reverse_text( "-32768, -1, 0\n32767\n" );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		n = t_reverse_read( T_REVERSE_OUT, act, sizeof(act) );
+		mu_assert_equal( n, 8 );
+		mu_assert( memcmp( act, "\x80\x00\xff\xff\x00\x00\x7f\xff", 8 ) == 0 );
+	}
+	{
+		char* argv[] = { "bldump", "--reverse", "-u", "-r", "76543210", T_REVERSE_TXT, T_REVERSE_OUT };
+		t_reverse_text( "18446744073709551615 1\n" );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		n = t_reverse_read( T_REVERSE_OUT, act, sizeof(act) );
+		mu_assert_equal( n, 16 );
+		mu_assert( memcmp( act, "\xff\xff\xff\xff\xff\xff\xff\xff\x01\x00\x00\x00\x00\x00\x00\x00", 16 ) == 0 );
+	}
+	/* out of range */
+	{
+		char* argv[] = { "bldump", "--reverse", "-i", T_REVERSE_TXT, T_REVERSE_OUT };
+		t_reverse_text( "127 128\n" );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--reverse", "-u", "-l", "8", T_REVERSE_TXT, T_REVERSE_OUT };
+		t_reverse_text( "18446744073709551616\n" );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+}
+
+/*!
+ * @brief test the address of rows, "bldump --reverse -a -s 0x10"
+ */
+static void t_reverse_address(void)
+{
+	int ret;
+	char* argv[] = { "bldump", "--reverse", "-a", "-s", "0x10", T_REVERSE_TXT, T_REVERSE_OUT };
+	unsigned char act[32];
+	size_t n;
+
+	/* a gap is filled with zeros */
+	t_reverse_text( "00000010: 01 02\n00000014: 03\n" );
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 0 );
+	n = t_reverse_read( T_REVERSE_OUT, act, sizeof(act) );
+	mu_assert_equal( n, 5 );
+	mu_assert( memcmp( act, "\x01\x02\x00\x00\x03", 5 ) == 0 );
+
+	/* address goes back */
+	t_reverse_text( "00000010: 01 02\n00000011: 03\n" );
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 1 );
+
+	/* before -s */
+	t_reverse_text( "00000008: 01\n" );
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 1 );
+}
+
+/*!
+ * @brief test the errors of --reverse.
+ */
+static void t_reverse_error(void)
+{
+	int ret;
+
+	t_reverse_text( "00 01 0x\n" );
+	{
+		char* argv[] = { "bldump", "--reverse", T_REVERSE_TXT, T_REVERSE_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--reverse", "-l", "2", T_REVERSE_TXT, T_REVERSE_OUT };
+		t_reverse_text( "00 0102\n" ); /* a short word before the end */
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		/* the digits next to 0-9, a-f and A-F in a run of 16 */
+		const char* text[] = { "0123456789abcde/\n", "0123456789abcde:\n", "0123456789abcde`\n",
+			"0123456789abcdeg\n", "0123456789abcde@\n", "0123456789abcdeG\n", "/123456789abcdef\n" };
+		char* argv[] = { "bldump", "--reverse", "-l", "8", T_REVERSE_TXT, T_REVERSE_OUT };
+		size_t i;
+		for ( i = 0; i < sizeof(text)/sizeof(text[0]); i++ ) {
+			t_reverse_text( text[i] );
+			ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+			mu_assert_equal( ret, 1 );
+		}
+	}
+	{
+		char* argv[] = { "bldump", "--reverse", "-d", "", T_REVERSE_TXT, T_REVERSE_OUT };
+		t_reverse_text( "000102030405060708090a0b0c0d0e0f1x\n" );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--reverse", "-A", T_REVERSE_TXT, T_REVERSE_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--reverse", "-i", "-d", "", T_REVERSE_TXT, T_REVERSE_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--reverse", "--npy", T_REVERSE_TXT, T_REVERSE_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+}
+
+void ts_reverse(void)
+{
+	/* init */
+	verbose_out = tmpfile();
+	t_stdin  = tmpfile();
+	t_stdout = tmpfile();
+	t_stderr = tmpfile();
+	assert( verbose_out != NULL && t_stdin != NULL && t_stdout != NULL && t_stderr != NULL );
+
+	/* test */
+	mu_run_test(t_reverse_hex);     // bldump -a -r 10 -d , and --reverse
+	mu_run_test(t_reverse_dec);     // bldump --reverse -i, -u
+	mu_run_test(t_reverse_address); // bldump --reverse -a -s 0x10
+	mu_run_test(t_reverse_error);
+
+	/* cleanup */
+	(void)remove( T_REVERSE_BIN );
+	(void)remove( T_REVERSE_TXT );
+	(void)remove( T_REVERSE_OUT );
+	(void)fclose( verbose_out );
+	(void)fclose( t_stdin );
+	(void)fclose( t_stdout );
+	(void)fclose( t_stderr );
+	verbose_out = NULL;
+	t_stdin = t_stdout = t_stderr = NULL;
+}
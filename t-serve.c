@@ -0,0 +1,145 @@
+/*!
+ * @file
+ * @brief unit test of 'serve.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_SERVE_SOCKET "t-serve.sock" /*!< socket of the test daemon. */
+#define T_SERVE_FILE   "t-serve.tmp"  /*!< infile of the test. */
+
+/*!
+ * @brief test bldump_forward without the daemon
+ */
+static void t_serve_none(void)
+{
+	char* argv[] = { "bldump", T_SERVE_FILE };
+	int ret;
+
+	ret = bldump_forward( T_SERVE_SOCKET, (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, -1 );
+}
+
+/*!
+ * @brief test "bldump --serve" and forwarding to it
+ */
+static void t_serve_forward(void)
+{
+	char* argv1[] = { "bldump", "-a", "-f", "4", T_SERVE_FILE };
+	char* argv2[] = { "bldump", "--stride=4", T_SERVE_FILE };
+	char* argv3[] = { "bldump", "t-serve-none.tmp" };
+	char act[80];
+	char* s;
+	struct stat st;
+	pid_t pid;
+	int ret, i, status;
+	FILE* fp;
+
+	/* make input data */
+	fp = fopen( T_SERVE_FILE, "wb" );
+	assert( fp != NULL );
+	fputs( "0123456789", fp );
+	fclose( fp );
+
+	/* daemon */
+	pid = fork();
+	assert( pid >= 0 );
+	if ( pid == 0 ) {
+		options_t opt;
+		char* argv[] = { "bldump", "--serve=" T_SERVE_SOCKET };
+		options_reset( &opt );
+		if ( options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv ) == false ) {
+			_exit( 2 );
+		}
+		_exit( bldump_serve( &opt ) == true ? 0 : 1 );
+	}
+	for ( i = 0; i < 100 && stat( T_SERVE_SOCKET, &st ) != 0; i++ ) {
+		(void)usleep( 10000 );
+	}
+	mu_assert_equal( (st.st_mode & 0777), 0600 ); /* of the owner only */
+
+	/* served twice, the 2nd is from the cache */
+	for ( i = 0; i < 2; i++ ) {
+		fseek( t_stdout, 0, SEEK_SET );
+		ret = bldump_forward( T_SERVE_SOCKET, (int)(sizeof(argv1)/sizeof(char*)), argv1 );
+		mu_assert_equal( ret, 0 );
+		fflush( t_stdout );
+		fseek( t_stdout, 0, SEEK_SET );
+		s = fgets( act, (int)sizeof(act), t_stdout );
+		assert( s == act );
+		mu_assert_string_equal( act, "00000000: 30 31 32 33\n" );
+		s = fgets( act, (int)sizeof(act), t_stdout );
+		assert( s == act );
+		mu_assert_string_equal( act, "00000004: 34 35 36 37\n" );
+		s = fgets( act, (int)sizeof(act), t_stdout );
+		assert( s == act );
+		mu_assert_string_equal( act, "00000008: 38 39\n" );
+	}
+
+	/* a client sending no request times out, and the next one is served */
+	{
+		struct sockaddr_un addr;
+		int sock = socket( AF_UNIX, SOCK_STREAM, 0 );
+		assert( sock >= 0 );
+		memset( &addr, 0, sizeof(addr) );
+		addr.sun_family = AF_UNIX;
+		strcpy( addr.sun_path, T_SERVE_SOCKET );
+		ret = connect( sock, (struct sockaddr*)&addr, sizeof(addr) );
+		mu_assert_equal( ret, 0 );
+		fseek( t_stdout, 0, SEEK_SET );
+		ret = bldump_forward( T_SERVE_SOCKET, (int)(sizeof(argv1)/sizeof(char*)), argv1 );
+		mu_assert_equal( ret, 0 );
+		fflush( t_stdout );
+		fseek( t_stdout, 0, SEEK_SET );
+		s = fgets( act, (int)sizeof(act), t_stdout );
+		assert( s == act );
+		mu_assert_string_equal( act, "00000000: 30 31 32 33\n" );
+		(void)close( sock );
+	}
+
+	/* dumped by the client, not supported by stream or no infile */
+	ret = bldump_forward( T_SERVE_SOCKET, (int)(sizeof(argv2)/sizeof(char*)), argv2 );
+	mu_assert_equal( ret, -1 );
+	ret = bldump_forward( T_SERVE_SOCKET, (int)(sizeof(argv3)/sizeof(char*)), argv3 );
+	mu_assert_equal( ret, -1 );
+
+	/* stop */
+	(void)kill( pid, SIGTERM );
+	(void)waitpid( pid, &status, 0 );
+	mu_assert( WIFEXITED( status ) );
+	mu_assert_equal( WEXITSTATUS( status ), 0 );
+	mu_assert( stat( T_SERVE_SOCKET, &st ) != 0 );
+
+	(void)remove( T_SERVE_FILE );
+}
+
+void ts_serve(void)
+{
+	/* init */
+	t_stdout = tmpfile();
+	verbose_out = tmpfile();
+	assert( t_stdout != NULL && verbose_out != NULL );
+
+	/* test */
+	mu_run_test(t_serve_none);    // bldump_forward
+	mu_run_test(t_serve_forward); // bldump --serve
+
+	/* cleanup */
+	(void)fclose( t_stdout );
+	(void)fclose( verbose_out );
+	t_stdout = NULL;
+	verbose_out = NULL;
+}
@@ -0,0 +1,292 @@
+/*!
+ * @file
+ * @brief unit test of 'stream.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_STREAM_OUT "t-stream.tmp"
+
+/*** t_sink_t ***/
+typedef struct {
+	char   buf[256]; /*!< received text. */
+	size_t size;     /*!< received size. */
+	size_t limit;    /*!< fails over this size. */
+} t_sink_t;
+
+static size_t t_sink( void* user, const char* buf, size_t size )
+{
+	t_sink_t* sink = (t_sink_t*)user;
+	if ( sink->size + size > sink->limit ) {
+		return 0;
+	}
+	memcpy( &sink->buf[sink->size], buf, size );
+	sink->size += size;
+	sink->buf[sink->size] = '\0';
+	return size;
+}
+
+static void t_sink_reset( t_sink_t* sink )
+{
+	memset( sink, 0, sizeof(t_sink_t) );
+	sink->limit = sizeof(sink->buf) - 1;
+}
+
+/*!
+ * @brief test "bldump -a -f 4" pushed by 3 bytes
+ */
+static void t_stream_push(void)
+{
+	options_t opt;
+	char* argv[] = { "bldump", "-a", "-f", "4", "stream" };
+	bldump_t* ctx;
+	t_sink_t sink;
+	const char* in = "0123456789";
+	bool ret;
+	size_t i;
+
+	options_reset( &opt );
+	ret = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, true );
+	t_sink_reset( &sink );
+
+	ctx = bldump_open( &opt, t_sink, &sink );
+	assert( ctx != NULL );
+	for ( i = 0; i < 9; i += 3 ) {
+		ret = bldump_push( ctx, &in[i], 3 );
+		mu_assert_equal( ret, true );
+	}
+	/* complete records are written at each push */
+	mu_assert_string_equal( sink.buf, "00000000: 30 31 32 33\n00000004: 34 35 36 37\n" );
+	ret = bldump_push( ctx, &in[9], 1 );
+	mu_assert_equal( ret, true );
+	ret = bldump_close( ctx );
+	mu_assert_equal( ret, true );
+	mu_assert_string_equal( sink.buf, "00000000: 30 31 32 33\n00000004: 34 35 36 37\n00000008: 38 39\n" );
+
+	(void)options_clear( &opt );
+}
+
+/*!
+ * @brief test two streams at once, "bldump -i -l 2 -f 2 -s 1 -e 7" and "bldump -f 8"
+ */
+static void t_stream_multi(void)
+{
+	options_t opt1, opt2;
+	char* argv1[] = { "bldump", "-i", "-l", "2", "-f", "2", "-s", "1", "-e", "7", "stream" };
+	char* argv2[] = { "bldump", "-f", "8", "stream" };
+	bldump_t *ctx1, *ctx2;
+	t_sink_t sink1, sink2;
+	const unsigned char in[] = { 0xff, 0xff, 0xfe, 0x00, 0x01, 0x00, 0x02, 0xff };
+	bool ret;
+	size_t i;
+
+	options_reset( &opt1 );
+	options_reset( &opt2 );
+	ret = options_load( &opt1, (int)(sizeof(argv1)/sizeof(char*)), argv1 );
+	mu_assert_equal( ret, true );
+	ret = options_load( &opt2, (int)(sizeof(argv2)/sizeof(char*)), argv2 );
+	mu_assert_equal( ret, true );
+	t_sink_reset( &sink1 );
+	t_sink_reset( &sink2 );
+
+	ctx1 = bldump_open( &opt1, t_sink, &sink1 );
+	ctx2 = bldump_open( &opt2, t_sink, &sink2 );
+	assert( ctx1 != NULL && ctx2 != NULL );
+	for ( i = 0; i < sizeof(in); i++ ) {
+		ret = bldump_push( ctx1, &in[i], 1 );
+		mu_assert_equal( ret, true );
+		ret = bldump_push( ctx2, &in[i], 1 );
+		mu_assert_equal( ret, true );
+	}
+	ret = bldump_close( ctx1 );
+	mu_assert_equal( ret, true );
+	ret = bldump_close( ctx2 );
+	mu_assert_equal( ret, true );
+	mu_assert_string_equal( sink1.buf, "-2 1\n2\n" );
+	mu_assert_string_equal( sink2.buf, "ff ff fe 00 01 00 02 ff\n" );
+
+	(void)options_clear( &opt1 );
+	(void)options_clear( &opt2 );
+}
+
+/*!
+ * @brief test "bldump -f 3 -S aa55 -a" pushed by a byte, the pattern is split
+ */
+static void t_stream_search(void)
+{
+	options_t opt;
+	char* argv[] = { "bldump", "-f", "3", "-S", "aa55", "-a", "stream" };
+	bldump_t* ctx;
+	t_sink_t sink;
+	const unsigned char in[] = { 0x00, 0xaa, 0x55, 0x01, 0xaa, 0xaa, 0x55, 0x02, 0x03, 0xaa };
+	bool ret;
+	size_t i;
+
+	options_reset( &opt );
+	ret = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, true );
+	t_sink_reset( &sink );
+
+	ctx = bldump_open( &opt, t_sink, &sink );
+	assert( ctx != NULL );
+	for ( i = 0; i < sizeof(in); i++ ) {
+		ret = bldump_push( ctx, &in[i], 1 );
+		mu_assert_equal( ret, true );
+	}
+	ret = bldump_close( ctx );
+	mu_assert_equal( ret, true );
+	mu_assert_string_equal( sink.buf, "00000001: aa 55 01\n00000005: aa 55 02\n" );
+
+	(void)options_clear( &opt );
+}
+
+/*!
+ * @brief test errors of the stream
+ */
+static void t_stream_error(void)
+{
+	options_t opt;
+	char* argv[] = { "bldump", "--npy", "stream", "stream.npy" };
+	char* argv2[] = { "bldump", "-f", "4", "stream" };
+	char* argv3[][3] = {
+		{ "bldump", "--compress=gzip", "stream" },
+		{ "bldump", "--out=-b:" T_STREAM_OUT, "stream" },
+	};
+	bldump_t* ctx;
+	t_sink_t sink;
+	bool ret;
+	size_t i;
+
+	/* --npy needs seekable outfile */
+	options_reset( &opt );
+	ret = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, true );
+	t_sink_reset( &sink );
+	ctx = bldump_open( &opt, t_sink, &sink );
+	mu_assert( ctx == NULL );
+	(void)options_clear( &opt );
+
+	/* outfiles of --compress and --out aren't the sink */
+	for ( i = 0; i < sizeof(argv3)/sizeof(argv3[0]); i++ ) {
+		options_reset( &opt );
+		ret = options_load( &opt, 3, argv3[i] );
+		mu_assert_equal( ret, true );
+		t_sink_reset( &sink );
+		ctx = bldump_open( &opt, t_sink, &sink );
+		mu_assert( ctx == NULL );
+		(void)options_clear( &opt );
+	}
+
+	/* sink failure */
+	options_reset( &opt );
+	ret = options_load( &opt, (int)(sizeof(argv2)/sizeof(char*)), argv2 );
+	mu_assert_equal( ret, true );
+	t_sink_reset( &sink );
+	sink.limit = 4;
+	ctx = bldump_open( &opt, t_sink, &sink );
+	assert( ctx != NULL );
+	ret = bldump_push( ctx, "0123", 4 );
+	mu_assert_equal( ret, false );
+	ret = bldump_close( ctx );
+	mu_assert_equal( ret, false );
+	(void)options_clear( &opt );
+}
+
+/*!
+ * @brief test "bldump --stats -f 2 --where=..." and "bldump -v 0 -f 4" are counted and verbose by each
+ */
+static void t_stream_stats(void)
+{
+	options_t opt1, opt2;
+	char* argv1[] = { "bldump", "--stats", "-f", "2", "--where=field[0] == 0x30", "stream" };
+	char* argv2[] = { "bldump", "-v", "0", "--stats", "-f", "4", "stream" };
+	bldump_t *ctx1, *ctx2;
+	t_sink_t sink1, sink2;
+	const stats_t* stats;
+	unsigned int level = verbose_level;
+	long pos;
+	bool ret;
+
+	options_reset( &opt1 );
+	ret = options_load( &opt1, (int)(sizeof(argv1)/sizeof(char*)), argv1 );
+	mu_assert_equal( ret, true );
+	options_reset( &opt2 );
+	ret = options_load( &opt2, (int)(sizeof(argv2)/sizeof(char*)), argv2 );
+	mu_assert_equal( ret, true );
+	verbose_level = level; /* -v of opt2 is of the stream only */
+	t_sink_reset( &sink1 );
+	t_sink_reset( &sink2 );
+
+	ctx1 = bldump_open( &opt1, t_sink, &sink1 );
+	ctx2 = bldump_open( &opt2, t_sink, &sink2 );
+	assert( ctx1 != NULL && ctx2 != NULL );
+	ret = bldump_push( ctx1, "0123", 4 );
+	mu_assert_equal( ret, true );
+	ret = bldump_push( ctx2, "01234567", 8 );
+	mu_assert_equal( ret, true );
+	ret = bldump_push( ctx2, "89", 2 );
+	mu_assert_equal( ret, true );
+
+	/* counters of each stream, not of opt */
+	stats = bldump_stats( ctx1 );
+	assert( stats != NULL );
+	mu_assert( stats != opt1.stats );
+	mu_assert_equal( stats->reads, 1 );
+	mu_assert_equal( stats->bytes_in, 4 );
+	mu_assert_equal( stats->rejected, 1 );
+	stats = bldump_stats( ctx2 );
+	assert( stats != NULL );
+	mu_assert_equal( stats->reads, 2 );
+	mu_assert_equal( stats->bytes_in, 10 );
+	mu_assert_equal( stats->rejected, 0 );
+	mu_assert_equal( opt1.stats->reads, 0 );
+
+	/* errors of the sink aren't written by -v 0 */
+	(void)fflush( verbose_out );
+	pos = ftell( verbose_out );
+	sink2.limit = 0;
+	ret = bldump_close( ctx2 );
+	mu_assert_equal( ret, false );
+	(void)fflush( verbose_out );
+	mu_assert_equal( ftell( verbose_out ), pos );
+
+	/* but by the other stream */
+	pos = ftell( verbose_out );
+	sink1.limit = 0;
+	ret = bldump_push( ctx1, "01", 2 );
+	mu_assert_equal( ret, false );
+	(void)fflush( verbose_out );
+	mu_assert( ftell( verbose_out ) > pos );
+
+	ret = bldump_close( ctx1 );
+	mu_assert_equal( ret, false );
+	mu_assert_string_equal( sink1.buf, "30 31\n" );
+	(void)options_clear( &opt1 );
+	(void)options_clear( &opt2 );
+}
+
+void ts_stream(void)
+{
+	/* init */
+	verbose_out = tmpfile();
+	assert( verbose_out != NULL );
+
+	/* test */
+	mu_run_test(t_stream_push);  // bldump -a -f 4
+	mu_run_test(t_stream_multi); // bldump -i -l 2 -f 2 -s 1 -e 7, bldump -f 8
+	mu_run_test(t_stream_search); // bldump -f 3 -S aa55 -a
+	mu_run_test(t_stream_error); // bldump --npy, --compress=gzip, --out=...
+	mu_run_test(t_stream_stats); // bldump --stats -f 2 --where=..., bldump -v 0 --stats -f 4
+
+	/* cleanup */
+	(void)fclose( verbose_out );
+	verbose_out = NULL;
+}
@@ -0,0 +1,182 @@
+/*!
+ * @file
+ * @brief unit test of 'tee.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_TEE_IN   "t-tee.in"
+#define T_TEE_EXP  "t-tee.exp"
+#define T_TEE_OUT  "t-tee.out"
+#define T_TEE_OUT1 "t-tee.out1"
+#define T_TEE_OUT2 "t-tee.out2"
+#define T_TEE_SIZE 1200000 /*!< infile size, the rows are over the ring of blocks. */
+
+/*!
+ * @brief check the file is the same as T_TEE_EXP.
+ */
+static bool t_tee_same( const char* name, bool gzip )
+{
+	data_t *exp, *act;
+	size_t exp_size, act_size;
+	bool is;
+
+	exp = t_file_load( T_TEE_EXP, false, 4 * T_TEE_SIZE, &exp_size );
+	act = t_file_load( name, gzip, 4 * T_TEE_SIZE, &act_size );
+	is = exp_size > 0 && act_size == exp_size && memcmp( act, exp, exp_size ) == 0;
+	free( exp );
+	free( act );
+	return is;
+}
+
+/*!
+ * @brief test "bldump --out=... --out=..." is the same as the dump of each.
+ */
+static void t_tee_formats(void)
+{
+	{
+		char* argv[] = { "bldump", "-e", "100000", "-l", "2", "-f", "4", "-a",
+			"--out=-i -d ,:" T_TEE_OUT1, "--out=-A:" T_TEE_OUT2, T_TEE_IN, T_TEE_OUT };
+		(void)main( (int)(sizeof(argv)/sizeof(char*)), argv ); /* stopped at end address */
+	}
+
+	/* outfile */
+	{
+		char* argv[] = { "bldump", "-e", "100000", "-l", "2", "-f", "4", "-a", T_TEE_IN, T_TEE_EXP };
+		(void)main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert( t_tee_same( T_TEE_OUT, false ) );
+	}
+	/* -i -d , */
+	{
+		char* argv[] = { "bldump", "-e", "100000", "-l", "2", "-f", "4", "-i", "-d", ",", T_TEE_IN, T_TEE_EXP };
+		(void)main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert( t_tee_same( T_TEE_OUT1, false ) );
+	}
+	/* -A rewrites the row of its own */
+	{
+		char* argv[] = { "bldump", "-e", "100000", "-l", "2", "-f", "4", "-A", T_TEE_IN, T_TEE_EXP };
+		(void)main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert( t_tee_same( T_TEE_OUT2, false ) );
+	}
+}
+
+/*!
+ * @brief test "bldump -b --out=-b:... --out=--compress=gzip:..." over the ring.
+ */
+static void t_tee_binary(void)
+{
+	int ret;
+	{
+		char* argv[] = { "bldump", "-b", "-r", "3210", "--out=-b:" T_TEE_OUT1,
+			"--out=-b --compress=gzip,1:" T_TEE_OUT2, T_TEE_IN, T_TEE_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+	}
+	{
+		char* argv[] = { "bldump", "-b", "-r", "3210", T_TEE_IN, T_TEE_EXP };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+	}
+	mu_assert( t_tee_same( T_TEE_OUT, false ) );
+	mu_assert( t_tee_same( T_TEE_OUT1, false ) );
+	mu_assert( t_tee_same( T_TEE_OUT2, true ) );
+
+	/* -S, a row of each search */
+	{
+		char* argv[] = { "bldump", "-a", "-S", "0000", "-f", "4", "--out=-a:" T_TEE_OUT1, T_TEE_IN, T_TEE_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+	}
+	{
+		char* argv[] = { "bldump", "-a", "-S", "0000", "-f", "4", T_TEE_IN, T_TEE_EXP };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+	}
+	mu_assert( t_tee_same( T_TEE_OUT, false ) );
+	mu_assert( t_tee_same( T_TEE_OUT1, false ) );
+}
+
+/*!
+ * @brief test the errors of --out.
+ */
+static void t_tee_error(void)
+{
+	int ret;
+	{
+		char* argv[] = { "bldump", "--out=-x:" T_TEE_OUT1, T_TEE_IN, T_TEE_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--out=-a:", T_TEE_IN, T_TEE_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--out=-a:" T_TEE_OUT1, "--columns", T_TEE_IN, T_TEE_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--out=--npy --compress=gzip:" T_TEE_OUT1, T_TEE_IN, T_TEE_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--out=--compress=gzip,12:" T_TEE_OUT1, T_TEE_IN, T_TEE_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--out=-a:t-tee.none/" T_TEE_OUT1, T_TEE_IN, T_TEE_OUT };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+}
+
+void ts_tee(void)
+{
+	unsigned int x = 1;
+	FILE* fp;
+	int i;
+
+	/* init */
+	verbose_out = tmpfile();
+	t_stdin  = tmpfile();
+	t_stdout = tmpfile();
+	t_stderr = tmpfile();
+	assert( verbose_out != NULL && t_stdin != NULL && t_stdout != NULL && t_stderr != NULL );
+
+	fp = fopen( T_TEE_IN, "wb" );
+	assert( fp != NULL );
+	for ( i = 0; i < T_TEE_SIZE; i++ ) {
+		x = x * 1103515245u + 12345u;
+		(void)fputc( (int)((x >> 16) & 0xff), fp );
+	}
+	fclose( fp );
+
+	/* test */
+	mu_run_test(t_tee_formats); // bldump --out=-i -d ,:<file> --out=-A:<file>
+	mu_run_test(t_tee_binary);  // bldump -b --out=-b:<file> --out=--compress=gzip:<file>
+	mu_run_test(t_tee_error);   // bldump --out=-x:<file>
+
+	/* cleanup */
+	(void)remove( T_TEE_IN );
+	(void)remove( T_TEE_EXP );
+	(void)remove( T_TEE_OUT );
+	(void)remove( T_TEE_OUT1 );
+	(void)remove( T_TEE_OUT2 );
+	(void)fclose( verbose_out );
+	(void)fclose( t_stdin );
+	(void)fclose( t_stdout );
+	(void)fclose( t_stderr );
+	verbose_out = NULL;
+	t_stdin = t_stdout = t_stderr = NULL;
+}
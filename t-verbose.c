@@ -4,7 +4,9 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
+#include <limits.h>
 #include <assert.h>
 
 #include "munit.h"
@@ -39,6 +41,67 @@ static void t_verbose_printf(void)
 	mu_assert( verbose_printf( VERB_DEBUG, "This message is not effective\n" ) == 0 );
 }
 
+/*!
+ * @brief test of the level check at the call site.
+ */
+static void t_verbose_inline(void)
+{
+	int n = 0;
+
+	assert( verbose_level == VERB_DEFAULT );
+
+	/* arguments aren't evaluated */
+	mu_assert( verbose_printf( VERB_DEBUG, "%d\n", n++ ) == 0 );
+	mu_assert( n == 0 );
+	mu_assert( verbose_printf( VERB_INFO, "%d\n", n++ ) == 2 );
+	mu_assert( n == 1 );
+
+	/* function is still callable */
+	mu_assert( (verbose_printf)( VERB_DEBUG, "%d\n", n ) == 0 );
+
+	/* the largest level doesn't wrap */
+	verbose_level = UINT_MAX;
+	mu_assert( verbose_printf( VERB_INFO, "%d\n", n ) == 2 );
+	verbose_level = VERB_DEFAULT;
+}
+
+/*!
+ * @brief test of the trace ring buffer.
+ */
+static void t_verbose_ring(void)
+{
+	char act[VERBOSE_RING_TEXT];
+	char* s;
+	int i, fail = 0;
+
+	verbose_level = VERB_TRACE;
+	verbose_ring_dump(); /* drops messages of previous tests */
+	fseek( verbose_out, 0, SEEK_SET );
+
+	/* stored, not written */
+	for ( i = 0; i < VERBOSE_RING_SIZE + 2; i++ ) {
+		if ( verbose_printf( VERB_TRACE, "trace %04d\n", i ) != 11 ) fail++;
+	}
+	mu_assert( fail == 0 );
+	mu_assert( ftell( verbose_out ) == 0 );
+
+	/* the last VERBOSE_RING_SIZE messages */
+	verbose_ring_dump();
+	fflush( verbose_out );
+	mu_assert( ftell( verbose_out ) == 11 * VERBOSE_RING_SIZE );
+	fseek( verbose_out, 0, SEEK_SET );
+	s = fgets( act, (int)sizeof(act), verbose_out );
+	assert( s == act );
+	mu_assert_string_equal( act, "trace 0002\n" );
+
+	/* dumped once */
+	fseek( verbose_out, 0, SEEK_SET );
+	verbose_ring_dump();
+	mu_assert( ftell( verbose_out ) == 0 );
+
+	verbose_level = VERB_DEFAULT;
+}
+
 /*!
  * @brief test of 'verbose_die()'.
  */
@@ -80,6 +143,8 @@ void ts_verbose(void)
 	/* test */
 	mu_run_test(t_verbose_level);
 	mu_run_test(t_verbose_printf);
+	mu_run_test(t_verbose_inline);
+	mu_run_test(t_verbose_ring);
 	mu_run_test(t_verbose_die);
 
 	/* cleanup */
@@ -0,0 +1,148 @@
+/*!
+ * @file
+ * @brief unit test of 'watch.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_WATCH_IN "t-watch.in"
+
+static void t_watch_write( long offset, const void* data, size_t size )
+{
+	FILE* fp = fopen( T_WATCH_IN, (offset < 0) ? "wb" : "r+b" );
+	assert( fp != NULL );
+	if ( offset > 0 ) {
+		(void)fseek( fp, offset, SEEK_SET );
+	}
+	(void)fwrite( data, 1, size, fp );
+	fclose( fp );
+}
+
+/*!
+ * @brief test the passes of "bldump --watch -f 16"
+ */
+static void t_watch_pass(void)
+{
+	options_t opt;
+	char* argv[] = { "bldump", "--watch", T_WATCH_IN };
+	static char zero[1024];
+	char act[4096];
+	watch_t* ctx;
+	bool ret;
+
+	t_watch_write( -1, zero, sizeof(zero) );
+	options_reset( &opt );
+	ret = options_load( &opt, (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, true );
+	ctx = watch_open( &opt );
+	assert( ctx != NULL );
+
+	/* all the rows at first */
+	ret = watch_pass( ctx );
+	mu_assert_equal( ret, true );
+	t_stdout_read( act, sizeof(act) );
+	t_stdout_reset();
+	mu_assert_equal( strlen( act ), 64 * 58 );
+
+	/* no change */
+	ret = watch_pass( ctx );
+	mu_assert_equal( ret, true );
+	t_stdout_read( act, sizeof(act) );
+	t_stdout_reset();
+	mu_assert_string_equal( act, "" );
+
+	/* the rows of the changed block */
+	t_watch_write( 0x1c1, "\x55", 1 );
+	ret = watch_pass( ctx );
+	mu_assert_equal( ret, true );
+	t_stdout_read( act, sizeof(act) );
+	t_stdout_reset();
+	mu_assert_string_equal( act,
+		"000001c0: 00 55 00 00 00 00 00 00 00 00 00 00 00 00 00 00\n"
+		"000001d0: 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00\n"
+		"000001e0: 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00\n"
+		"000001f0: 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00\n" );
+
+	/* appended */
+	t_watch_write( 1024, "\x01\x02", 2 );
+	ret = watch_pass( ctx );
+	mu_assert_equal( ret, true );
+	t_stdout_read( act, sizeof(act) );
+	t_stdout_reset();
+	mu_assert_string_equal( act, "00000400: 01 02\n" );
+
+	/* the last block grows */
+	t_watch_write( 1026, "\x03", 1 );
+	ret = watch_pass( ctx );
+	mu_assert_equal( ret, true );
+	t_stdout_read( act, sizeof(act) );
+	t_stdout_reset();
+	mu_assert_string_equal( act, "00000400: 01 02 03\n" );
+
+	watch_close( ctx );
+	(void)options_clear( &opt );
+}
+
+/*!
+ * @brief test "bldump --watch=1,2 -l 4 -r 3210 -s 4 -e 12"
+ */
+static void t_watch_main(void)
+{
+	int ret;
+	char* argv[] = { "bldump", "--watch=1,2", "-r", "3210", "-s", "4", "-e", "12", T_WATCH_IN };
+	char act[256];
+
+	t_watch_write( -1, "0123456789abcdef", 16 );
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 0 );
+	t_stdout_read( act, sizeof(act) );
+	t_stdout_reset();
+	mu_assert_string_equal( act, "00000004: 37363534 62613938\n" );
+
+	/* errors */
+	{
+		char* argv[] = { "bldump", "--watch=0", T_WATCH_IN };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--watch", "--npy", T_WATCH_IN, "t-watch.npy" };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv[] = { "bldump", "--watch=1,1", "t-watch.none" };
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+}
+
+void ts_watch(void)
+{
+	/* init */
+	verbose_out = tmpfile();
+	t_stdin  = tmpfile();
+	t_stdout = tmpfile();
+	t_stderr = tmpfile();
+	assert( verbose_out != NULL && t_stdin != NULL && t_stdout != NULL && t_stderr != NULL );
+
+	/* test */
+	mu_run_test(t_watch_pass); // watch_open, watch_pass
+	mu_run_test(t_watch_main); // bldump --watch=1,2 -r 3210 -s 4 -e 12
+
+	/* cleanup */
+	(void)remove( T_WATCH_IN );
+	(void)fclose( verbose_out );
+	(void)fclose( t_stdin );
+	(void)fclose( t_stdout );
+	(void)fclose( t_stderr );
+	verbose_out = NULL;
+	t_stdin = t_stdout = t_stderr = NULL;
+}
@@ -0,0 +1,212 @@
+/*!
+ * @file
+ * @brief unit test of 'where.c'.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "munit.h"
+#include "verbose.h"
+#include "bldump.h"
+
+#define T_WHERE_IN "t-where.in" /*!< bytes of 0 to 255. */
+
+/*!
+ * @brief test "bldump --where=<expr>" of -l, -i, byte[] and addr.
+ */
+static void t_where_fields(void)
+{
+	char act[1024];
+	int ret;
+
+	/* field of -l bytes */
+	{
+		char* argv[] = { "bldump", "-a", "-l", "2", "-f", "4", "-e", "64", "--where=field[1] & 0x10", T_WHERE_IN };
+		t_stdout_reset();
+		(void)main( (int)(sizeof(argv)/sizeof(char*)), argv ); /* stopped at end address */
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act,
+			"00000010: 1011 1213 1415 1617\n"
+			"00000018: 1819 1a1b 1c1d 1e1f\n"
+			"00000030: 3031 3233 3435 3637\n"
+			"00000038: 3839 3a3b 3c3d 3e3f\n" );
+	}
+	/* signed with -i */
+	{
+		char* argv[] = { "bldump", "-i", "-f", "4", "--where=field[0] < -120", T_WHERE_IN };
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act, "-128 -127 -126 -125\n-124 -123 -122 -121\n" );
+	}
+	/* byte[], addr and constants */
+	{
+		char* argv[] = { "bldump", "-a", "-f", "8", "--where=addr >= 0xf8 || !(byte[0] != 2 * (3 + 1))", T_WHERE_IN };
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act,
+			"00000008: 08 09 0a 0b 0c 0d 0e 0f\n"
+			"000000f8: f8 f9 fa fb fc fd fe ff\n" );
+	}
+	/* no space after ']' and ')' */
+	{
+		char* argv[] = { "bldump", "-a", "-f", "8", "--where=byte[0]==0xf8||(addr)<=8&&(addr)!=0", T_WHERE_IN };
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act,
+			"00000008: 08 09 0a 0b 0c 0d 0e 0f\n"
+			"000000f8: f8 f9 fa fb fc fd fe ff\n" );
+	}
+	{
+		char* argv[] = { "bldump", "-a", "-f", "4", "--where=field[0]==0x40<<2>>4", T_WHERE_IN };
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act, "00000010: 10 11 12 13\n" );
+	}
+	/* the last partial row hasn't field[2] */
+	{
+		char* argv[] = { "bldump", "-f", "4", "-s", "250", "--where=field[2] >= 0", T_WHERE_IN };
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act, "fa fb fc fd\n" );
+	}
+}
+
+/*!
+ * @brief test "bldump --where=<expr>" of --bits and --layout.
+ */
+static void t_where_layout(void)
+{
+	char act[1024];
+	int ret;
+
+	/* --bits */
+	{
+		char* argv[] = { "bldump", "-a", "--bits=4", "-f", "4", "--where=field[0] == 0xa && field[3] == 7", T_WHERE_IN };
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act, "000000a6: a 6 a 7\n" );
+	}
+	/* --layout, skip isn't a field */
+	{
+		char* argv[] = { "bldump", "-a", "--layout=u8,skip1,s16le", "--where=field[1] == 0x0706 || field[0] == 0x80", T_WHERE_IN };
+		t_stdout_reset();
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		t_stdout_read( act, sizeof(act) );
+		mu_assert_string_equal( act, "00000004: 4 1798\n00000080: 128 -31870\n" );
+	}
+	/* --stats */
+	{
+		char* argv[] = { "bldump", "-f", "16", "--stats", "--where=field[0] == 0x20", T_WHERE_IN };
+		char err[1024];
+		size_t n;
+		t_stdout_reset();
+		rewind( t_stderr );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 0 );
+		fflush( t_stderr );
+		rewind( t_stderr );
+		n = fread( err, 1, sizeof(err) - 1, t_stderr );
+		err[n] = '\0';
+		mu_assert( strstr( err, "rows       1\n" ) != NULL );
+		mu_assert( strstr( err, "rejected   15\n" ) != NULL );
+	}
+}
+
+/*!
+ * @brief test the errors of --where.
+ */
+static void t_where_error(void)
+{
+	const char* exprs[] = {
+		"field[4]",          /* out of the row */
+		"field[0] <",        /* no operand */
+		"field[0] @ 1",      /* unknown operator */
+		"byte[1",            /* no ']' */
+		"(field[0] == 1",    /* no ')' */
+	};
+	char arg[512];
+	char* argv[] = { "bldump", "-f", "4", arg, T_WHERE_IN };
+	int ret, i;
+
+	for ( i = 0; i < (int)(sizeof(exprs)/sizeof(exprs[0])); i++ ) {
+		(void)snprintf( arg, sizeof(arg), "--where=%s", exprs[i] );
+		ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+		mu_assert_equal( ret, 1 );
+	}
+	/* too deep for the stack */
+	(void)strcpy( arg, "--where=" );
+	for ( i = 0; i < 40; i++ ) {
+		(void)strcat( arg, "byte[0]+(" );
+	}
+	(void)strcat( arg, "1" );
+	for ( i = 0; i < 40; i++ ) {
+		(void)strcat( arg, ")" );
+	}
+	ret = main( (int)(sizeof(argv)/sizeof(char*)), argv );
+	mu_assert_equal( ret, 1 );
+	{
+		char* argv2[] = { "bldump", "--float=f32", "--where=field[0]", T_WHERE_IN };
+		ret = main( (int)(sizeof(argv2)/sizeof(char*)), argv2 );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv2[] = { "bldump", "-l", "16", "--where=field[0]", T_WHERE_IN };
+		ret = main( (int)(sizeof(argv2)/sizeof(char*)), argv2 );
+		mu_assert_equal( ret, 1 );
+	}
+	{
+		char* argv2[] = { "bldump", "--columns", "--where=field[0]", T_WHERE_IN, "t-where.out" };
+		ret = main( (int)(sizeof(argv2)/sizeof(char*)), argv2 );
+		mu_assert_equal( ret, 1 );
+	}
+}
+
+void ts_where(void)
+{
+	FILE* fp;
+	int i;
+
+	/* init */
+	verbose_out = tmpfile();
+	t_stdin  = tmpfile();
+	t_stdout = tmpfile();
+	t_stderr = tmpfile();
+	assert( verbose_out != NULL && t_stdin != NULL && t_stdout != NULL && t_stderr != NULL );
+
+	fp = fopen( T_WHERE_IN, "wb" );
+	assert( fp != NULL );
+	for ( i = 0; i < 256; i++ ) {
+		(void)fputc( i, fp );
+	}
+	fclose( fp );
+
+	/* test */
+	mu_run_test(t_where_fields); // bldump --where=field[1] & 0x10
+	mu_run_test(t_where_layout); // bldump --bits=4 --where=...
+	mu_run_test(t_where_error);  // bldump --where=field[4]
+
+	/* cleanup */
+	(void)remove( T_WHERE_IN );
+	(void)fclose( verbose_out );
+	(void)fclose( t_stdin );
+	(void)fclose( t_stdout );
+	(void)fclose( t_stderr );
+	verbose_out = NULL;
+	t_stdin = t_stdout = t_stderr = NULL;
+}
@@ -0,0 +1,506 @@
+/*!
+ * @file
+ * @brief tee - write the dump to several sinks at once, --out.
+ * @author yukio
+ *
+ * Each --out=<format-options>:<file> is a sink with its own output
+ * options, -a, -d, -i, -u, -b, -A, --npy and --compress, and shares
+ * the input and container options with outfile, so that infile is read
+ * and reordered once by bldump_read() for outfile and all the sinks.
+ *
+ * bldump_dump() pushes each read row into a ring of blocks before it
+ * writes outfile. A block of TEE_BLOCK bytes is handed to the sinks
+ * when it's full, and each sink formats the blocks in order by its own
+ * thread, in parallel with outfile and the other sinks. The block is
+ * filled again after all the sinks have written it, so the slowest
+ * sink bounds the memory by the ring.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "verbose.h"
+#include "bldump.h"
+
+#define TEE_BLOCK (256*1024) /*!< bytes of a block handed to the sinks. */
+#define TEE_SLOTS 4          /*!< blocks in the ring. */
+
+/*** tee_slot_t ***/
+typedef struct {
+	data_t*  data;    /*!< rows at every row_size bytes. */
+	size_t*  address; /*!< address of each row. */
+	size_t*  size;    /*!< valid size of each row. */
+	size_t   rows;    /*!< filled rows. */
+	uint64_t seq;     /*!< number of the block. */
+	int      pending; /*!< sinks which haven't written the block. */
+} tee_slot_t;
+
+/*** tee_sink_t ***/
+typedef struct {
+	tee_t*        tee;
+	char*         name;           /*!< file of the sink. */
+	bool          show_address;   /*!< -a */
+	char*         col_delimitter; /*!< -d, NULL if default. */
+	OUTPUT_TYPE   output_type;    /*!< -i, -u, -b, -A */
+	char*         output_format;
+	bool          npy_output;     /*!< --npy */
+	COMPRESS_TYPE compress;       /*!< --compress */
+	int           compress_level;
+
+	options_t     opt;      /*!< options of outfile with the above. */
+	file_t        outfile;
+	compress_t*   ctx;      /*!< --compress of the sink. */
+	data_t*       row;      /*!< copy of a row for -A, which rewrites it. */
+	pthread_t     thread;
+	bool          started;
+	uint64_t      next;     /*!< block to be written. */
+	bool          failed;
+} tee_sink_t;
+
+/*** tee_t ***/
+struct tee_s {
+	tee_sink_t*     sinks;
+	int             nsinks;
+	tee_slot_t      slots[TEE_SLOTS];
+	size_t          row_size;  /*!< bytes of a row. */
+	size_t          block;     /*!< rows of a block. */
+	uint64_t        seq;       /*!< block being filled. */
+	bool            filling;   /*!< the block of seq is being filled. */
+	bool            started;   /*!< the sinks are running. */
+	pthread_mutex_t lock;
+	pthread_cond_t  filled;    /*!< a block is handed, or stop. */
+	pthread_cond_t  written;   /*!< a sink has written a block. */
+	bool            stop;
+};
+
+/*!
+ * @brief parse the output options of a sink.
+ */
+static bool tee_options( tee_sink_t* s, char* args )
+{
+	char* p = args;
+
+	for (;;) {
+		char* arg;
+		p += strspn( p, " \t" );
+		if ( *p == '\0' ) {
+			break;
+		}
+		arg = p;
+		p += strcspn( p, " \t" );
+		if ( *p != '\0' ) {
+			*p++ = '\0';
+		}
+
+		if ( strcmp( arg, "-a" ) == 0 || strcmp( arg, "--show-address" ) == 0 ) {
+			s->show_address = true;
+		} else if ( strcmp( arg, "-d" ) == 0 || strncmp( arg, "--delimitter=", 13 ) == 0 ) {
+			const char* sub = &arg[13];
+			if ( arg[1] == 'd' ) {
+				p += strspn( p, " \t" );
+				sub = p;
+				p += strcspn( p, " \t" );
+				if ( *p != '\0' ) {
+					*p++ = '\0';
+				}
+			}
+			free( s->col_delimitter );
+			s->col_delimitter = strclone( sub );
+		} else if ( strcmp( arg, "-i" ) == 0 || strcmp( arg, "--decimal" ) == 0 ) {
+			s->output_type   = DECIMAL;
+			s->output_format = "%lld";
+		} else if ( strcmp( arg, "-u" ) == 0 || strcmp( arg, "--unsigned" ) == 0 ) {
+			s->output_type   = UDECIMAL;
+			s->output_format = "%llu";
+		} else if ( strcmp( arg, "-b" ) == 0 || strcmp( arg, "--binary" ) == 0 ) {
+			s->output_type   = BINARY;
+		} else if ( strcmp( arg, "-A" ) == 0 || strcmp( arg, "--ascii" ) == 0 ) {
+			s->output_type   = ASCII;
+			s->output_format = "%c";
+		} else if ( strcmp( arg, "--npy" ) == 0 ) {
+			s->npy_output = true;
+		} else if ( strncmp( arg, "--compress=", 11 ) == 0 ) {
+			if ( compress_parse( &arg[11], &s->compress, &s->compress_level ) == false ) {
+				return false;
+			}
+		} else {
+			(void)verbose_printf( VERB_ERR, "Error: unsupported option of --out - %s\n", arg );
+			return false;
+		}
+	}
+	if ( s->npy_output == true && s->compress != COMPRESS_NONE ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't set opt --compress with --npy of --out.\n" );
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * @brief parse --out and add the sink.
+ *
+ * The spec is '<format-options>:<file>', and the file name follows the
+ * last ':'. The options are separated by spaces.
+ *
+ * @param[out] opt opt->tee is allocated at the first sink.
+ * @param[in] spec --out spec.
+ * @retval true success.
+ * @retval false failure.
+ */
+bool tee_parse( options_t* opt, const char* spec )
+{
+	const char* colon = strrchr( spec, ':' );
+	tee_sink_t* sinks;
+	tee_sink_t* s;
+	char* args;
+	bool is;
+
+	if ( opt->tee == NULL ) {
+		opt->tee = (tee_t*)calloc( 1, sizeof(tee_t) );
+		if ( opt->tee == NULL ) {
+			(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+			return false;
+		}
+	}
+	sinks = (tee_sink_t*)realloc( opt->tee->sinks, sizeof(tee_sink_t) * (size_t)(opt->tee->nsinks + 1) );
+	if ( sinks == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		return false;
+	}
+	opt->tee->sinks = sinks;
+	s = &sinks[opt->tee->nsinks++];
+	memset( s, 0, sizeof(tee_sink_t) );
+	s->output_type   = HEXADECIMAL;
+	s->output_format = "%02x";
+	s->compress      = COMPRESS_NONE;
+	file_reset( &s->outfile );
+
+	s->name = strclone( (colon != NULL) ? &colon[1] : spec );
+	args    = strclone( spec );
+	if ( s->name == NULL || args == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		free( args );
+		return false;
+	}
+	if ( s->name[0] == '\0' ) {
+		(void)verbose_printf( VERB_ERR, "Error: not found file of --out - %s\n", spec );
+		free( args );
+		return false;
+	}
+	args[(colon != NULL) ? (size_t)(colon - spec) : 0] = '\0';
+	is = tee_options( s, args );
+	free( args );
+	return is;
+}
+
+/*!
+ * @brief write a block by the formatter of the sink.
+ */
+static bool tee_write( tee_sink_t* s, const tee_slot_t* slot )
+{
+	memory_t memory;
+	size_t i;
+
+	memory.length = s->tee->row_size;
+	for ( i = 0; i < slot->rows; i++ ) {
+		memory.address = slot->address[i];
+		memory.size    = slot->size[i];
+		memory.data    = &slot->data[i * s->tee->row_size];
+		if ( s->row != NULL ) {
+			memcpy( s->row, memory.data, memory.size );
+			memory.data = s->row;
+		}
+		if ( bldump_write( &memory, &s->outfile, &s->opt ) == false ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*!
+ * @brief thread of a sink : write the blocks in order.
+ */
+static void* tee_worker( void* arg )
+{
+	tee_sink_t* s = (tee_sink_t*)arg;
+	tee_t* t = s->tee;
+
+	(void)pthread_mutex_lock( &t->lock );
+	for (;;) {
+		tee_slot_t* slot = &t->slots[s->next % TEE_SLOTS];
+
+		if ( slot->pending == 0 || slot->seq != s->next ) {
+			if ( t->stop == true && s->next == t->seq ) {
+				break;
+			}
+			(void)pthread_cond_wait( &t->filled, &t->lock );
+			continue;
+		}
+		(void)pthread_mutex_unlock( &t->lock );
+
+		/* a failed sink keeps taking the blocks not to block the others */
+		if ( s->failed == false && tee_write( s, slot ) == false ) {
+			s->failed = true;
+		}
+
+		(void)pthread_mutex_lock( &t->lock );
+		s->next++;
+		slot->pending--;
+		if ( slot->pending == 0 ) {
+			(void)pthread_cond_signal( &t->written );
+		}
+	}
+	(void)pthread_mutex_unlock( &t->lock );
+	return NULL;
+}
+
+/*!
+ * @brief hand the block being filled to the sinks.
+ */
+static void tee_submit( tee_t* t )
+{
+	tee_slot_t* slot = &t->slots[t->seq % TEE_SLOTS];
+
+	(void)pthread_mutex_lock( &t->lock );
+	slot->seq     = t->seq;
+	slot->pending = t->nsinks;
+	t->seq++;
+	(void)pthread_cond_broadcast( &t->filled );
+	(void)pthread_mutex_unlock( &t->lock );
+	t->filling = false;
+}
+
+/*!
+ * @brief stop the threads of the sinks, after the handed blocks are written.
+ */
+static void tee_stop( tee_t* t )
+{
+	int i;
+
+	(void)pthread_mutex_lock( &t->lock );
+	t->stop = true;
+	(void)pthread_cond_broadcast( &t->filled );
+	(void)pthread_mutex_unlock( &t->lock );
+	for ( i = 0; i < t->nsinks; i++ ) {
+		if ( t->sinks[i].started == true ) {
+			(void)pthread_join( t->sinks[i].thread, NULL );
+			t->sinks[i].started = false;
+		}
+	}
+	(void)pthread_mutex_destroy( &t->lock );
+	(void)pthread_cond_destroy( &t->filled );
+	(void)pthread_cond_destroy( &t->written );
+	t->started = false;
+}
+
+/*!
+ * @brief close the files of the sinks, and free the ring.
+ */
+static bool tee_close( tee_t* t )
+{
+	bool is = true;
+	int i;
+
+	for ( i = 0; i < t->nsinks; i++ ) {
+		tee_sink_t* s = &t->sinks[i];
+		if ( s->ctx != NULL && compress_detach( s->ctx, &s->outfile ) == false ) {
+			is = false;
+		}
+		s->ctx = NULL;
+		if ( s->outfile.name != NULL ) { /* opened, or failed to open */
+			(void)file_close( &s->outfile );
+		}
+		free( s->row );
+		s->row = NULL;
+	}
+	for ( i = 0; i < TEE_SLOTS; i++ ) {
+		free( t->slots[i].data );
+		free( t->slots[i].address );
+		free( t->slots[i].size );
+		memset( &t->slots[i], 0, sizeof(tee_slot_t) );
+	}
+	return is;
+}
+
+/*!
+ * @brief open the files of the sinks, and start their threads.
+ * @param[in,out] tee sinks of --out.
+ * @param[in] opt options shared by the sinks.
+ * @param[in] row_size bytes of a row read by bldump_read().
+ * @retval true success.
+ * @retval false failure.
+ */
+bool tee_start( tee_t* tee, const options_t* opt, size_t row_size )
+{
+	bool is = true;
+	int i;
+
+	tee->row_size = row_size;
+	tee->block    = (row_size < TEE_BLOCK) ? TEE_BLOCK / row_size : 1;
+	tee->seq      = 0;
+	tee->filling  = false;
+	tee->stop     = false;
+	for ( i = 0; is == true && i < TEE_SLOTS; i++ ) {
+		tee_slot_t* slot = &tee->slots[i];
+		slot->data    = (data_t*)malloc( tee->block * row_size );
+		slot->address = (size_t*)malloc( sizeof(size_t) * tee->block );
+		slot->size    = (size_t*)malloc( sizeof(size_t) * tee->block );
+		is = slot->data != NULL && slot->address != NULL && slot->size != NULL;
+	}
+	if ( is == false ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+	}
+
+	for ( i = 0; is == true && i < tee->nsinks; i++ ) {
+		tee_sink_t* s = &tee->sinks[i];
+
+		s->tee    = tee;
+		s->next   = 0;
+		s->failed = false;
+		s->opt    = *opt; /* shares the input and container options */
+		s->opt.show_address  = s->show_address;
+		s->opt.output_type   = s->output_type;
+		s->opt.output_format = s->output_format;
+		s->opt.npy_output    = s->npy_output;
+		s->opt.compress      = s->compress;
+		s->opt.compress_level = s->compress_level;
+		s->opt.outfile_name  = s->name;
+		s->opt.stats         = NULL;
+		s->opt.tee           = NULL;
+		if ( s->col_delimitter != NULL ) {
+			s->opt.col_delimitter = s->col_delimitter;
+		}
+		if ( s->npy_output == true && opt->data_bits > 0 ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't set opt --npy of --out with --bits.\n" );
+			is = false;
+			break;
+		}
+		if ( file_open( &s->outfile, s->name, "wb" ) == false ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't open outfile - %s\n", s->name );
+			is = false;
+			break;
+		}
+		if ( s->compress != COMPRESS_NONE ) {
+			s->ctx = compress_attach( &s->opt, &s->outfile );
+			is = (s->ctx != NULL);
+		}
+		if ( is == true && s->output_type == ASCII ) {
+			s->row = (data_t*)malloc( row_size );
+			if ( s->row == NULL ) {
+				(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+				is = false;
+			}
+		}
+	}
+	if ( is == false ) {
+		(void)tee_close( tee );
+		return false;
+	}
+
+	(void)pthread_mutex_init( &tee->lock, NULL );
+	(void)pthread_cond_init( &tee->filled, NULL );
+	(void)pthread_cond_init( &tee->written, NULL );
+	tee->started = true;
+	for ( i = 0; i < tee->nsinks; i++ ) {
+		if ( pthread_create( &tee->sinks[i].thread, NULL, tee_worker, &tee->sinks[i] ) != 0 ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't create thread\n" );
+			tee_stop( tee );
+			(void)tee_close( tee );
+			return false;
+		}
+		tee->sinks[i].started = true;
+	}
+	(void)verbose_printf( VERB_LOG, "bldump: tee - %d sinks, %d rows a block\n", tee->nsinks, (int)tee->block );
+	return true;
+}
+
+/*!
+ * @brief push a row read by bldump_read() to the sinks.
+ *
+ * The row is copied into the block being filled, and the block is
+ * handed to the sinks when it's full.
+ *
+ * A failure of a sink is reported by tee_finish().
+ *
+ * @param[in,out] tee
+ * @param[in] memory read row, before it's written to outfile.
+ */
+void tee_push( tee_t* tee, const memory_t* memory )
+{
+	tee_slot_t* slot = &tee->slots[tee->seq % TEE_SLOTS];
+
+	if ( tee->filling == false ) {
+		/* wait until the sinks have written the block of seq - TEE_SLOTS */
+		(void)pthread_mutex_lock( &tee->lock );
+		while ( slot->pending > 0 ) {
+			(void)pthread_cond_wait( &tee->written, &tee->lock );
+		}
+		(void)pthread_mutex_unlock( &tee->lock );
+		slot->rows   = 0;
+		tee->filling = true;
+	}
+	memcpy( &slot->data[slot->rows * tee->row_size], memory->data, memory->size );
+	slot->address[slot->rows] = memory->address;
+	slot->size[slot->rows]    = memory->size;
+	slot->rows++;
+	if ( slot->rows == tee->block ) {
+		tee_submit( tee );
+	}
+}
+
+/*!
+ * @brief write the rest of the rows, and finish and close the sinks.
+ * @param[in,out] tee
+ * @retval true success.
+ * @retval false a sink failed.
+ */
+bool tee_finish( tee_t* tee )
+{
+	bool is = true;
+	int i;
+
+	if ( tee->started == false ) {
+		return true;
+	}
+	if ( tee->filling == true && tee->slots[tee->seq % TEE_SLOTS].rows > 0 ) {
+		tee_submit( tee );
+	}
+	tee_stop( tee );
+	for ( i = 0; i < tee->nsinks; i++ ) {
+		tee_sink_t* s = &tee->sinks[i];
+		if ( s->failed == false ) {
+			s->failed = bldump_finish( NULL, &s->outfile, &s->opt ) == false
+				|| fflush( s->outfile.ptr ) != 0;
+		}
+		if ( s->failed == true ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't write outfile - %s\n", s->name );
+			is = false;
+		}
+	}
+	if ( tee_close( tee ) == false ) {
+		is = false;
+	}
+	return is;
+}
+
+/*!
+ * @brief free the sinks of --out.
+ */
+void tee_free( tee_t* tee )
+{
+	int i;
+
+	if ( tee->started == true ) {
+		tee_stop( tee );
+	}
+	(void)tee_close( tee );
+	for ( i = 0; i < tee->nsinks; i++ ) {
+		free( tee->sinks[i].name );
+		free( tee->sinks[i].col_delimitter );
+	}
+	free( tee->sinks );
+	free( tee );
+}
@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 
 #ifdef TEST
 void t_exit(int);
@@ -30,6 +31,67 @@ unsigned int verbose_level = VERB_DEFAULT;
  */
 FILE* verbose_out = NULL;
 
+/*!
+ * @brief verbosity of the thread, NULL for verbose_level and verbose_out.
+ */
+__thread const verbose_t* verbose_local = NULL;
+
+/*!
+ * @brief slot of the trace ring buffer.
+ */
+typedef struct {
+	unsigned long seq;                /*!< index + 1 of the message, 0 if empty. */
+	char text[VERBOSE_RING_TEXT];     /*!< message. */
+} verbose_slot_t;
+
+static verbose_slot_t verbose_ring[VERBOSE_RING_SIZE]; /*!< trace ring buffer. */
+static unsigned long verbose_ring_head = 0;  /*!< index of the next message. */
+static unsigned long verbose_ring_tail = 0;  /*!< index of the first message not dumped. */
+static int           verbose_ring_exit = 0;  /*!< 1 if dump at exit is registered. */
+
+/*!
+ * @brief store a trace message to the ring buffer.
+ *
+ * Writers take a slot by an atomic increment, and don't wait for each
+ * other. Only the last VERBOSE_RING_SIZE messages are kept.
+ */
+static int verbose_ring_vprintf( const char *fmt, va_list ap )
+{
+	unsigned long index = __atomic_fetch_add( &verbose_ring_head, 1, __ATOMIC_RELAXED );
+	verbose_slot_t* slot = &verbose_ring[index & (VERBOSE_RING_SIZE - 1)];
+	int ret;
+
+	if ( __atomic_exchange_n( &verbose_ring_exit, 1, __ATOMIC_RELAXED ) == 0 ) {
+		(void)atexit( verbose_ring_dump );
+	}
+	__atomic_store_n( &slot->seq, 0, __ATOMIC_RELAXED );
+	ret = vsnprintf( slot->text, sizeof(slot->text), fmt, ap );
+	__atomic_store_n( &slot->seq, index + 1, __ATOMIC_RELEASE );
+	return ret;
+}
+
+/*!
+ * @brief output the trace messages in the ring buffer to verbose_out.
+ *
+ * Called at exit, and the messages are dumped only once.
+ */
+void verbose_ring_dump( void )
+{
+	unsigned long head = __atomic_load_n( &verbose_ring_head, __ATOMIC_ACQUIRE );
+	unsigned long i = verbose_ring_tail;
+
+	if ( head - i > VERBOSE_RING_SIZE ) {
+		i = head - VERBOSE_RING_SIZE;
+	}
+	for ( ; i < head; i++ ) {
+		verbose_slot_t* slot = &verbose_ring[i & (VERBOSE_RING_SIZE - 1)];
+		if ( __atomic_load_n( &slot->seq, __ATOMIC_ACQUIRE ) == i + 1 && verbose_out != NULL ) {
+			(void)fputs( slot->text, verbose_out );
+		}
+	}
+	verbose_ring_tail = head;
+}
+
 /*!
  * @brief verbose vprintf.
  * @param[in] level effective level.
@@ -38,19 +100,40 @@ FILE* verbose_out = NULL;
  */
 static int verbose_vprintf( unsigned int level, const char *fmt, va_list ap ) 
 {
+	const verbose_t* local = verbose_local;
+	FILE* out = (local != NULL) ? local->out : verbose_out;
 	int ret=0;
-	if ( verbose_level >= level && verbose_out != NULL ) {
-		ret=vfprintf( verbose_out, fmt, ap );
+	if ( ((local != NULL) ? local->level : verbose_level) >= level && out != NULL ) {
+		if ( level >= VERB_TRACE ) {
+			ret=verbose_ring_vprintf( fmt, ap );
+		} else {
+			ret=vfprintf( out, fmt, ap );
+		}
 	}
 	return ret;
 }
 
+/*!
+ * @brief set the verbosity of the calling thread.
+ * @param[in] local verbosity, NULL for verbose_level and verbose_out.
+ * @return the previous one, to be set back.
+ */
+const verbose_t* verbose_scope( const verbose_t* local )
+{
+	const verbose_t* prev = verbose_local;
+	verbose_local = local;
+	return prev;
+}
+
 /*!
  * @brief verbose printf.
+ *
+ * Called by the verbose_printf() macro if the level is effective,
+ * the trace level is stored to the ring buffer dumped at exit.
  * @param[in] level output level.
  * @param[in] fmt   output format.
  */
-int verbose_printf( unsigned int level, const char *fmt, ... ) 
+int (verbose_printf)( unsigned int level, const char *fmt, ... ) 
 {
 	int ret;
 	va_list ap;
@@ -31,11 +31,54 @@ enum verbose_level_t {
 	VERB_TRACE   = 9  /*!< trace. */
 };
 
+/*!
+ * @brief the most verbose level compiled in.
+ * verbose_printf() of the upper levels are removed by the compiler,
+ * e.g. -DVERBOSE_MAX=VERB_DEBUG strips the trace messages.
+ */
+#ifndef VERBOSE_MAX
+#define VERBOSE_MAX VERB_TRACE
+#endif
+
+#define VERBOSE_RING_SIZE 1024 /*!< slots of the trace ring buffer, power of 2. */
+#define VERBOSE_RING_TEXT 120  /*!< max length of a trace message. */
+
 extern unsigned int   verbose_level;
 extern /*@null@*/FILE* verbose_out;
 
+/*!
+ * @brief verbosity of a context, e.g. a stream of the library.
+ * It's used instead of verbose_level and verbose_out by the thread
+ * while set by verbose_scope().
+ */
+typedef struct {
+	unsigned int     level;
+	/*@null@*/FILE*  out;
+} verbose_t;
+
+extern __thread const verbose_t* verbose_local;
+
 extern int   verbose_printf( unsigned int level, const char *fmt, ... );
 extern int   verbose_die( const char* fmt, ... );
+extern void  verbose_ring_dump( void );
+extern const verbose_t* verbose_scope( const verbose_t* local );
+
+/*!
+ * @brief check the level is compiled in and effective.
+ */
+static inline int verbose_effective( unsigned int level )
+{
+	return level <= (unsigned int)VERBOSE_MAX
+		&& level <= ((verbose_local != NULL) ? verbose_local->level : verbose_level);
+}
+
+/*!
+ * @brief verbose printf, the level is checked at the call site.
+ * The arguments aren't evaluated unless the level is effective.
+ */
+#define verbose_printf(level, ...) \
+	( verbose_effective( (unsigned int)(level) ) \
+		? (verbose_printf)( (level), __VA_ARGS__ ) : 0 )
 
 #ifdef CUNIT
 extern int t_exit_count;
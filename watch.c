@@ -0,0 +1,287 @@
+/*!
+ * @file
+ * @brief watch - dump the rows changed since the last pass, --watch.
+ * @author yukio
+ *
+ * The infile is read by every interval, and a hash of each block of
+ * rows is kept from the last pass. The first pass dumps all the rows,
+ * and the following passes dump the rows of the blocks whose hash
+ * changed, with the address. Formatting the rows costs much more than
+ * reading and hashing, so that the time of a pass is mostly of the
+ * changed blocks.
+ *
+ * The file is read by pread() every pass rather than by the mtime or
+ * inotify, which don't see the writes to a shared mapping or the
+ * registers of a device file.
+ *
+ * @code
+ * ctx = watch_open( &opt );
+ * while ( watch_pass( ctx ) == true ) sleep( 1 );
+ * watch_close( ctx );
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "verbose.h"
+#include "bldump.h"
+
+/*** TEST ***/
+#ifdef TEST
+#define STDOUT	t_stdout
+#else
+#define STDOUT	stdout
+#endif
+
+#define WATCH_BLOCK 64      /*!< bytes of a hashed block, rounded up to rows. */
+#define WATCH_READ  1048576 /*!< reading size. */
+
+/*** watch_t ***/
+struct watch_s {
+	options_t opt;      /*!< copy of options with -a. */
+	int       fd;       /*!< infile. */
+	file_t    outfile;
+	memory_t  memory;   /*!< a row to write. */
+	data_t*   buf;      /*!< read blocks. */
+	size_t    length;   /*!< size of buf, multiple of block. */
+	size_t    row;      /*!< bytes of a row. */
+	size_t    block;    /*!< bytes of a hashed block. */
+	uint64_t* hash;     /*!< hash of each block of the last pass. */
+	size_t    nhash;    /*!< valid blocks of the last pass. */
+	size_t    capacity; /*!< allocated hash. */
+	unsigned long rows; /*!< rows written by the last pass. */
+};
+
+/*!
+ * @brief hash of a block, 8 bytes at a time.
+ */
+static uint64_t watch_hash( const data_t* p, size_t n )
+{
+	uint64_t h = 0x9e3779b97f4a7c15uLL ^ (uint64_t)n;
+	uint64_t v;
+
+	for ( ; n >= 8; n -= 8, p += 8 ) {
+		memcpy( &v, p, 8 );
+		h = (h ^ v) * 0xff51afd7ed558ccduLL;
+		h ^= h >> 32;
+	}
+	for ( ; n > 0; n--, p++ ) {
+		h = (h ^ *p) * 0xc4ceb9fe1a85ec53uLL;
+	}
+	return h ^ (h >> 29);
+}
+
+/*!
+ * @brief open a watch of infile.
+ * @param[in] opt options, must be kept until watch_close().
+ * @return context, or NULL on failure.
+ */
+watch_t* watch_open( const options_t* opt )
+{
+	watch_t* ctx = (watch_t*)calloc( 1, sizeof(watch_t) );
+
+	if ( ctx == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		return NULL;
+	}
+	ctx->opt = *opt;
+	ctx->opt.show_address = true;
+	ctx->fd  = -1;
+	memory_init( &ctx->memory );
+	file_reset( &ctx->outfile );
+
+	ctx->row = bldump_record_size( &ctx->opt );
+	if ( ctx->row == 0 ) {
+		watch_close( ctx );
+		return NULL;
+	}
+	ctx->block  = (WATCH_BLOCK > ctx->row) ? ctx->row * ((WATCH_BLOCK + ctx->row - 1) / ctx->row) : ctx->row;
+	ctx->length = (WATCH_READ > ctx->block) ? ctx->block * (WATCH_READ / ctx->block) : ctx->block;
+	ctx->buf    = (data_t*)malloc( ctx->length );
+	if ( ctx->buf == NULL || memory_allocate( &ctx->memory, ctx->row ) == false ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		watch_close( ctx );
+		return NULL;
+	}
+
+	ctx->fd = open( opt->infile_name, O_RDONLY );
+	if ( ctx->fd < 0 ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't open infile - %s\n", opt->infile_name );
+		watch_close( ctx );
+		return NULL;
+	}
+	if ( opt->outfile_name == NULL ) {
+		ctx->outfile.ptr = STDOUT;
+	} else if ( file_open( &ctx->outfile, opt->outfile_name, "wb" ) == false ) {
+		(void)verbose_printf( VERB_ERR, "Error: can't open outfile - %s\n", opt->outfile_name );
+		watch_close( ctx );
+		return NULL;
+	}
+	return ctx;
+}
+
+/*!
+ * @brief read up to size bytes at the address.
+ * @return read bytes, less than size at the end of file.
+ */
+static size_t watch_read( watch_t* ctx, size_t address, size_t size, bool* is_ok )
+{
+	size_t done = 0;
+
+	while ( done < size ) {
+		ssize_t n = pread( ctx->fd, &ctx->buf[done], size - done, (off_t)(address + done) );
+		if ( n < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( n < 0 ) {
+			(void)verbose_printf( VERB_ERR, "Error: can't read infile - %s\n", ctx->opt.infile_name );
+			*is_ok = false;
+		}
+		if ( n <= 0 ) {
+			break;
+		}
+		done += (size_t)n;
+	}
+	return done;
+}
+
+/*!
+ * @brief write the rows of a block.
+ */
+static bool watch_rows( watch_t* ctx, size_t address, const data_t* p, size_t size )
+{
+	memory_t* memory = &ctx->memory;
+	size_t i, n;
+	bool is = true;
+
+	for ( i = 0; i < size && is == true; i += n ) {
+		n = (size - i < ctx->row) ? size - i : ctx->row;
+		memcpy( memory->data, &p[i], n );
+		memory->address = address + i;
+		memory->size    = n;
+		memory_reorder( memory, &ctx->opt );
+		if ( ctx->opt.where != NULL && where_match( ctx->opt.where, memory ) == false ) {
+			continue; /* rejected by --where */
+		}
+		is = bldump_write( memory, &ctx->outfile, &ctx->opt );
+		ctx->rows++;
+	}
+	return is;
+}
+
+/*!
+ * @brief read infile, and write the rows of the changed blocks.
+ * @param[in,out] ctx
+ * @retval true success.
+ * @retval false failure of reading or writing.
+ */
+bool watch_pass( watch_t* ctx )
+{
+	size_t address = ctx->opt.start_address;
+	size_t end = ctx->opt.end_address;
+	size_t idx = 0;
+	bool is_ok = true;
+
+	ctx->rows = 0;
+	while ( is_ok == true && (end == 0 || address < end) ) {
+		size_t want = ctx->length;
+		size_t size, i;
+
+		if ( end != 0 && end - address < want ) {
+			want = end - address;
+		}
+		size = watch_read( ctx, address, want, &is_ok );
+
+		for ( i = 0; i < size && is_ok == true; i += ctx->block, idx++ ) {
+			size_t n = (size - i < ctx->block) ? size - i : ctx->block;
+			uint64_t h = watch_hash( &ctx->buf[i], n );
+
+			if ( idx >= ctx->capacity ) {
+				size_t capacity = (ctx->capacity > 0) ? ctx->capacity * 2 : 1024;
+				uint64_t* hash = (uint64_t*)realloc( ctx->hash, sizeof(uint64_t) * capacity );
+				if ( hash == NULL ) {
+					(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+					is_ok = false;
+					break;
+				}
+				ctx->hash     = hash;
+				ctx->capacity = capacity;
+			}
+			if ( idx >= ctx->nhash || ctx->hash[idx] != h ) {
+				ctx->hash[idx] = h;
+				is_ok = watch_rows( ctx, address + i, &ctx->buf[i], n );
+			}
+		}
+		address += size;
+		if ( size < want ) {
+			break;
+		}
+	}
+	if ( idx < ctx->nhash ) {
+		(void)verbose_printf( VERB_LOG, "bldump: watch - infile is shorter, %lu\n", (unsigned long)address );
+	}
+	ctx->nhash = idx;
+	(void)verbose_printf( VERB_DEBUG, "bldump: watch - %lu rows\n", ctx->rows );
+
+	if ( fflush( ctx->outfile.ptr ) != 0 ) {
+		is_ok = false;
+	}
+	return is_ok;
+}
+
+/*!
+ * @brief close a watch.
+ */
+void watch_close( watch_t* ctx )
+{
+	if ( ctx->fd >= 0 ) {
+		(void)close( ctx->fd );
+	}
+	if ( ctx->outfile.ptr != NULL ) {
+		(void)file_close( &ctx->outfile );
+	}
+	if ( ctx->memory.data != NULL ) {
+		(void)memory_free( &ctx->memory );
+	}
+	free( ctx->buf );
+	free( ctx->hash );
+	free( ctx );
+}
+
+/*!
+ * @brief --watch=<ms>[,<passes>] : dump the changed rows by every interval.
+ * @param[in] opt
+ * @retval true success, after the passes.
+ * @retval false failure.
+ */
+bool bldump_watch( options_t* opt )
+{
+	watch_t* ctx = watch_open( opt );
+	unsigned long pass;
+	bool is_ok;
+
+	if ( ctx == NULL ) {
+		return false;
+	}
+	for ( pass = 1; ; pass++ ) {
+		struct timespec ts;
+		is_ok = watch_pass( ctx );
+		if ( is_ok == false || (opt->watch_passes > 0 && pass >= opt->watch_passes) ) {
+			break;
+		}
+		ts.tv_sec  = (time_t)(opt->watch_interval / 1000);
+		ts.tv_nsec = (long)(opt->watch_interval % 1000) * 1000000L;
+		while ( nanosleep( &ts, &ts ) != 0 && errno == EINTR ) {
+		}
+	}
+	watch_close( ctx );
+	return is_ok;
+}
@@ -0,0 +1,506 @@
+/*!
+ * @file
+ * @brief where - filter the rows by a predicate, --where.
+ * @author yukio
+ *
+ * where_compile() compiles the expression of --where once, in
+ * options_load(), into a program of a stack machine, and where_match()
+ * runs it on each row read by bldump_read(), so that a rejected row
+ * isn't formatted at all.
+ *
+ * The expression is of C with 64 bit signed integers:
+ *
+ * - field[<n>] : n-th value of the row as it's displayed, the value of
+ *                -l bytes, of --bits or of a --layout field, signed
+ *                with -i or a signed field.
+ * - byte[<n>]  : n-th byte of the row, after -r.
+ * - addr       : address of the row.
+ * - numbers in decimal, 0x hex or 0 octal, and ( ).
+ * - operators  : ! ~ - * / % + - << >> < <= > >= == != & ^ | && ||
+ *
+ * A row without the field or the byte, as the last partial row, doesn't
+ * match. Division by zero is 0. Constant parts are folded in compiling.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#include "verbose.h"
+#include "bldump.h"
+
+#define WHERE_STACK 32 /*!< depth of the stack machine. */
+
+typedef enum {
+	OP_CONST = 0, OP_FIELD, OP_BYTE, OP_ADDR,
+	OP_NEG, OP_NOT, OP_INV,
+	OP_MUL, OP_DIV, OP_MOD, OP_ADD, OP_SUB, OP_SHL, OP_SHR,
+	OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE,
+	OP_AND, OP_XOR, OP_OR, OP_LAND, OP_LOR
+} WHERE_OP;
+
+/*** where_code_t ***/
+typedef struct {
+	WHERE_OP op;
+	int64_t  value; /*!< OP_CONST : constant, OP_FIELD : index of fields, OP_BYTE : offset. */
+} where_code_t;
+
+/*** where_field_t ***/
+typedef struct {
+	size_t offset; /*!< byte offset in the row, or index of --bits. */
+	size_t size;   /*!< bytes of the value. */
+	int    shift;  /*!< bits to extend the sign, 0 if unsigned. */
+	uint64_t (*decode)( const data_t* data ); /*!< --layout, NULL if big endian of size. */
+} where_field_t;
+
+/*** where_t ***/
+struct where_s {
+	where_code_t*  code;
+	int            ncode;
+	where_field_t* fields;
+	int            nfields;
+	unsigned int   data_bits; /*!< --bits, 0 if off. */
+	bool           lsb_first;
+};
+
+/*** parser ***/
+typedef struct {
+	const char*      expr;
+	const char*      p;   /*!< next character. */
+	where_t*         w;
+	const options_t* opt;
+	int              depth; /*!< stack depth of the compiled code. */
+	bool             is;    /*!< no error. */
+} where_parser_t;
+
+static void where_expr( where_parser_t* ps );
+static bool where_eval( const where_code_t* code, int ncode, const where_t* w, const memory_t* memory, int64_t* result );
+
+/*!
+ * @brief report an error at the current position.
+ */
+static void where_error( where_parser_t* ps, const char* what )
+{
+	if ( ps->is == true ) {
+		(void)verbose_printf( VERB_ERR, "Error: %s of --where at %d - %s\n", what, (int)(ps->p - ps->expr) + 1, ps->expr );
+	}
+	ps->is = false;
+}
+
+static void where_space( where_parser_t* ps )
+{
+	while ( isspace( (unsigned char)*ps->p ) != 0 ) {
+		ps->p++;
+	}
+}
+
+/*!
+ * @brief skip the token if it's next.
+ */
+static bool where_token( where_parser_t* ps, const char* token )
+{
+	size_t n = strlen( token );
+	where_space( ps );
+	if ( strncmp( ps->p, token, n ) != 0 ) {
+		return false;
+	}
+	/* '<' isn't '<<' or '<=', '&' isn't '&&', but ']' or ')' is before any */
+	if ( n == 1 && strchr( "<>&|=!", ps->p[0] ) != NULL
+		&& ps->p[1] != '\0' && strchr( "<>&|=", ps->p[1] ) != NULL
+		&& (ps->p[1] == ps->p[0] || ps->p[1] == '=') ) {
+		return false;
+	}
+	ps->p += n;
+	return true;
+}
+
+/*!
+ * @brief append a code, folding the operation of constants.
+ */
+static void where_emit( where_parser_t* ps, WHERE_OP op, int64_t value )
+{
+	where_t* w = ps->w;
+	where_code_t* code;
+
+	if ( ps->is == false ) {
+		return;
+	}
+	if ( op >= OP_NEG && op <= OP_INV && w->ncode >= 1 && w->code[w->ncode - 1].op == OP_CONST ) {
+		where_code_t c[2];
+		c[0] = w->code[w->ncode - 1];
+		c[1].op = op;
+		c[1].value = 0;
+		w->ncode--;
+		(void)where_eval( c, 2, NULL, NULL, &value );
+		op = OP_CONST;
+	} else if ( op >= OP_MUL && w->ncode >= 2 && w->code[w->ncode - 1].op == OP_CONST
+		&& w->code[w->ncode - 2].op == OP_CONST ) {
+		where_code_t c[3];
+		c[0] = w->code[w->ncode - 2];
+		c[1] = w->code[w->ncode - 1];
+		c[2].op = op;
+		c[2].value = 0;
+		w->ncode -= 2;
+		ps->depth--;
+		(void)where_eval( c, 3, NULL, NULL, &value );
+		op = OP_CONST;
+	} else if ( op >= OP_MUL ) {
+		ps->depth--;
+	} else if ( op < OP_NEG && ++ps->depth > WHERE_STACK ) {
+		where_error( ps, "too deep expression" );
+		return;
+	}
+
+	code = (where_code_t*)realloc( w->code, sizeof(where_code_t) * (size_t)(w->ncode + 1) );
+	if ( code == NULL ) {
+		where_error( ps, "memory allocation failure" );
+		return;
+	}
+	w->code = code;
+	w->code[w->ncode].op    = op;
+	w->code[w->ncode].value = value;
+	w->ncode++;
+}
+
+/*!
+ * @brief add the n-th value of the row to the fields.
+ * @return index of the fields, -1 on failure.
+ */
+static int where_field( where_parser_t* ps, unsigned long n )
+{
+	const options_t* opt = ps->opt;
+	where_t* w = ps->w;
+	where_field_t* fields;
+	where_field_t f;
+
+	if ( ps->is == false ) {
+		return -1;
+	}
+	memset( &f, 0, sizeof(f) );
+	if ( opt->data_bits > 0 ) {
+		if ( n >= (unsigned long)opt->data_fields ) {
+			where_error( ps, "field out of the row" );
+			return -1;
+		}
+		f.offset = (size_t)n;
+	} else if ( opt->layout != NULL ) {
+		int k, values = 0;
+		for ( k = 0; k < opt->layout_fields; k++ ) {
+			values += (opt->layout[k].type != FIELD_SKIP) ? 1 : 0;
+		}
+		if ( values == 0 || n >= (unsigned long)values * (unsigned long)opt->data_fields ) {
+			where_error( ps, "field out of the row" );
+			return -1;
+		}
+		f.offset = (n / (unsigned long)values) * opt->data_length;
+		n %= (unsigned long)values;
+		for ( k = 0; k < opt->layout_fields; k++ ) {
+			const field_t* field = &opt->layout[k];
+			if ( field->type == FIELD_SKIP || n-- > 0 ) {
+				continue;
+			}
+			if ( field->type == FIELD_FLOAT ) {
+				where_error( ps, "float field" );
+				return -1;
+			}
+			f.offset += field->offset;
+			f.size    = field->size;
+			f.decode  = field->decode;
+			f.shift   = (field->type == FIELD_SIGNED) ? (int)(8 - field->size) * 8 : 0;
+			break;
+		}
+	} else {
+		if ( opt->output_type == FLOAT16 || opt->output_type == FLOAT32 || opt->output_type == FLOAT64 ) {
+			where_error( ps, "float field" );
+			return -1;
+		}
+		if ( opt->data_length > 8 ) {
+			where_error( ps, "field wider than 8 bytes" );
+			return -1;
+		}
+		if ( n >= (unsigned long)opt->data_fields ) {
+			where_error( ps, "field out of the row" );
+			return -1;
+		}
+		f.offset = (size_t)n * opt->data_length;
+		f.size   = opt->data_length;
+		f.shift  = (opt->output_type == DECIMAL) ? (int)(8 - f.size) * 8 : 0;
+	}
+
+	fields = (where_field_t*)realloc( w->fields, sizeof(where_field_t) * (size_t)(w->nfields + 1) );
+	if ( fields == NULL ) {
+		where_error( ps, "memory allocation failure" );
+		return -1;
+	}
+	w->fields = fields;
+	w->fields[w->nfields] = f;
+	return w->nfields++;
+}
+
+/*!
+ * @brief index and ']' of field[ and byte[.
+ */
+static unsigned long where_index( where_parser_t* ps )
+{
+	unsigned long n;
+	char* tail;
+
+	where_space( ps );
+	n = strtoul( ps->p, &tail, 0 );
+	if ( tail == ps->p ) {
+		where_error( ps, "wrong index" );
+		return 0;
+	}
+	ps->p = tail;
+	if ( where_token( ps, "]" ) == false ) {
+		where_error( ps, "not found ']'" );
+	}
+	return n;
+}
+
+/*!
+ * @brief primary : number, field[n], byte[n], addr or ( expr ).
+ */
+static void where_primary( where_parser_t* ps )
+{
+	char* tail;
+
+	where_space( ps );
+	if ( isdigit( (unsigned char)*ps->p ) != 0 ) {
+		int64_t value = (int64_t)strtoull( ps->p, &tail, 0 );
+		ps->p = tail;
+		where_emit( ps, OP_CONST, value );
+	} else if ( where_token( ps, "field[" ) == true ) {
+		int index = where_field( ps, where_index( ps ) );
+		if ( index >= 0 ) {
+			where_emit( ps, OP_FIELD, (int64_t)index );
+		}
+	} else if ( where_token( ps, "byte[" ) == true ) {
+		unsigned long n = where_index( ps );
+		where_emit( ps, OP_BYTE, (int64_t)n );
+	} else if ( where_token( ps, "addr" ) == true ) {
+		where_emit( ps, OP_ADDR, 0 );
+	} else if ( where_token( ps, "(" ) == true ) {
+		where_expr( ps );
+		if ( where_token( ps, ")" ) == false ) {
+			where_error( ps, "not found ')'" );
+		}
+	} else {
+		where_error( ps, "wrong expression" );
+	}
+}
+
+static void where_unary( where_parser_t* ps )
+{
+	if ( where_token( ps, "!" ) == true ) {
+		where_unary( ps );
+		where_emit( ps, OP_NOT, 0 );
+	} else if ( where_token( ps, "~" ) == true ) {
+		where_unary( ps );
+		where_emit( ps, OP_INV, 0 );
+	} else if ( where_token( ps, "-" ) == true ) {
+		where_unary( ps );
+		where_emit( ps, OP_NEG, 0 );
+	} else {
+		where_primary( ps );
+	}
+}
+
+/*** binary operators in order of precedence ***/
+typedef struct {
+	const char* token;
+	WHERE_OP    op;
+} where_binary_t;
+
+static const where_binary_t where_levels[][5] = {
+	{ { "||", OP_LOR }, { NULL, OP_CONST } },
+	{ { "&&", OP_LAND }, { NULL, OP_CONST } },
+	{ { "|", OP_OR }, { NULL, OP_CONST } },
+	{ { "^", OP_XOR }, { NULL, OP_CONST } },
+	{ { "&", OP_AND }, { NULL, OP_CONST } },
+	{ { "==", OP_EQ }, { "!=", OP_NE }, { NULL, OP_CONST } },
+	{ { "<=", OP_LE }, { ">=", OP_GE }, { "<", OP_LT }, { ">", OP_GT }, { NULL, OP_CONST } },
+	{ { "<<", OP_SHL }, { ">>", OP_SHR }, { NULL, OP_CONST } },
+	{ { "+", OP_ADD }, { "-", OP_SUB }, { NULL, OP_CONST } },
+	{ { "*", OP_MUL }, { "/", OP_DIV }, { "%", OP_MOD }, { NULL, OP_CONST } },
+};
+#define WHERE_LEVELS ((int)(sizeof(where_levels)/sizeof(where_levels[0])))
+
+/*!
+ * @brief left associative operators of the level, and higher.
+ */
+static void where_binary( where_parser_t* ps, int level )
+{
+	if ( level >= WHERE_LEVELS ) {
+		where_unary( ps );
+		return;
+	}
+	where_binary( ps, level + 1 );
+	while ( ps->is == true ) {
+		const where_binary_t* b;
+		for ( b = where_levels[level]; b->token != NULL; b++ ) {
+			if ( where_token( ps, b->token ) == true ) {
+				break;
+			}
+		}
+		if ( b->token == NULL ) {
+			break;
+		}
+		where_binary( ps, level + 1 );
+		where_emit( ps, b->op, 0 );
+	}
+}
+
+static void where_expr( where_parser_t* ps )
+{
+	where_binary( ps, 0 );
+}
+
+/*!
+ * @brief run the program on a row.
+ * @param[in] code program.
+ * @param[in] ncode number of the codes.
+ * @param[in] w fields of OP_FIELD, NULL if the program is constant.
+ * @param[in] memory row, NULL if the program is constant.
+ * @param[out] result value on the top of the stack.
+ * @retval true success.
+ * @retval false the row doesn't have the field or the byte.
+ */
+static bool where_eval( const where_code_t* code, int ncode, const where_t* w, const memory_t* memory, int64_t* result )
+{
+	int64_t stack[WHERE_STACK];
+	int sp = 0;
+	int i;
+
+	for ( i = 0; i < ncode; i++ ) {
+		const where_code_t* c = &code[i];
+		int64_t l = (sp >= 2) ? stack[sp - 2] : 0;
+		int64_t r = (sp >= 1) ? stack[sp - 1] : 0;
+
+		switch ( c->op ) {
+			case OP_CONST:
+				stack[sp++] = c->value;
+				continue;
+			case OP_FIELD: {
+				const where_field_t* f = &w->fields[c->value];
+				uint64_t v = 0;
+				if ( w->data_bits > 0 ) {
+					if ( bits_unpack( memory->data, memory->size, w->data_bits, w->lsb_first, f->offset, 1, &v ) == 0 ) {
+						return false;
+					}
+				} else if ( f->offset + f->size > memory->size ) {
+					return false;
+				} else if ( f->decode != NULL ) {
+					v = f->decode( &memory->data[f->offset] );
+				} else {
+					size_t j;
+					for ( j = 0; j < f->size; j++ ) {
+						v = (v << 8) | memory->data[f->offset + j];
+					}
+				}
+				stack[sp++] = (f->shift > 0) ? ((int64_t)(v << f->shift)) >> f->shift : (int64_t)v;
+				continue;
+			}
+			case OP_BYTE:
+				if ( (size_t)c->value >= memory->size ) {
+					return false;
+				}
+				stack[sp++] = (int64_t)memory->data[c->value];
+				continue;
+			case OP_ADDR:
+				stack[sp++] = (int64_t)memory->address;
+				continue;
+
+			/* unary */
+			case OP_NEG: stack[sp - 1] = (int64_t)(0 - (uint64_t)r); continue;
+			case OP_NOT: stack[sp - 1] = (r == 0); continue;
+			case OP_INV: stack[sp - 1] = ~r; continue;
+
+			/* binary */
+			case OP_MUL:  l = (int64_t)((uint64_t)l * (uint64_t)r); break;
+			case OP_DIV:  l = (r == 0 || (r == -1 && l == INT64_MIN)) ? 0 : l / r; break;
+			case OP_MOD:  l = (r == 0 || r == -1) ? 0 : l % r; break;
+			case OP_ADD:  l = (int64_t)((uint64_t)l + (uint64_t)r); break;
+			case OP_SUB:  l = (int64_t)((uint64_t)l - (uint64_t)r); break;
+			case OP_SHL:  l = (int64_t)((uint64_t)l << (r & 63)); break;
+			case OP_SHR:  l = l >> (r & 63); break;
+			case OP_LT:   l = (l <  r); break;
+			case OP_LE:   l = (l <= r); break;
+			case OP_GT:   l = (l >  r); break;
+			case OP_GE:   l = (l >= r); break;
+			case OP_EQ:   l = (l == r); break;
+			case OP_NE:   l = (l != r); break;
+			case OP_AND:  l = l & r; break;
+			case OP_XOR:  l = l ^ r; break;
+			case OP_OR:   l = l | r; break;
+			case OP_LAND: l = (l != 0 && r != 0); break;
+			case OP_LOR:  l = (l != 0 || r != 0); break;
+		}
+		stack[sp - 2] = l;
+		sp--;
+	}
+	*result = stack[0];
+	return true;
+}
+
+/*!
+ * @brief compile the expression of --where.
+ * @param[in] opt the fields of the row, after the defaults are set.
+ * @param[in] expr expression.
+ * @return compiled predicate, NULL on failure.
+ */
+where_t* where_compile( const options_t* opt, const char* expr )
+{
+	where_parser_t ps;
+
+	ps.expr  = expr;
+	ps.p     = expr;
+	ps.opt   = opt;
+	ps.depth = 0;
+	ps.is    = true;
+	ps.w     = (where_t*)calloc( 1, sizeof(where_t) );
+	if ( ps.w == NULL ) {
+		(void)verbose_printf( VERB_ERR, "Error: memory allocation failure\n" );
+		return NULL;
+	}
+	ps.w->data_bits = opt->data_bits;
+	ps.w->lsb_first = opt->lsb_first;
+
+	where_expr( &ps );
+	where_space( &ps );
+	if ( ps.is == true && *ps.p != '\0' ) {
+		where_error( &ps, "wrong expression" );
+	}
+	if ( ps.is == false ) {
+		where_free( ps.w );
+		return NULL;
+	}
+	(void)verbose_printf( VERB_LOG, "bldump: where - %d codes, %d fields\n", ps.w->ncode, ps.w->nfields );
+	return ps.w;
+}
+
+/*!
+ * @brief check the row matches the predicate.
+ * @param[in] where compiled predicate.
+ * @param[in] memory row read by bldump_read().
+ * @retval true the row is written.
+ * @retval false the row is rejected.
+ */
+bool where_match( const where_t* where, const memory_t* memory )
+{
+	int64_t result;
+	return where_eval( where->code, where->ncode, where, memory, &result ) == true && result != 0;
+}
+
+/*!
+ * @brief free the compiled predicate.
+ */
+void where_free( where_t* where )
+{
+	free( where->code );
+	free( where->fields );
+	free( where );
+}